@@ -0,0 +1,203 @@
+/**
+  * Micro-benchmark harness.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CommandLineFlags.h"
+#include "LogAndCheck.h"
+#include "Profiler.h"
+#include "StringUtils.h"
+
+DEFINE_FLAG_double(bench_warmup_time, xyUtils::BenchmarkOpts().warmupTime,
+                   "Warm-up time of each benchmark, in seconds.");
+DEFINE_FLAG_double(bench_min_rep_time, xyUtils::BenchmarkOpts().minRepTime,
+                   "Minimum time of each benchmark repetition, in seconds.");
+DEFINE_FLAG_int(bench_repetitions, xyUtils::BenchmarkOpts().repetitions,
+                "Number of timed repetitions of each benchmark.");
+DEFINE_FLAG_string(bench_filter, "",
+                   "Only run benchmarks whose names contain this string.");
+DEFINE_FLAG_string(bench_json, "",
+                   "Write the benchmark results to this JSON file.");
+
+namespace xyUtils  {
+
+namespace {
+// Run 'body' 'iters' times and return the elapsed seconds.
+double TimeIterations(const BenchmarkBody& body, int iters) {
+  int64_t start = ProfilerNow();
+  for (int i = 0; i < iters; ++i)   body();
+  return (ProfilerNow() - start) * 1e-9;
+}
+
+// Format a rate with a metric prefix, e.g. "12.3 M".
+std::string MetricPrefix(double value) {
+  const char* prefixes[] = {"", "k", "M", "G", "T"};
+  int p = 0;
+  while (value >= 1000.0 && p < 4) {
+    value /= 1000.0;
+    ++p;
+  }
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(3) << value << " " << prefixes[p];
+  return oss.str();
+}
+
+std::string Str(int value) {
+  std::ostringstream oss;
+  oss << value;
+  return oss.str();
+}
+
+// Format seconds with a suitable unit.
+std::string FormatTime(double t) {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(3);
+  if (t < 1e-6) {
+    oss << t * 1e9 << " ns";
+  } else if (t < 1e-3) {
+    oss << t * 1e6 << " us";
+  } else if (t < 1.0) {
+    oss << t * 1e3 << " ms";
+  } else {
+    oss << t << " s";
+  }
+  return oss.str();
+}
+}   // namespace
+
+BenchmarkResult RunBenchmark(const char* name, const BenchmarkBody& body,
+                             const BenchmarkOpts& opts, double bytesPerIter,
+                             double itemsPerIter) {
+  CHECK_GT(opts.repetitions, 0);
+  CHECK_GT(opts.maxItersPerRep, 0);
+  // Warm up, which also gives a first estimate of the time per iteration.
+  int warmupIters = 0;
+  double warmupElapsed = 0.0;
+  do {
+    warmupElapsed += TimeIterations(body, 1);
+    ++warmupIters;
+  } while (warmupElapsed < opts.warmupTime);
+  double estimate = warmupElapsed / warmupIters;
+  // Calibrate the number of iterations per repetition.
+  int iters = 1;
+  if (estimate * opts.maxItersPerRep < opts.minRepTime) {
+    iters = opts.maxItersPerRep;
+  } else if (estimate < opts.minRepTime) {
+    iters = std::min(opts.maxItersPerRep,
+                     int(std::ceil(opts.minRepTime / std::max(estimate, 1e-9))));
+  }
+  // Timed repetitions.
+  std::vector<double> times(opts.repetitions);
+  for (int r = 0; r < opts.repetitions; ++r) {
+    times[r] = TimeIterations(body, iters) / iters;
+  }
+  // Statistics.
+  BenchmarkResult result;
+  result.name = name;
+  result.repetitions = opts.repetitions;
+  result.itersPerRep = iters;
+  double sum = 0.0, sum2 = 0.0;
+  for (int r = 0; r < opts.repetitions; ++r) {
+    sum += times[r];
+    sum2 += times[r] * times[r];
+  }
+  int n = opts.repetitions;
+  result.mean = sum / n;
+  result.stddev = n > 1 ?
+      std::sqrt(std::max(0.0, (sum2 - sum * result.mean) / (n - 1))) : 0.0;
+  std::sort(times.begin(), times.end());
+  result.min = times.front();
+  result.max = times.back();
+  result.median = n % 2 ? times[n/2] : (times[n/2 - 1] + times[n/2]) / 2;
+  result.bytesPerSecond = bytesPerIter > 0 ? bytesPerIter / result.median : 0;
+  result.itemsPerSecond = itemsPerIter > 0 ? itemsPerIter / result.median : 0;
+  return result;
+}
+
+void PrintBenchmarkResults(const std::vector<BenchmarkResult>& results) {
+  std::ostringstream table;
+  table << std::left << std::setw(36) << "Benchmark" << std::right
+        << std::setw(14) << "Median" << std::setw(14) << "Mean"
+        << std::setw(10) << "CV (%)" << std::setw(12) << "Iters"
+        << std::setw(16) << "Bytes/s" << std::setw(16) << "Items/s" << "\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchmarkResult& r = results[i];
+    double cv = r.mean > 0 ? r.stddev / r.mean * 100 : 0.0;
+    table << std::left << std::setw(36) << r.name << std::right
+          << std::setw(14) << FormatTime(r.median)
+          << std::setw(14) << FormatTime(r.mean)
+          << std::setw(10) << std::fixed << std::setprecision(2) << cv
+          << std::setw(12) << (Str(r.itersPerRep) + "x" + Str(r.repetitions))
+          << std::setw(16) << (r.bytesPerSecond > 0 ?
+                               MetricPrefix(r.bytesPerSecond) + "B" : "-")
+          << std::setw(16) << (r.itemsPerSecond > 0 ?
+                               MetricPrefix(r.itemsPerSecond) : "-")
+          << "\n";
+  }
+  LOG(PLAIN) << table.str();
+}
+
+void WriteBenchmarkResultsJson(const char* suite,
+                               const std::vector<BenchmarkResult>& results,
+                               FILE* fp) {
+  fprintf(fp, "{\n  \"suite\": ");
+  fputs(StringUtils::JsonQuote(suite).c_str(), fp);
+  fprintf(fp, ",\n  \"benchmarks\": [");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchmarkResult& r = results[i];
+    fprintf(fp, "%s\n    {\"name\": ", i ? "," : "");
+    fputs(StringUtils::JsonQuote(r.name).c_str(), fp);
+    fprintf(fp, ", \"repetitions\": %d, \"iters_per_rep\": %d, "
+            "\"mean\": %.9g, \"stddev\": %.9g, \"min\": %.9g, "
+            "\"median\": %.9g, \"max\": %.9g, \"bytes_per_second\": %.9g, "
+            "\"items_per_second\": %.9g}",
+            r.repetitions, r.itersPerRep, r.mean, r.stddev, r.min, r.median,
+            r.max, r.bytesPerSecond, r.itemsPerSecond);
+  }
+  fprintf(fp, "\n  ]\n}\n");
+}
+
+BenchmarkSuite::BenchmarkSuite(const char* name)
+    : name_(name), opts_(), filter_(FLAGS_bench_filter),
+      jsonFile_(FLAGS_bench_json), results_() {
+  opts_.warmupTime = FLAGS_bench_warmup_time;
+  opts_.minRepTime = FLAGS_bench_min_rep_time;
+  opts_.repetitions = FLAGS_bench_repetitions;
+}
+
+bool BenchmarkSuite::Run(const char* name, const BenchmarkBody& body,
+                         double bytesPerIter, double itemsPerIter) {
+  if (!filter_.empty() && std::string(name).find(filter_) == std::string::npos) {
+    return false;
+  }
+  results_.push_back(RunBenchmark(name, body, opts_, bytesPerIter,
+                                  itemsPerIter));
+  return true;
+}
+
+void BenchmarkSuite::Finish() const {
+  LOG(PLAIN) << "Benchmark suite '" << name_ << "':\n";
+  PrintBenchmarkResults(results_);
+  if (!jsonFile_.empty()) {
+    FILE* fp = fopen(jsonFile_.c_str(), "w");
+    if (!fp) {
+      LOG(FATAL) << "Cannot open file \"" << jsonFile_ << "\" for writing.";
+    }
+    WriteBenchmarkResultsJson(name_.c_str(), results_, fp);
+    fclose(fp);
+  }
+}
+
+}   // namespace xyUtils
@@ -0,0 +1,109 @@
+/**
+  * Micro-benchmark harness, with warm-up, repetitions, statistical summary,
+  * throughput and JSON output.
+  *
+  * Example usage (see the *Bench.cc files):
+  *   int main(int argc, char** argv) {
+  *     xyUtils::CommandLineFlagsInit(&argc, &argv, true);
+  *     xyUtils::BenchmarkSuite suite("MySuite");
+  *     suite.Run("Parse", [&]() { Parse(text); }, text.size());
+  *     suite.Finish();   // Print a table, and write JSON if '--bench_json'.
+  *   }
+  *
+  * Each benchmark is first run for at least 'warmupTime' seconds. Then the
+  * number of iterations per repetition is calibrated such that a repetition
+  * takes at least 'minRepTime' seconds, and 'repetitions' repetitions are
+  * timed. The statistics are over the per-iteration times of the repetitions.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#ifndef __XYUTILS_BENCHMARK_H__
+#define __XYUTILS_BENCHMARK_H__
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace xyUtils  {
+
+// The code to be benchmarked, i.e. one iteration.
+typedef std::function<void()> BenchmarkBody;
+
+struct BenchmarkOpts {
+  // Constructor that sets default values.
+  BenchmarkOpts() :
+      warmupTime(0.1), minRepTime(0.05), repetitions(10), maxItersPerRep(1000000)
+  { }
+
+  double warmupTime;        // In seconds.
+  double minRepTime;        // In seconds.
+  int repetitions;
+  int maxItersPerRep;
+};
+
+// Times are in seconds per iteration. Throughputs are zero if the amount of
+// work per iteration is not given.
+struct BenchmarkResult {
+  std::string name;
+  int repetitions;
+  int itersPerRep;
+  double mean;
+  double stddev;
+  double min;
+  double median;
+  double max;
+  double bytesPerSecond;    // Based on the median.
+  double itemsPerSecond;    // Based on the median.
+};
+
+// Run 'body' as described above, where one iteration processes 'bytesPerIter'
+// bytes and 'itemsPerIter' items (both optional).
+BenchmarkResult RunBenchmark(const char* name, const BenchmarkBody& body,
+                             const BenchmarkOpts& opts,
+                             double bytesPerIter = 0.0,
+                             double itemsPerIter = 0.0);
+
+// Print 'results' as a table.
+void PrintBenchmarkResults(const std::vector<BenchmarkResult>& results);
+
+// Write 'results' of 'suite' as a JSON object to 'fp'.
+void WriteBenchmarkResultsJson(const char* suite,
+                               const std::vector<BenchmarkResult>& results,
+                               FILE* fp);
+
+// A set of benchmarks sharing the options given by the command line flags
+// '--bench_warmup_time', '--bench_min_rep_time', '--bench_repetitions',
+// '--bench_filter' (only run benchmarks whose names contain it) and
+// '--bench_json' (output file, or empty for no output).
+class BenchmarkSuite {
+ public:
+  explicit BenchmarkSuite(const char* name);
+  // Run the benchmark and append its result to 'results()', or return false
+  // if filtered out.
+  bool Run(const char* name, const BenchmarkBody& body,
+           double bytesPerIter = 0.0, double itemsPerIter = 0.0);
+  // Print the results, and write them to the JSON file if required.
+  void Finish() const;
+
+  const std::vector<BenchmarkResult>& results() const { return results_; }
+  BenchmarkOpts& opts() { return opts_; }
+ private:
+  std::string name_;
+  BenchmarkOpts opts_;
+  std::string filter_;
+  std::string jsonFile_;
+  std::vector<BenchmarkResult> results_;
+};
+
+// Prevent the compiler from optimizing away the computation of 'value'.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r"(&value) : "memory");
+}
+
+}   // namespace xyUtils
+
+#endif   // __XYUTILS_BENCHMARK_H__
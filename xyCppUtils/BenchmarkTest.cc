@@ -0,0 +1,83 @@
+/**
+  * Test for benchmark harness.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "FileIO.h"
+#include "LogAndCheck.h"
+#include "Timer.h"
+
+using namespace std;
+using namespace xyUtils;
+
+int main()  {
+  Timer timer;
+  LOG(INFO) << "Test on Benchmark ...";
+
+  BenchmarkOpts opts;
+  opts.warmupTime = 0.01;
+  opts.minRepTime = 0.005;
+  opts.repetitions = 5;
+
+  // A body of known duration runs once per repetition.
+  int numCalls = 0;
+  BenchmarkResult sleepResult = RunBenchmark("Sleep", [&]() {
+      Timer::sleep(0.01);
+      ++numCalls;
+    }, opts, 1000.0, 10.0);
+  CHECK_EQ(sleepResult.name, "Sleep");
+  CHECK_EQ(sleepResult.repetitions, 5);
+  CHECK_EQ(sleepResult.itersPerRep, 1);
+  CHECK_EQ(numCalls, 1 + 5);
+  CHECK_GE(sleepResult.min, 0.01);
+  CHECK_LE(sleepResult.min, sleepResult.median);
+  CHECK_LE(sleepResult.median, sleepResult.max);
+  CHECK_LE(sleepResult.min, sleepResult.mean);
+  CHECK_LE(sleepResult.mean, sleepResult.max);
+  CHECK_GE(sleepResult.stddev, 0.0);
+  CHECK_NEAR(sleepResult.bytesPerSecond, 1000.0 / sleepResult.median, 1e-6);
+  CHECK_NEAR(sleepResult.itemsPerSecond, 10.0 / sleepResult.median, 1e-6);
+
+  // A cheap body is calibrated to many iterations per repetition, capped by
+  // 'maxItersPerRep'.
+  double sum = 0.0;
+  opts.maxItersPerRep = 1000;
+  BenchmarkResult cheapResult = RunBenchmark("Cheap", [&]() {
+      sum += 1.0;
+      DoNotOptimize(sum);
+    }, opts);
+  CHECK_EQ(cheapResult.itersPerRep, 1000);
+  CHECK_LT(cheapResult.median, 1e-3);
+  CHECK_EQ(cheapResult.bytesPerSecond, 0.0);
+  CHECK_EQ(cheapResult.itemsPerSecond, 0.0);
+
+  // Table and JSON output.
+  vector<BenchmarkResult> results;
+  results.push_back(sleepResult);
+  results.push_back(cheapResult);
+  results[1].name = "Cheap \"quoted\"";
+  PrintBenchmarkResults(results);
+  const char* jsonFile = "/tmp/xyUtils_BenchmarkTest.json";
+  FILE* fp = fopen(jsonFile, "w");
+  CHECK(fp);
+  WriteBenchmarkResultsJson("Test", results, fp);
+  fclose(fp);
+  string json = FileIO::ReadWholeFileToString(jsonFile);
+  remove(jsonFile);
+  CHECK_EQ(json.find("{\n  \"suite\": \"Test\""), 0u);
+  CHECK(json.find("{\"name\": \"Sleep\", \"repetitions\": 5, "
+                  "\"iters_per_rep\": 1,") != string::npos);
+  CHECK(json.find("\"Cheap \\\"quoted\\\"\"") != string::npos);
+  CHECK(json.find("\"iters_per_rep\": 1000,") != string::npos);
+
+  LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
+  return 0;
+}
@@ -7,28 +7,158 @@
 
 #include "Camera.h"
 
-#include <cctype>
 #include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Dense>
 
+#include "FileIO.h"
 #include "LogAndCheck.h"
+#include "StringConvert.h"
+#include "StringUtils.h"
+#include "StringView.h"
+#include "ThreadPool.h"
 
 using namespace std;
 using namespace Eigen;
 namespace xyUtils  {
 namespace {
-// Helper function to read 'n' doubles from file 'fp', and put the results in
-// array 'r'. The user needs to pre-allocate memory for 'r'.
-void ReadNDoublesFromFile(int n, FILE* fp, double* r) {
-  for (int i = 0; i < n; ++i) {
-    int nRead = fscanf(fp, "%lf", r+i);
-    CHECK_EQ(nRead, 1);
+// Number of parameters of a camera, K(9), R(9) and t(3).
+const int kNumParams = 21;
+
+// Text files larger than this are parsed by several threads, in chunks of about
+// this size.
+const size_t kParallelChunkBytes = 1 << 20;
+
+const char kRigMagic[8] = {'X', 'Y', 'C', 'A', 'M', 'R', 'I', 'G'};
+const uint32_t kRigVersion = 1;
+const size_t kRigHeaderSize = 32;
+
+// Line number (from 1) of the position 'p' in 'text'.
+int LineNumber(StringView text, const char* p) {
+  int n = 1;
+  for (const char* q = text.begin(); q < p; ++q) {
+    q = static_cast<const char*>(memchr(q, '\n', p - q));
+    if (!q)   break;
+    ++n;
   }
+  return n;
+}
+
+// The cameras of a chunk of a text file.
+struct CameraChunk {
+  vector<StringView> names;
+  vector<double> params;      // 'kNumParams' for each camera.
+};
+
+// Parse the lines "Name K11 ... t3" in [begin, end) of 'text', the content of
+// 'filename', skipping blank lines.
+void ParseNameKRt(const char* filename, StringView text, const char* begin,
+                  const char* end, CameraChunk* chunk) {
+  FileIO::LineIterator lines(begin, end - begin);
+  StringView line;
+  while (lines.Next(&line)) {
+    StringUtils::Tokenizer tokenizer(line);
+    StringView token;
+    if (!tokenizer.Next(&token))   continue;
+    chunk->names.push_back(token);
+    int n = 0;
+    double value;
+    while (tokenizer.Next(&token)) {
+      if (n == kNumParams ||
+          StringConvert::ToDouble(token.data(), token.size(), &value) !=
+          StringConvert::Success) {
+        n = -1;
+        break;
+      }
+      chunk->params.push_back(value);
+      ++n;
+    }
+    if (n != kNumParams) {
+      LOG(FATAL) << filename << ":" << LineNumber(text, line.begin())
+                 << ": expected a name and " << kNumParams
+                 << " numbers for a camera, got \"" << line << "\".";
+    }
+  }
+}
+
+// Parse 'body' of 'text' in "NameKRt" format, in parallel if it is large, and
+// append the cameras to 'rig'.
+void ParseNameKRt(const char* filename, StringView text, StringView body,
+                  CameraRig* rig) {
+  vector<const char*> bounds =
+      FileIO::SplitIntoLineChunks(body, kParallelChunkBytes);
+  int numChunks = bounds.size() - 1;
+  vector<CameraChunk> chunks(numChunks);
+  ParallelFor(0, numChunks, 1, [&](int begin, int end) {
+      for (int c = begin; c < end; ++c) {
+        ParseNameKRt(filename, text, bounds[c], bounds[c+1], &chunks[c]);
+      }
+    });
+  size_t total = rig->size();
+  for (int c = 0; c < numChunks; ++c)   total += chunks[c].names.size();
+  rig->Reserve(total);
+  for (int c = 0; c < numChunks; ++c) {
+    const double* p = chunks[c].params.data();
+    for (size_t i = 0; i < chunks[c].names.size(); ++i, p += kNumParams) {
+      rig->Add(chunks[c].names[i].ToString(), Camera(p, p + 9, p + 18));
+    }
+  }
+}
+
+// Parse 'text' of "NumNameKRt" format, and append the cameras to 'rig'.
+void ParseNumNameKRt(const char* filename, StringView text, CameraRig* rig) {
+  FileIO::LineIterator lines(text);
+  StringView line;
+  while (lines.Next(&line) && StringUtils::StripWhiteSpace(line).empty()) ;
+  int nCams = 0;
+  StringView num = StringUtils::StripWhiteSpace(line);
+  if (StringConvert::ToInt(num.data(), num.size(), &nCams) !=
+      StringConvert::Success || nCams < 0) {
+    LOG(FATAL) << filename << ":" << lines.lineNumber()
+               << ": expected the number of cameras, got \"" << line << "\".";
+  }
+  int first = rig->size();
+  ParseNameKRt(filename, text, lines.rest(), rig);
+  if (rig->size() - first != nCams) {
+    LOG(FATAL) << filename << ": expected " << nCams << " cameras, got "
+               << rig->size() - first << ".";
+  }
+}
+
+// Parse 'text' of the text 'format'.
+CameraRig ParseCameraRig(const char* filename, StringView text,
+                         const char* format) {
+  CameraRig rig;
+  if (strcmp(format, "NameKRt") == 0) {
+    ParseNameKRt(filename, text, text, &rig);
+  } else if (strcmp(format, "NumNameKRt") == 0) {
+    ParseNumNameKRt(filename, text, &rig);
+  } else {
+    LOG(FATAL) << "Unknown camera file format \"" << format << "\".";
+  }
+  return rig;
+}
+
+// The FNV-1a hash of 'str'.
+uint64_t HashName(StringView str) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < str.size(); ++i) {
+    hash = (hash ^ static_cast<unsigned char>(str[i])) * 0x100000001b3ULL;
+  }
+  return hash;
 }
-}  // namespace
 
+template <typename T>
+T LoadUnaligned(const char* p) {
+  T value;
+  memcpy(&value, p, sizeof(T));
+  return value;
+}
+}  // namespace
 Camera::Camera(const double* K, const double* R, const double* t) {
   SetKRt(K, R, t);
 }
@@ -51,46 +181,161 @@ Vector3d Camera::backProjRay(double* x) const {
   return ray.normalized();
 }
 
-vector<Camera> ReadCamerasFromFile(const char* filename, const char* format) {
-  vector<Camera> cameras;
-  FILE* fp = fopen(filename, "r");
-  CHECK(fp);
-  if (strcmp(format, "NameKRt") == 0) {
-    cameras = ReadCamerasFromFile_NameKRt(fp);
-  } else if (strcmp(format, "NumNameKRt") == 0) {
-    cameras = ReadCamerasFromFile_NumNameKRt(fp);
-  } else {
-    LOG(FATAL) << "Unknown camera file format.";
+void CameraRig::Add(const string& name, const Camera& camera) {
+  index_.insert(make_pair(name, int(cameras_.size())));
+  cameras_.push_back(camera);
+  names_.push_back(name);
+}
+
+void CameraRig::Reserve(int n) {
+  cameras_.reserve(n);
+  names_.reserve(n);
+  index_.rehash(n);
+}
+
+int CameraRig::Find(const string& name) const {
+  auto it = index_.find(name);
+  return it == index_.end() ? -1 : it->second;
+}
+
+CameraRig ReadCameraRigFromFile(const char* filename, const char* format) {
+  if (strcmp(format, "Binary") == 0) {
+    return MappedCameraRig(filename).ToCameraRig();
   }
-  fclose(fp);
-  return cameras;
+  FileIO::MappedFile file(filename);
+  return ParseCameraRig(filename, file.view(), format);
+}
+
+vector<Camera> ReadCamerasFromFile(const char* filename, const char* format) {
+  return ReadCameraRigFromFile(filename, format).cameras();
 }
 
 vector<Camera> ReadCamerasFromFile_NameKRt(FILE* fp) {
-  vector<Camera> cameras;
-  while (1) {
-    // Skip the 'name'.
-    while (!feof(fp) && isspace(fgetc(fp))) ;
-    while (!feof(fp) && !isspace(fgetc(fp))) ;
-    if (feof(fp)) break;
-    // Read actual parameters.
-    double K[9];
-    ReadNDoublesFromFile(9, fp, K);
-    double R[9];
-    ReadNDoublesFromFile(9, fp, R);
-    double t[3];
-    ReadNDoublesFromFile(3, fp, t);
-    cameras.push_back(Camera(K, R, t));
-  }
-  return cameras;
+  string text;
+  FileIO::ReadRestOfFile(fp, &text);
+  return ParseCameraRig("<file>", text, "NameKRt").cameras();
 }
 
 vector<Camera> ReadCamerasFromFile_NumNameKRt(FILE* fp) {
-  int nCams;
-  int nRead = fscanf(fp, "%d", &nCams);
-  CHECK_EQ(nRead, 1);
-  vector<Camera> cameras = ReadCamerasFromFile_NameKRt(fp);
-  CHECK_EQ(int(cameras.size()), nCams);
-  return cameras;
+  string text;
+  FileIO::ReadRestOfFile(fp, &text);
+  return ParseCameraRig("<file>", text, "NumNameKRt").cameras();
+}
+
+void WriteCameraRigToBinaryFile(const char* filename, const CameraRig& rig) {
+  uint32_t n = rig.size();
+  uint32_t hashSize = 1;
+  while (hashSize < 2 * n)   hashSize *= 2;
+  vector<uint64_t> nameOffsets(n + 1, 0);
+  vector<uint32_t> hash(hashSize, 0);
+  for (uint32_t i = 0; i < n; ++i) {
+    nameOffsets[i+1] = nameOffsets[i] + rig.name(i).size();
+    // Only the first camera of a name is in the table.
+    if (rig.Find(rig.name(i)) != int(i))   continue;
+    uint32_t slot = HashName(rig.name(i)) & (hashSize - 1);
+    while (hash[slot] != 0)   slot = (slot + 1) & (hashSize - 1);
+    hash[slot] = i + 1;
+  }
+
+  FileIO::BinaryWriter writer(filename, FileIO::LittleEndian);
+  writer.WriteBytes(kRigMagic, sizeof(kRigMagic));
+  writer.Write(kRigVersion);
+  writer.Write(n);
+  writer.Write(hashSize);
+  writer.Write(uint32_t(0));
+  writer.Write(nameOffsets[n]);
+  for (uint32_t i = 0; i < n; ++i) {
+    const Camera& camera = rig.camera(i);
+    writer.Write(camera.K().data(), 9);
+    writer.Write(camera.R().data(), 9);
+    writer.Write(camera.t().data(), 3);
+  }
+  writer.Write(nameOffsets.data(), nameOffsets.size());
+  writer.Write(hash.data(), hash.size());
+  for (uint32_t i = 0; i < n; ++i) {
+    writer.WriteBytes(rig.name(i).data(), rig.name(i).size());
+  }
+}
+
+MappedCameraRig::MappedCameraRig(const char* filename)
+    : file_(filename, FileIO::MappedFile::RandomAccess) {
+  if (FileIO::NativeByteOrder() != FileIO::LittleEndian) {
+    LOG(FATAL) << "Could not map the little endian camera rig file "
+               << filename << " on a big endian machine.";
+  }
+  const char* data = file_.data();
+  if (file_.size() < kRigHeaderSize ||
+      memcmp(data, kRigMagic, sizeof(kRigMagic)) != 0) {
+    LOG(FATAL) << filename << " is not a camera rig file.";
+  }
+  uint32_t version = LoadUnaligned<uint32_t>(data + 8);
+  if (version != kRigVersion) {
+    LOG(FATAL) << "Unsupported version " << version << " of camera rig file "
+               << filename << ".";
+  }
+  uint32_t n = LoadUnaligned<uint32_t>(data + 12);
+  hashSize_ = LoadUnaligned<uint32_t>(data + 16);
+  uint64_t namesSize = LoadUnaligned<uint64_t>(data + 24);
+  uint64_t expectedSize = kRigHeaderSize + uint64_t(n) * kNumParams * 8 +
+      (uint64_t(n) + 1) * 8 + uint64_t(hashSize_) * 4 + namesSize;
+  if (n > 0x7fffffff || hashSize_ < 2 * uint64_t(n) || hashSize_ == 0 ||
+      (hashSize_ & (hashSize_ - 1)) != 0 || file_.size() != expectedSize) {
+    LOG(FATAL) << "Corrupted camera rig file " << filename << ".";
+  }
+  size_ = n;
+  params_ = reinterpret_cast<const double*>(data + kRigHeaderSize);
+  nameOffsets_ = data + kRigHeaderSize + size_t(n) * kNumParams * 8;
+  hash_ = nameOffsets_ + (size_t(n) + 1) * 8;
+  names_ = hash_ + size_t(hashSize_) * 4;
+  // Validate the tables once, so that lookups need no checks.
+  for (int i = 0; i < size_; ++i) {
+    if (NameOffset(i) > NameOffset(i+1)) {
+      LOG(FATAL) << "Corrupted camera rig file " << filename << ".";
+    }
+  }
+  // Find() probes until an empty slot, so the table must keep at least one,
+  // and holds at most one entry per camera.
+  uint64_t numEntries = 0;
+  for (uint32_t slot = 0; slot < hashSize_; ++slot) {
+    uint32_t entry = LoadUnaligned<uint32_t>(hash_ + 4 * size_t(slot));
+    if (entry > n) {
+      LOG(FATAL) << "Corrupted camera rig file " << filename << ".";
+    }
+    if (entry != 0)   ++numEntries;
+  }
+  if (numEntries > n || numEntries > hashSize_ - 1) {
+    LOG(FATAL) << "Corrupted camera rig file " << filename << ".";
+  }
+  if (NameOffset(0) != 0 || NameOffset(size_) != namesSize) {
+    LOG(FATAL) << "Corrupted camera rig file " << filename << ".";
+  }
+}
+
+uint64_t MappedCameraRig::NameOffset(int i) const {
+  return LoadUnaligned<uint64_t>(nameOffsets_ + 8 * size_t(i));
+}
+
+Camera MappedCameraRig::camera(int i) const {
+  const double* p = params_ + kNumParams * size_t(i);
+  return Camera(p, p + 9, p + 18);
+}
+
+int MappedCameraRig::Find(StringView name) const {
+  // The constructor checked that the table has an empty slot, so the probing
+  // ends.
+  uint32_t slot = HashName(name) & (hashSize_ - 1);
+  while (true) {
+    uint32_t entry = LoadUnaligned<uint32_t>(hash_ + 4 * size_t(slot));
+    if (entry == 0)   return -1;
+    if (this->name(entry - 1) == name)   return entry - 1;
+    slot = (slot + 1) & (hashSize_ - 1);
+  }
+}
+
+CameraRig MappedCameraRig::ToCameraRig() const {
+  CameraRig rig;
+  rig.Reserve(size_);
+  for (int i = 0; i < size_; ++i)   rig.Add(name(i).ToString(), camera(i));
+  return rig;
 }
 }   // namespace xyUtils
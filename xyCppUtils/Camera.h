@@ -8,10 +8,20 @@
 #ifndef __XYUTILS_CAMERA_H__
 #define __XYUTILS_CAMERA_H__
 
+#include <string>
 #include <vector>
+#ifdef __USE_TR1__
+#include <tr1/cstdint>
+#include <tr1/unordered_map>
+#else
+#include <cstdint>
+#include <unordered_map>
+#endif
 #include <Eigen/Core>
 
 #include "EigenUtils.h"
+#include "FileIO.h"
+#include "StringView.h"
 
 namespace xyUtils  {
 class Camera {
@@ -21,6 +31,10 @@ class Camera {
   Camera(const double* K, const double* R, const double* t);
   // Set parameters by C arrays.
   void SetKRt(const double* K, const double* R, const double* t);
+  // Camera parameters.
+  const EigenUtils::rMatrix3d& K() const { return K_; }
+  const EigenUtils::rMatrix3d& R() const { return R_; }
+  const Eigen::Vector3d& t() const { return t_; }
   // Compute and return the camera center.
   Eigen::Vector3d center() const;
   // Compute the back projection ray of image point 'x'. The input 'x' is a
@@ -34,6 +48,33 @@ class Camera {
   Eigen::Vector3d t_;
 };
 
+// A set of named cameras, e.g. the frames of a video, with the lookup of a
+// camera by its name in constant time. If several cameras have the same name,
+// the name refers to the first of them.
+class CameraRig {
+ public:
+  CameraRig() { }
+
+  void Add(const std::string& name, const Camera& camera);
+  void Reserve(int n);
+
+  int size() const { return cameras_.size(); }
+  const Camera& camera(int i) const { return cameras_[i]; }
+  const std::string& name(int i) const { return names_[i]; }
+  const std::vector<Camera>& cameras() const { return cameras_; }
+  const std::vector<std::string>& names() const { return names_; }
+  // Index of the camera named 'name', or -1 if there is none.
+  int Find(const std::string& name) const;
+ private:
+  std::vector<Camera> cameras_;
+  std::vector<std::string> names_;
+#ifdef __USE_TR1__
+  std::tr1::unordered_map<std::string, int> index_;
+#else
+  std::unordered_map<std::string, int> index_;
+#endif
+};
+
 // Read a set of cameras from a file 'filename' of specified 'format'.
 // Following 'format' are supported:
 // --"NameKRt"
@@ -45,9 +86,78 @@ class Camera {
 //   Name1 K11 K12 ... K33 R11 R12 ... R33 t1 t2 t3
 //   Name2 K11 K12 ... K33 R11 R12 ... R33 t1 t2 t3
 //   ......
+// --"Binary"
+//   The binary format of 'MappedCameraRig'.
+// In the text formats, each camera is on a line of its own, and blank lines
+// are skipped. Large text files are memory mapped and parsed by several
+// threads. Any error is a LOG(FATAL) with the line number.
+CameraRig ReadCameraRigFromFile(const char* filename, const char* format);
 std::vector<Camera> ReadCamerasFromFile(const char* filename, const char* format);
 std::vector<Camera> ReadCamerasFromFile_NameKRt(FILE* fp);
 std::vector<Camera> ReadCamerasFromFile_NumNameKRt(FILE* fp);
+
+// Write the cameras of 'rig' to a file 'filename' in the binary format of
+// 'MappedCameraRig'.
+void WriteCameraRigToBinaryFile(const char* filename, const CameraRig& rig);
+
+// A camera rig in a binary file, memory mapped such that nothing is read or
+// copied up front: the parameters are viewed in place, and the name lookup
+// uses a hash table stored in the file. Example usage:
+//   WriteCameraRigToBinaryFile("rig.bin", rig);
+//   MappedCameraRig mapped("rig.bin");
+//   int i = mapped.Find("frame00042.png");
+//   Eigen::Vector3d t = mapped.t(i);
+// The file consists of, in little endian:
+//   char[8]   "XYCAMRIG"
+//   uint32    version, which is 1
+//   uint32    n, the number of cameras
+//   uint32    h, the size of the hash table, a power of 2 (at least 2n)
+//   uint32    0
+//   uint64    the size of the names in bytes
+//   double    K(9), R(9) and t(3) of each camera, row-major, 21n in total
+//   uint64    n+1 offsets of the names, such that name i is between the
+//             offsets i and i+1
+//   uint32    h hash table entries, 0 for empty or a camera index plus 1 at
+//             the first free slot from the FNV-1a hash of its name, modulo h
+//   char      the names, without terminating null characters
+class MappedCameraRig {
+ public:
+  typedef Eigen::Map<const EigenUtils::rMatrix3d> Matrix3dMap;
+  typedef Eigen::Map<const Eigen::Vector3d> Vector3dMap;
+
+  // Open 'filename', or LOG(FATAL) if it is not a valid camera rig file.
+  explicit MappedCameraRig(const char* filename);
+  explicit MappedCameraRig(const std::string& filename)
+      : MappedCameraRig(filename.c_str()) { }
+
+  // Valid as long as this object is alive.
+  int size() const { return size_; }
+  StringView name(int i) const {
+    return StringView(names_ + NameOffset(i), NameOffset(i+1) - NameOffset(i));
+  }
+  Matrix3dMap K(int i) const { return Matrix3dMap(params_ + 21 * i); }
+  Matrix3dMap R(int i) const { return Matrix3dMap(params_ + 21 * i + 9); }
+  Vector3dMap t(int i) const { return Vector3dMap(params_ + 21 * i + 18); }
+  Camera camera(int i) const;
+  // Index of the camera named 'name', or -1 if there is none.
+  int Find(StringView name) const;
+
+  // All the cameras and names, copied.
+  CameraRig ToCameraRig() const;
+ private:
+  MappedCameraRig(const MappedCameraRig&);
+  MappedCameraRig& operator=(const MappedCameraRig&);
+  uint64_t NameOffset(int i) const;
+
+  FileIO::MappedFile file_;   // Mapped for random access, as by Find().
+  int size_;
+  uint32_t hashSize_;
+  const double* params_;
+  const char* nameOffsets_;   // Not necessarily aligned.
+  const char* hash_;
+  const char* names_;
+};
+
 }   // namespace xyUtils
 
 #endif   // __XYUTILS_CAMERA_H__
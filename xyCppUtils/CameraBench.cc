@@ -0,0 +1,105 @@
+/**
+  * Benchmarks for cameras.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "Camera.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+
+#include "Benchmark.h"
+#include "CommandLineFlags.h"
+#include "LogAndCheck.h"
+#include "StringUtils.h"
+
+using namespace std;
+using namespace Eigen;
+using namespace xyUtils;
+
+int main(int argc, char** argv)  {
+  CommandLineFlagsInit(&argc, &argv, true);
+  BenchmarkSuite suite("Camera");
+
+  // Reading the cameras of the test data.
+  const char* camFile = "TestData/Models/dinoSparseRing-cams.txt";
+  vector<Camera> cameras;
+  if (suite.Run("ReadCamerasFromFile/dino", [&]() {
+        cameras = ReadCamerasFromFile(camFile, "NumNameKRt");
+      }, 0, 16)) {
+    CHECK_EQ(int(cameras.size()), 16);
+  }
+
+  // Generated file with many cameras, e.g. the frames of a video.
+  const int numCams = 100000;
+  const char* largeFile = "/tmp/xyUtils_CameraBench_cams.txt";
+  FILE* fp = fopen(largeFile, "w");
+  CHECK(fp);
+  fprintf(fp, "%d\n", numCams);
+  for (int i = 0; i < numCams; ++i) {
+    fprintf(fp, "cam%06d.png 3310.4 0 316.73 0 3325.5 200.55 0 0 1 "
+            "1 0 0 0 1 0 0 0 1 %.12g %.12g %.12g\n", i, 0.1*i, -0.2*i, 1.0);
+  }
+  double textBytes = ftell(fp);
+  fclose(fp);
+  CameraRig rig;
+  if (suite.Run("ReadCameraRigFromFile/text/100k", [&]() {
+        rig = ReadCameraRigFromFile(largeFile, "NumNameKRt");
+      }, textBytes, numCams)) {
+    CHECK_EQ(rig.size(), numCams);
+  }
+  remove(largeFile);
+
+  // The same cameras in a binary file.
+  const char* binFile = "/tmp/xyUtils_CameraBench_cams.bin";
+  WriteCameraRigToBinaryFile(binFile, rig);
+  if (suite.Run("ReadCameraRigFromFile/binary/100k", [&]() {
+        rig = ReadCameraRigFromFile(binFile, "Binary");
+      }, 0, numCams)) {
+    CHECK_EQ(rig.size(), numCams);
+  }
+  double tsum = 0.0;
+  suite.Run("MappedCameraRig/100k", [&]() {
+      MappedCameraRig mapped(binFile);
+      tsum += mapped.t(mapped.Find("cam054321.png"))(0);
+    }, 0, numCams);
+  DoNotOptimize(tsum);
+  remove(binFile);
+
+  // Lookup by name.
+  vector<string> names(1000);
+  for (size_t i = 0; i < names.size(); ++i) {
+    names[i] = StringUtils::PrintfToString("cam%06d.png", int(i * 97));
+  }
+  int found = 0;
+  if (suite.Run("CameraRig::Find", [&]() {
+        found = 0;
+        for (size_t i = 0; i < names.size(); ++i) {
+          found += rig.Find(names[i]) >= 0;
+        }
+      }, 0, names.size())) {
+    CHECK_EQ(found, int(names.size()));
+  }
+
+  // Camera math, on the first 10k cameras.
+  cameras.assign(rig.cameras().begin(), rig.cameras().begin() + 10000);
+  Vector3d sum = Vector3d::Zero();
+  suite.Run("Camera::center", [&]() {
+      for (size_t i = 0; i < cameras.size(); ++i)   sum += cameras[i].center();
+    }, 0, cameras.size());
+  DoNotOptimize(sum);
+  double x[2] = {100.0, 200.0};
+  suite.Run("Camera::backProjRay", [&]() {
+      for (size_t i = 0; i < cameras.size(); ++i) {
+        sum += cameras[i].backProjRay(x);
+      }
+    }, 0, cameras.size());
+  DoNotOptimize(sum);
+
+  suite.Finish();
+  return 0;
+}
@@ -0,0 +1,122 @@
+/**
+  * Test for reading and writing cameras.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "Camera.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "LogAndCheck.h"
+#include "StringUtils.h"
+#include "Timer.h"
+
+using namespace std;
+using namespace xyUtils;
+
+// Check that cameras 'a' and 'b' have the same parameters.
+void CheckSameCamera(const Camera& a, const Camera& b) {
+  CHECK(a.K() == b.K());
+  CHECK(a.R() == b.R());
+  CHECK(a.t() == b.t());
+}
+
+// Check that 'mapped' has the same cameras and names as 'rig'.
+void CheckSameRig(const MappedCameraRig& mapped, const CameraRig& rig) {
+  CHECK_EQ(mapped.size(), rig.size());
+  for (int i = 0; i < rig.size(); ++i) {
+    CHECK(mapped.name(i) == rig.name(i));
+    CHECK(mapped.K(i) == rig.camera(i).K());
+    CHECK(mapped.R(i) == rig.camera(i).R());
+    CHECK(mapped.t(i) == rig.camera(i).t());
+    CheckSameCamera(mapped.camera(i), rig.camera(i));
+    CHECK_EQ(mapped.Find(rig.name(i)), rig.Find(rig.name(i)));
+  }
+  CHECK_EQ(mapped.Find("no such camera"), -1);
+  CHECK_EQ(mapped.Find(""), rig.Find(""));
+}
+
+int main()  {
+  Timer timer;
+  LOG(INFO) << "Test on reading and writing cameras ...";
+
+  // The test data, compared against the first line read by sscanf.
+  const char* camFile = "TestData/Models/dinoSparseRing-cams.txt";
+  CameraRig dino = ReadCameraRigFromFile(camFile, "NumNameKRt");
+  CHECK_EQ(dino.size(), 16);
+  CHECK_EQ(dino.name(0), string("dinoSR0001.png"));
+  CHECK_EQ(dino.Find("dinoSR0001.png"), 0);
+  CHECK_EQ(dino.Find("dinoSR0016.png"), 15);
+  CHECK_EQ(dino.Find("dinoSR0017.png"), -1);
+  FILE* fp = fopen(camFile, "r");
+  CHECK(fp);
+  int nCams;
+  char name[64];
+  double p[21];
+  CHECK_EQ(fscanf(fp, "%d %63s", &nCams, name), 2);
+  for (int i = 0; i < 21; ++i)   CHECK_EQ(fscanf(fp, "%lf", p + i), 1);
+  CheckSameCamera(dino.camera(0), Camera(p, p + 9, p + 18));
+  // The FILE* version reads the rest of the file without closing it.
+  rewind(fp);
+  vector<Camera> cameras = ReadCamerasFromFile_NumNameKRt(fp);
+  fclose(fp);
+  CHECK_EQ(cameras.size(), 16u);
+  for (int i = 0; i < 16; ++i)   CheckSameCamera(cameras[i], dino.camera(i));
+
+  // A file large enough to be parsed in several chunks, with blank lines and
+  // a repeated name. The temporary files are named after this process, so that
+  // concurrent runs do not overwrite each other.
+  string textFileName = StringUtils::PrintfToString(
+      "/tmp/xyUtils_CameraTest_%d.txt", int(getpid()));
+  const char* textFile = textFileName.c_str();
+  const int N = 20000;
+  CameraRig rig;
+  fp = fopen(textFile, "w");
+  CHECK(fp);
+  for (int i = 0; i < N; ++i) {
+    for (int j = 0; j < 21; ++j)   p[j] = (i + 1) * 0.1 + j * 1e-7 - 3 * (j % 3);
+    string camName = StringUtils::PrintfToString("frame%05d.png", i % 19999);
+    rig.Add(camName, Camera(p, p + 9, p + 18));
+    fprintf(fp, "%s", camName.c_str());
+    for (int j = 0; j < 21; ++j)   fprintf(fp, " %.17g", p[j]);
+    fprintf(fp, i % 1000 == 0 ? "\n\n  \n" : "\n");
+  }
+  fclose(fp);
+  CameraRig read = ReadCameraRigFromFile(textFile, "NameKRt");
+  CHECK_EQ(read.size(), N);
+  for (int i = 0; i < N; ++i) {
+    CHECK_EQ(read.name(i), rig.name(i));
+    CheckSameCamera(read.camera(i), rig.camera(i));
+  }
+  CHECK_EQ(read.Find("frame00000.png"), 0);
+  CHECK_EQ(read.Find("frame12345.png"), 12345);
+  remove(textFile);
+
+  // Binary files.
+  string binFileName = StringUtils::PrintfToString(
+      "/tmp/xyUtils_CameraTest_%d.bin", int(getpid()));
+  const char* binFile = binFileName.c_str();
+  WriteCameraRigToBinaryFile(binFile, rig);
+  {
+    MappedCameraRig mapped(binFile);
+    CheckSameRig(mapped, rig);
+    CHECK_EQ(mapped.Find("frame00000.png"), 0);
+  }
+  read = ReadCameraRigFromFile(binFile, "Binary");
+  CHECK(read.names() == rig.names());
+  for (int i = 0; i < N; ++i)   CheckSameCamera(read.camera(i), rig.camera(i));
+  WriteCameraRigToBinaryFile(binFile, dino);
+  CheckSameRig(MappedCameraRig(binFile), dino);
+  WriteCameraRigToBinaryFile(binFile, CameraRig());
+  CHECK_EQ(MappedCameraRig(binFile).size(), 0);
+  CHECK_EQ(MappedCameraRig(binFile).Find("dinoSR0001.png"), -1);
+  remove(binFile);
+
+  LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
+  return 0;
+}
@@ -15,6 +15,7 @@
 #include "CommandLineFlags.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <cstdio>
 #include <cctype>
@@ -107,6 +108,10 @@ static void SetFlagValue(const string& key, const string& value) {
       *reinterpret_cast<long*>(flag_pointer) =
           StringConvert::ToLongAndCheck(value);
       break;
+    case AtomicIntType:
+      reinterpret_cast<std::atomic<int>*>(flag_pointer)->store(
+          StringConvert::ToIntAndCheck(value), std::memory_order_relaxed);
+      break;
     case DoubleType:
       *reinterpret_cast<double*>(flag_pointer) =
           StringConvert::ToDoubleAndCheck(value);
@@ -131,39 +136,32 @@ static bool HasWhitespace(const string& str) {
 
 // Use a text file to set flags.
 static void SetFlagsFromFile(const char* filename) {
-  FILE* fp = fopen(filename, "r");
-  if (fp == NULL) {
-    LOG(FATAL) << "Could not open flag file " << filename;
-  }
-  string line = FileIO::ReadLineToString(fp);
-  while (line.size() != 0) {
-    StringUtils::StripComments(&line, StringUtils::ShellComment);
-    StringUtils::StripWhiteSpace(&line);
-    if (line.size() > 0) {
-      if (line.size() < 3 || line[0] != '-' || line[1] != '-' ) {
-        LOG(FATAL) << "Error: Unable to process option \"" << line[0] << "\": "
-                   << "all options should start with two dashes (--).";
-      }
-      size_t equal_pos = line.find('=');
-      string key = line.substr(2, equal_pos-2);
-      string value = "";
-      if (equal_pos != string::npos) {
-        value = line.substr(equal_pos + 1);
-      } else {
-        // Single "--opt" is considered as "--opt=True", except for special flags.
-        value = "True";
-      }
-      // Check white space.
-      if (HasWhitespace(key) || HasWhitespace(value)) {
-        LOG(FATAL) << "Error: Unable to parse line \n"
-                   << line << std::endl
-                   << "One flag per line and no whitespace in key or value";
-      }
-      SetFlagValue(key, value);
+  // Lines without the comments and the white space, skipping empty ones.
+  FileIO::FilteredLineReader reader(filename, StringUtils::ShellComment);
+  StringView view;
+  while (reader.Next(&view)) {
+    string line = view.ToString();
+    if (line.size() < 3 || line[0] != '-' || line[1] != '-' ) {
+      LOG(FATAL) << "Error: Unable to process option \"" << line[0] << "\": "
+                 << "all options should start with two dashes (--).";
     }
-    line = FileIO::ReadLineToString(fp);
+    size_t equal_pos = line.find('=');
+    string key = line.substr(2, equal_pos-2);
+    string value = "";
+    if (equal_pos != string::npos) {
+      value = line.substr(equal_pos + 1);
+    } else {
+      // Single "--opt" is considered as "--opt=True", except for special flags.
+      value = "True";
+    }
+    // Check white space.
+    if (HasWhitespace(key) || HasWhitespace(value)) {
+      LOG(FATAL) << "Error: Unable to parse line \n"
+                 << line << std::endl
+                 << "One flag per line and no whitespace in key or value";
+    }
+    SetFlagValue(key, value);
   }
-  fclose(fp);
 }
 
 void CommandLineFlagsInit(int* argc, char*** argv, bool remove_flag) {
@@ -257,6 +255,11 @@ void PrintCommandLineFlagsHelp() {
           LOG(PLAIN) << "[Type: long. Default: "
                      << *reinterpret_cast<long*>(flag_pointer) << ".]\n";
           break;
+        case AtomicIntType:
+          LOG(PLAIN) << "[Type: int. Default: "
+                     << reinterpret_cast<std::atomic<int>*>(
+                            flag_pointer)->load() << ".]\n";
+          break;
         case DoubleType:
           LOG(PLAIN) << "[Type: double. Default: "
                      << *reinterpret_cast<double*>(flag_pointer) << ".]\n";
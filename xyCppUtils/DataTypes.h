@@ -9,8 +9,11 @@
 #define __XYUTILS_DATA_TYPES_H__
 
 namespace xyUtils  {
+// 'AtomicIntType' points to a std::atomic<int>, for values read by other
+// threads while they may be set.
 enum __data_type__  {
-  InvalidType, BoolType, CharType, IntType, LongType, DoubleType, StringType
+  InvalidType, BoolType, CharType, IntType, LongType, DoubleType, StringType,
+  AtomicIntType
 };
 
 struct __data_type_pointer__  {
@@ -7,125 +7,470 @@
 
 #include "EigenUtils.h"
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
 #include <vector>
 
-#ifdef __USE_TR1__
-#include <tr1/random>
-#else
-#include<random>
-#endif
-
 #include "FileIO.h"
 #include "LogAndCheck.h"
+#include "Random.h"
 #include "StringConvert.h"
-#include "StringUtils.h"
+#include "StringView.h"
+#include "ThreadPool.h"
 
 namespace xyUtils  {
 namespace EigenUtils  {
+namespace {
+// Number of normal random numbers generated in a batch, and by a task.
+const int kRandnBatchSize = 256;
+const int64_t kRandnTaskSize = 1 << 16;
+
+// Fill 'data[begin, end)' of the normal random stream of 'seed', where 'begin'
+// is even. Element 2k and 2k+1 of the stream come from block k of the Philox
+// generator, by the Box-Muller transform of two uniform doubles.
+void FillRandnRange(const Philox4x32& rng, double mu, double sigma,
+                    int64_t begin, int64_t end, double* data) {
+  double radius[kRandnBatchSize / 2], angle[kRandnBatchSize / 2];
+  for (int64_t batch = begin; batch < end; batch += kRandnBatchSize) {
+    int64_t firstBlock = batch / 2;
+    int numBlocks = (std::min(end - batch, int64_t(kRandnBatchSize)) + 1) / 2;
+    // Random bits to uniform numbers, and the transform, in separate loops so
+    // that the compiler could vectorize the former.
+    for (int k = 0; k < numBlocks; ++k) {
+      uint32_t bits[4];
+      rng.Generate(firstBlock + k, bits);
+      radius[k] = UniformOpenClosed(bits[0], bits[1]);
+      angle[k] = UniformClosedOpen(bits[2], bits[3]) * (2 * M_PI);
+    }
+    for (int k = 0; k < numBlocks; ++k) {
+      radius[k] = sigma * std::sqrt(-2.0 * std::log(radius[k]));
+    }
+    double* out = data + batch;
+    int n = std::min(end - batch, int64_t(kRandnBatchSize));
+    for (int k = 0; k < n / 2; ++k) {
+      out[2*k] = mu + radius[k] * std::cos(angle[k]);
+      out[2*k+1] = mu + radius[k] * std::sin(angle[k]);
+    }
+    if (n % 2)   out[n-1] = mu + radius[n/2] * std::cos(angle[n/2]);
+  }
+}
+
+// Fill 'data' with 'size' normal random numbers, in parallel on the default
+// thread pool. The result only depends on 'seed', not on the number of threads.
+void FillRandn(unsigned int seed, double mu, double sigma, int64_t size,
+               double* data) {
+  Philox4x32 rng(seed);
+  int numTasks = (size + kRandnTaskSize - 1) / kRandnTaskSize;
+  if (numTasks <= 1) {
+    FillRandnRange(rng, mu, sigma, 0, size, data);
+    return;
+  }
+  ParallelFor(0, numTasks, 1, [&](int begin, int end) {
+      FillRandnRange(rng, mu, sigma, begin * kRandnTaskSize,
+                     std::min(size, end * kRandnTaskSize), data);
+    });
+}
+
+// Text files larger than this are parsed by several threads, in chunks of about
+// this size.
+const size_t kParallelChunkBytes = 1 << 20;
+
+bool IsBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+int CountTokens(StringView line) {
+  int n = 0;
+  const char* p = line.begin();
+  while (true) {
+    while (p < line.end() && IsBlank(*p))   ++p;
+    if (p == line.end())   return n;
+    while (p < line.end() && !IsBlank(*p))   ++p;
+    ++n;
+  }
+}
+
+// Number of lines in [begin, end), including a last line without '\n'.
+int CountLines(const char* begin, const char* end) {
+  int n = 0;
+  for (const char* p = begin; p < end; ++p) {
+    p = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (!p)   return n + 1;
+    ++n;
+  }
+  return n;
+}
+
+// Parse the lines in [begin, end) as rows of 'cols' values, where the first
+// line is line 'firstLine' (0-based) of the file. Row i of the chunk is written
+// to 'out[i + j*stride]', j = 0, ..., cols-1. Blank lines are skipped. Return
+// the number of rows.
+int ParseRows(const char* filename, const char* begin, const char* end,
+              int firstLine, int cols, int stride, double* out) {
+  FileIO::LineIterator lines(begin, end - begin);
+  StringView line;
+  int row = 0;
+  while (lines.Next(&line)) {
+    const char* p = line.begin();
+    int j = 0;
+    while (true) {
+      while (p < line.end() && IsBlank(*p))   ++p;
+      if (p == line.end())   break;
+      if (j == cols) {
+        ++j;        // Too many values.
+        break;
+      }
+      const char* token = p;
+      while (p < line.end() && !IsBlank(*p))   ++p;
+      double value;
+      StringConvert::OutStatus status =
+          StringConvert::ToDouble(token, p - token, &value);
+      if (status != StringConvert::Success) {
+        LOG(FATAL) << filename << ":" << firstLine + lines.lineNumber()
+                   << ": cannot convert \"" << StringView(token, p - token)
+                   << "\" to double ("
+                   << StringConvert::OutStatusString(status) << ").";
+      }
+      out[row + j * stride] = value;
+      ++j;
+    }
+    if (j == 0)   continue;
+    if (j != cols) {
+      LOG(FATAL) << filename << ":" << firstLine + lines.lineNumber()
+                 << ": expect " << cols << " values, got "
+                 << CountTokens(line) << ".";
+    }
+    ++row;
+  }
+  return row;
+}
+
+// Text files are written in blocks of rows with about this many values, which
+// are formatted in parallel, this many blocks at a time.
+const int kWriteBlockValues = 1 << 16;
+const int kWriteBatchBlocks = 16;
+
+// Append the rows [begin, end) of 'm' to 'text', one line per row.
+void FormatRows(const Eigen::MatrixXd& m, int begin, int end,
+                std::string* text) {
+  for (int i = begin; i < end; ++i) {
+    for (int j = 0; j < m.cols(); ++j) {
+      if (j > 0)   text->push_back(' ');
+      StringConvert::AppendDouble(m(i, j), text);
+    }
+    text->push_back('\n');
+  }
+}
+
+const char kNpyMagic[] = "\x93NUMPY";
+const size_t kNpyMagicSize = 6;
+// Magic, version and header length of version 2.0 and above.
+const size_t kNpyMaxPrefixSize = 12;
+
+// Read a little endian unsigned integer of 'n' bytes.
+size_t ReadLittleEndian(const char* data, int n) {
+  size_t value = 0;
+  for (int i = n - 1; i >= 0; --i) {
+    value = (value << 8) | static_cast<unsigned char>(data[i]);
+  }
+  return value;
+}
+
+// Size of the whole header of the .npy file starting with 'data' of 'size'
+// bytes, with the dictionary starting at 'dictOffset'.
+size_t NpyHeaderSize(const char* filename, const char* data, size_t size,
+                     size_t* dictOffset) {
+  if (size < 10 || memcmp(data, kNpyMagic, kNpyMagicSize) != 0) {
+    LOG(FATAL) << filename << " is not an .npy file.";
+  }
+  int majorVersion = static_cast<unsigned char>(data[6]);
+  if (majorVersion == 1) {
+    *dictOffset = 10;
+    return *dictOffset + ReadLittleEndian(data + 8, 2);
+  } else if ((majorVersion == 2 || majorVersion == 3) && size >= 12) {
+    *dictOffset = 12;
+    return *dictOffset + ReadLittleEndian(data + 8, 4);
+  }
+  LOG(FATAL) << "Unsupported version " << majorVersion << " of .npy file "
+             << filename << ".";
+  return 0;
+}
+
+std::string FixedSizeString(int size) {
+  if (size == Eigen::Dynamic)   return "X";
+  std::ostringstream oss;
+  oss << size;
+  return oss.str();
+}
+
+// Position of the value of 'key' in the header dictionary 'dict'.
+size_t FindNpyValue(const char* filename, const std::string& dict,
+                    const char* key) {
+  size_t pos = dict.find(std::string("'") + key + "'");
+  if (pos != std::string::npos)   pos = dict.find(':', pos);
+  if (pos == std::string::npos) {
+    LOG(FATAL) << "No '" << key << "' in the header of " << filename << ".";
+  }
+  for (++pos; pos < dict.size() && dict[pos] == ' '; ++pos) { }
+  return pos;
+}
+}   // namespace
+
 Eigen::VectorXd RandnVectorXd(int N, unsigned int seed,
                               double mu, double sigma) {
-#ifdef __USE_TR1__
-  std::tr1::ranlux64_base_01 generator(seed);
-  std::tr1::normal_distribution<double> randn(mu, sigma);
-#else
-  std::default_random_engine generator(seed);
-  std::normal_distribution<double> randn(mu, sigma);
-#endif
   Eigen::VectorXd X(N);
-  for (int i = 0; i < N; ++i) {
-    X(i) = randn(generator);
-  }
+  FillRandn(seed, mu, sigma, N, X.data());
   return X;
 }
 
 Eigen::MatrixXd RandnMatrixXd(int M, int N, unsigned int seed,
                               double mu, double sigma) {
-#ifdef __USE_TR1__
-  std::tr1::ranlux64_base_01 generator(seed);
-  std::tr1::normal_distribution<double> randn(mu, sigma);
-#else
-  std::default_random_engine generator(seed);
-  std::normal_distribution<double> randn(mu, sigma);
-#endif
   Eigen::MatrixXd X(M, N);
-  for (int i = 0; i < M; ++i) {
-    for (int j = 0; j < N; ++j) {
-      X(i,j) = randn(generator);
-    }
-  }
+  FillRandn(seed, mu, sigma, X.size(), X.data());
   return X;
 }
 
 Eigen::VectorXd VectorXdFromTextFile(const char* filename) {
-  // In current implementation, we first read the data into a stl vector, and
-  // then copy it to an Eigen::VectorXd. This should be improved once we have
-  // better understanding on Eigen dynamic allocation interface.
-  FILE* fp = fopen(filename, "r");
-  CHECK(fp);
-  std::vector<double> v_stl;
-  std::string line = FileIO::ReadLineToString(fp);
-  std::vector<std::string> parts = StringUtils::Split(line);
-  for (size_t i = 0; i < parts.size(); ++i) {
-    v_stl.push_back(StringConvert::ToDoubleAndCheck(parts[i]));
-  }
-  if (v_stl.size() > 1) {
-    // Row vector.
-    line = FileIO::ReadLineToString(fp);
-    CHECK(line.empty());
-  } else {
-    // Column vector.
-    line = FileIO::ReadLineToString(fp);
-    while (!line.empty()) {
-      StringUtils::StripWhiteSpace(&line);
-      v_stl.push_back(StringConvert::ToDoubleAndCheck(line));
-      line = FileIO::ReadLineToString(fp);
+  Eigen::MatrixXd m = MatrixXdFromTextFile(filename);
+  if (m.size() == 0) {
+    return Eigen::VectorXd();
+  } else if (m.rows() == 1) {
+    return m.row(0).transpose();
+  } else if (m.cols() <= 1) {
+    return m.col(0);
+  }
+  LOG(FATAL) << "\"" << filename << "\" contains a " << m.rows() << "x"
+             << m.cols() << " matrix rather than a vector.";
+  return Eigen::VectorXd();
+}
+
+Eigen::MatrixXd MatrixXdFromTextFile(const char* filename) {
+  FileIO::MappedFile file(filename);
+  const char* data = file.data();
+  // Split the file into line aligned chunks, which are parsed in parallel.
+  std::vector<const char*> chunks =
+      FileIO::SplitIntoLineChunks(file.view(), kParallelChunkBytes);
+  int numChunks = chunks.size() - 1;
+  // The first row gives the number of columns.
+  int cols = 0;
+  FileIO::LineIterator lines(data, file.size());
+  StringView line;
+  while (cols == 0 && lines.Next(&line))   cols = CountTokens(line);
+  if (cols == 0)   return Eigen::MatrixXd();
+  // Count the lines of each chunk, which gives the row of each chunk's first
+  // line if there are no blank lines.
+  std::vector<int> chunkFirstLine(numChunks + 1, 0);
+  ParallelFor(0, numChunks, 1, [&](int begin, int end) {
+      for (int c = begin; c < end; ++c) {
+        chunkFirstLine[c+1] = CountLines(chunks[c], chunks[c+1]);
+      }
+    });
+  for (int c = 0; c < numChunks; ++c) {
+    chunkFirstLine[c+1] += chunkFirstLine[c];
+  }
+  // Parse the values directly into the column-major result.
+  int rows = chunkFirstLine[numChunks];
+  Eigen::MatrixXd m(rows, cols);
+  std::vector<int> chunkRows(numChunks, 0);
+  ParallelFor(0, numChunks, 1, [&](int begin, int end) {
+      for (int c = begin; c < end; ++c) {
+        chunkRows[c] = ParseRows(filename, chunks[c], chunks[c+1],
+                                 chunkFirstLine[c], cols, rows,
+                                 m.data() + chunkFirstLine[c]);
+      }
+    });
+  // Remove the rows of the blank lines, if any.
+  int numRows = 0;
+  for (int c = 0; c < numChunks; ++c) {
+    if (numRows != chunkFirstLine[c]) {
+      for (int j = 0; j < cols; ++j) {
+        double* col = m.data() + j * rows;
+        memmove(col + numRows, col + chunkFirstLine[c],
+                chunkRows[c] * sizeof(double));
+      }
     }
+    numRows += chunkRows[c];
   }
-  fclose(fp);
+  if (numRows != rows)   m.conservativeResize(numRows, cols);
+  return m;
+}
 
-  Eigen::VectorXd v(v_stl.size());
-  for (size_t i = 0; i < v_stl.size(); ++i) {
-    v(i) = v_stl[i];
+void WriteMatrixToTextFile(const char* filename, const Eigen::MatrixXd& m) {
+  FILE* fp = fopen(filename, "w");
+  if (!fp)   LOG(FATAL) << "Cannot open " << filename << " for writing.";
+  const int rows = m.rows();
+  const int cols = std::max(1, int(m.cols()));
+  const int blockRows = std::max(1, kWriteBlockValues / cols);
+  const int numBlocks = (rows + blockRows - 1) / blockRows;
+  std::vector<std::string> texts(kWriteBatchBlocks);
+  for (int batch = 0; batch < numBlocks; batch += kWriteBatchBlocks) {
+    int n = std::min(kWriteBatchBlocks, numBlocks - batch);
+    ParallelFor(0, n, 1, [&](int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+          int first = (batch + b) * blockRows;
+          texts[b].clear();
+          FormatRows(m, first, std::min(rows, first + blockRows), &texts[b]);
+        }
+      });
+    for (int b = 0; b < n; ++b) {
+      if (fwrite(texts[b].data(), 1, texts[b].size(), fp) != texts[b].size()) {
+        LOG(FATAL) << "Error on writing " << filename << ".";
+      }
+    }
   }
-  return v;
+  if (fclose(fp) != 0)   LOG(FATAL) << "Error on writing " << filename << ".";
 }
 
-Eigen::MatrixXd MatrixXdFromTextFile(const char* filename) {
-  // In current implementation, we first read the data into a stl vector of stl
-  // vectors, and then copy it to an Eigen::MatrixXd. This should be improved
-  // once we have better understanding on Eigen dynamic allocation interface.
-  FILE* fp = fopen(filename, "r");
-  CHECK(fp);
-  std::vector<std::vector<double> > m_stl;
-  // Read the first row.
-  std::string line = FileIO::ReadLineToString(fp);
-  std::vector<std::string> parts = StringUtils::Split(line);
-  std::vector<double> v_stl(parts.size());
-  for (size_t i = 0; i < parts.size(); ++i) {
-    v_stl[i] = StringConvert::ToDoubleAndCheck(parts[i]);
-  }
-  m_stl.push_back(v_stl);
-  // Read the following rows.
-  line = FileIO::ReadLineToString(fp);
-  while (!line.empty()) {
-    parts = StringUtils::Split(line);
-    CHECK_EQ(v_stl.size(), parts.size());
-    for (size_t i = 0; i < parts.size(); ++i) {
-      v_stl[i] = StringConvert::ToDoubleAndCheck(parts[i]);
+NpyHeader ReadNpyHeader(const char* filename, FileIO::BinaryReader* reader) {
+  std::string data(kNpyMaxPrefixSize, '\0');
+  data.resize(reader->ReadBytes(&data[0], data.size()));
+  size_t dictOffset;
+  size_t headerSize = NpyHeaderSize(filename, data.data(), data.size(),
+                                    &dictOffset);
+  if (headerSize > data.size()) {
+    size_t prefixSize = data.size();
+    data.resize(headerSize);
+    size_t n = headerSize - prefixSize;
+    if (reader->ReadBytes(&data[prefixSize], n) != n) {
+      LOG(FATAL) << "Unexpected end of file " << filename
+                 << " when reading the header.";
     }
-    m_stl.push_back(v_stl);
-    line = FileIO::ReadLineToString(fp);
+  } else {
+    reader->Seek(headerSize);
   }
-  fclose(fp);
+  return ParseNpyHeader(filename, data.data(), headerSize);
+}
+
+NpyHeader ReadNpyHeader(const char* filename) {
+  FileIO::BinaryReader reader(filename, FileIO::LittleEndian, 4096);
+  return ReadNpyHeader(filename, &reader);
+}
 
-  Eigen::MatrixXd m(m_stl.size(), v_stl.size());
-  for (size_t i = 0; i < m_stl.size(); ++i) {
-    for (size_t j = 0; j < v_stl.size(); ++j) {
-      m(i,j) = m_stl[i][j];
+NpyHeader ParseNpyHeader(const char* filename, const char* data, size_t size) {
+  size_t dictOffset;
+  size_t headerSize = NpyHeaderSize(filename, data, size, &dictOffset);
+  if (headerSize > size) {
+    LOG(FATAL) << "Unexpected end of file " << filename
+               << " when reading the header.";
+  }
+  std::string dict(data + dictOffset, headerSize - dictOffset);
+  NpyHeader header;
+  header.dataOffset = headerSize;
+  // Data type, a quoted string.
+  size_t pos = FindNpyValue(filename, dict, "descr");
+  size_t end = pos < dict.size() ? dict.find(dict[pos], pos + 1) :
+      std::string::npos;
+  if ((dict[pos] != '\'' && dict[pos] != '"') || end == std::string::npos) {
+    LOG(FATAL) << "Invalid 'descr' in the header of " << filename << ".";
+  }
+  header.descr = dict.substr(pos + 1, end - pos - 1);
+  // Storage order.
+  pos = FindNpyValue(filename, dict, "fortran_order");
+  if (dict.compare(pos, 4, "True") == 0) {
+    header.fortranOrder = true;
+  } else if (dict.compare(pos, 5, "False") == 0) {
+    header.fortranOrder = false;
+  } else {
+    LOG(FATAL) << "Invalid 'fortran_order' in the header of " << filename
+               << ".";
+  }
+  // Shape, a tuple of integers, e.g. "(3, 4)", "(5,)" or "()".
+  pos = FindNpyValue(filename, dict, "shape");
+  if (pos == dict.size() || dict[pos] != '(') {
+    LOG(FATAL) << "Invalid 'shape' in the header of " << filename << ".";
+  }
+  for (++pos; pos < dict.size() && dict[pos] != ')'; ) {
+    if (dict[pos] == ' ' || dict[pos] == ',') {
+      ++pos;
+      continue;
     }
+    if (dict[pos] < '0' || dict[pos] > '9') {
+      LOG(FATAL) << "Invalid 'shape' in the header of " << filename << ".";
+    }
+    int64_t dim = 0;
+    for (; pos < dict.size() && dict[pos] >= '0' && dict[pos] <= '9'; ++pos) {
+      dim = dim * 10 + (dict[pos] - '0');
+    }
+    // Python 2 writes long integers as e.g. "3L".
+    if (pos < dict.size() && dict[pos] == 'L')   ++pos;
+    header.shape.push_back(dim);
   }
-  return m;
+  return header;
+}
+
+void WriteNpyHeader(const NpyHeader& header, FileIO::BinaryWriter* writer) {
+  std::ostringstream dict;
+  dict << "{'descr': '" << header.descr << "', 'fortran_order': "
+       << (header.fortranOrder ? "True" : "False") << ", 'shape': (";
+  for (size_t i = 0; i < header.shape.size(); ++i) {
+    dict << (i ? ", " : "") << header.shape[i];
+  }
+  dict << (header.shape.size() == 1 ? ",), }" : "), }");
+  // Pad with spaces and end with '\n', such that the data is 64-byte aligned.
+  std::string str = dict.str();
+  size_t prefixSize = str.size() + 11 < 65536 ? 10 : 12;
+  str.append((64 - (prefixSize + str.size() + 1) % 64) % 64, ' ');
+  str.push_back('\n');
+  char prefix[kNpyMaxPrefixSize];
+  memcpy(prefix, kNpyMagic, kNpyMagicSize);
+  prefix[6] = prefixSize == 10 ? 1 : 2;
+  prefix[7] = 0;
+  for (size_t i = 8; i < prefixSize; ++i) {
+    prefix[i] = static_cast<char>((str.size() >> (8 * (i - 8))) & 0xff);
+  }
+  writer->WriteBytes(prefix, prefixSize);
+  writer->WriteBytes(str.data(), str.size());
+}
+
+std::string NpyDescr(char kind, size_t size) {
+  std::ostringstream oss;
+  oss << (size == 1 ? '|' :
+          FileIO::NativeByteOrder() == FileIO::LittleEndian ? '<' : '>')
+      << kind << size;
+  return oss.str();
+}
+
+void NpyMatrixSize(const char* filename, const NpyHeader& header,
+                   const std::string& descr, int fixedRows, int fixedCols,
+                   int* rows, int* cols, bool* swapBytes) {
+  if (header.descr.size() < 2 ||
+      header.descr.compare(1, std::string::npos, descr, 1,
+                           std::string::npos) != 0) {
+    LOG(FATAL) << filename << " has data type \"" << header.descr
+               << "\" rather than \"" << descr << "\".";
+  }
+  // The byte order is '|' if not applicable and '=' if native.
+  char order = header.descr[0];
+  *swapBytes = descr[0] != '|' && (order == '<' || order == '>') &&
+      order != descr[0];
+  int64_t r = 0, c = 0;
+  if (header.shape.size() == 0) {
+    r = c = 1;
+  } else if (header.shape.size() == 1) {
+    r = fixedRows == 1 ? 1 : header.shape[0];
+    c = fixedRows == 1 ? header.shape[0] : 1;
+  } else if (header.shape.size() == 2) {
+    r = header.shape[0];
+    c = header.shape[1];
+  } else {
+    LOG(FATAL) << filename << " has " << header.shape.size()
+               << " dimensions rather than at most 2.";
+  }
+  if (r > INT_MAX || c > INT_MAX ||
+      (fixedRows != Eigen::Dynamic && r != fixedRows) ||
+      (fixedCols != Eigen::Dynamic && c != fixedCols)) {
+    LOG(FATAL) << "Cannot read the " << r << "x" << c << " matrix in "
+               << filename << " to a matrix of size "
+               << FixedSizeString(fixedRows) << "x"
+               << FixedSizeString(fixedCols) << ".";
+  }
+  *rows = r;
+  *cols = c;
 }
 }   // namespace EigenUtils
 }   // namespace xyUtils
@@ -8,8 +8,19 @@
 #ifndef __XYUTILS_EIGEN_UTILS_H__
 #define __XYUTILS_EIGEN_UTILS_H__
 
+#include <string>
+#include <vector>
+
+#ifdef __USE_TR1__
+#include <tr1/cstdint>
+#else
+#include <cstdint>
+#endif
+
 #include <Eigen/Core>
 
+#include "FileIO.h"
+
 namespace xyUtils  {
 namespace EigenUtils {
 
@@ -31,6 +42,11 @@ typedef Eigen::Matrix<int, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rMat
 // distribution with mean equal to 'mu' and standard deviation equal to 'sigma'.
 // Note that the same 'seed' will result in the same matrix, and therefore
 // itself is suggested to be randomized, say using rand().
+// The entries are generated in memory order from a counter-based generator
+// (see Random.h), in parallel for large sizes, and are the same regardless of
+// the number of threads. The same 'seed' gives the same entries in the same
+// memory positions, e.g. RandnMatrixXd(M, N, seed) has the entries of
+// RandnVectorXd(M*N, seed) in column-major order.
 Eigen::VectorXd RandnVectorXd(int N, unsigned int seed,
                               double mu = 1.0, double sigma = 1.0);
 Eigen::MatrixXd RandnMatrixXd(int M, int N, unsigned int seed,
@@ -40,6 +56,10 @@ Eigen::MatrixXd RandnMatrixXd(int M, int N, unsigned int seed,
 //   val11 val12 ...
 //   val21 val22 ...
 //   ......
+// where the values are separated by white space and blank lines are ignored.
+// The file is memory mapped and, if large, parsed by several threads on the
+// default thread pool (see ThreadPool.h). A file without values gives an empty
+// vector/matrix.
 Eigen::VectorXd VectorXdFromTextFile(const char* filename);
 inline Eigen::VectorXd VectorXdFromTextFile(const std::string filename) {
   return VectorXdFromTextFile(filename.c_str());
@@ -49,7 +69,102 @@ inline Eigen::MatrixXd MatrixXdFromTextFile(const std::string filename) {
   return MatrixXdFromTextFile(filename.c_str());
 }
 
+// Write a matrix to a text file in the format above, one row per line. The
+// values have the fewest digits that read back to exactly the same doubles
+// (see StringConvert::FormatDouble), e.g. "0.1" rather than
+// "0.10000000000000001", and large matrices are formatted by several threads.
+// A vector is written as a column, and could be read back by both of the above.
+void WriteMatrixToTextFile(const char* filename, const Eigen::MatrixXd& m);
+inline void WriteMatrixToTextFile(const std::string& filename,
+                                  const Eigen::MatrixXd& m) {
+  WriteMatrixToTextFile(filename.c_str(), m);
+}
+
+// ================================================================
+// Binary matrix files in the NumPy .npy format, e.g.
+//   EigenUtils::WriteNpyFile("m.npy", m);
+//   Eigen::MatrixXd m2 = EigenUtils::ReadNpyFile<Eigen::MatrixXd>("m.npy");
+//   // Without reading, the matrix is a view into the memory mapped file.
+//   EigenUtils::MappedNpyFile<Eigen::MatrixXd> mapped("m.npy");
+//   double sum = mapped.map().sum();
+// The scalar type could be any floating point, integer or bool type, and must
+// be the same as the data type of the file. The data is written as is, i.e. in
+// the storage order of the matrix ('fortran_order' is true for column-major)
+// and native byte order. Vectors are written as 1-D arrays. Reading converts
+// the byte order and, by a copy, the storage order when they differ from the
+// matrix type, while mapping requires them to be the same. Any error is a
+// LOG(FATAL).
+
+// The header of an .npy file.
+struct NpyHeader {
+  std::string descr;            // Data type, e.g. "<f8" for little endian double.
+  bool fortranOrder;            // Whether the data is column-major.
+  std::vector<int64_t> shape;
+  int64_t dataOffset;           // Where the data starts in the file.
+};
+
+template <typename Derived>
+void WriteNpyFile(const char* filename, const Eigen::MatrixBase<Derived>& m);
+template <typename Derived>
+void WriteNpyFile(const std::string& filename,
+                  const Eigen::MatrixBase<Derived>& m) {
+  WriteNpyFile(filename.c_str(), m);
+}
+
+template <typename MatrixType>
+MatrixType ReadNpyFile(const char* filename);
+template <typename MatrixType>
+MatrixType ReadNpyFile(const std::string& filename) {
+  return ReadNpyFile<MatrixType>(filename.c_str());
+}
+
+template <typename MatrixType>
+class MappedNpyFile {
+ public:
+  typedef Eigen::Map<const MatrixType> MapType;
+
+  explicit MappedNpyFile(const char* filename);
+  explicit MappedNpyFile(const std::string& filename)
+      : MappedNpyFile(filename.c_str()) { }
+
+  // Valid as long as this object is alive.
+  const MapType& map() const { return map_; }
+  const NpyHeader& header() const { return header_; }
+ private:
+  MappedNpyFile(const MappedNpyFile&);
+  MappedNpyFile& operator=(const MappedNpyFile&);
+
+  FileIO::MappedFile file_;   // Mapped for normal access, as 'map_' may be
+                              // read in any order.
+  NpyHeader header_;
+  MapType map_;
+};
+
+// Read the header of an .npy file, leaving 'reader' (if given) at the beginning
+// of the data.
+NpyHeader ReadNpyHeader(const char* filename, FileIO::BinaryReader* reader);
+NpyHeader ReadNpyHeader(const char* filename);
+// Parse the header at the beginning of the .npy file content 'data'.
+NpyHeader ParseNpyHeader(const char* filename, const char* data, size_t size);
+// Write the header, where 'header.dataOffset' is ignored.
+void WriteNpyHeader(const NpyHeader& header, FileIO::BinaryWriter* writer);
+
+// The .npy data type of a scalar 'kind' ('f' for floating point, 'i' for
+// signed integer, 'u' for unsigned integer or 'b' for bool) of 'size' bytes in
+// native byte order, e.g. "<f8".
+std::string NpyDescr(char kind, size_t size);
+
+// The size of the matrix in the .npy file given its 'header', and whether the
+// bytes need to be swapped, or LOG(FATAL) if it could not be read as a matrix
+// of data type 'descr' and compile time size 'fixedRows' x 'fixedCols'
+// ('Eigen::Dynamic' if not fixed).
+void NpyMatrixSize(const char* filename, const NpyHeader& header,
+                   const std::string& descr, int fixedRows, int fixedCols,
+                   int* rows, int* cols, bool* swapBytes);
+
 }   // namespace Eigen
 }   // namespace xyUtils
 
+#include "EigenUtils.tcc"
+
 #endif   // __XYUTILS_EIGEN_UTILS_H__
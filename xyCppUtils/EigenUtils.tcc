@@ -0,0 +1,123 @@
+/**
+ * Implementation for templated functions of "EigenUtils.h". This file is
+ * included at the end of "EigenUtils.h" file.
+ *
+ * Author: Ying Xiong.
+ * Created: Oct 18, 2026.
+ */
+
+#ifndef __XYUTILS_EIGEN_UTILS_TCC__
+#define __XYUTILS_EIGEN_UTILS_TCC__
+
+#include <limits>
+#include <new>
+
+#include "LogAndCheck.h"
+
+namespace xyUtils  {
+namespace EigenUtils {
+
+template <typename Scalar>
+std::string NpyDescrOf() {
+  static_assert(std::is_arithmetic<Scalar>::value, "Only arithmetic types.");
+  char kind = std::is_same<Scalar, bool>::value ? 'b' :
+      !std::numeric_limits<Scalar>::is_integer ? 'f' :
+      std::numeric_limits<Scalar>::is_signed ? 'i' : 'u';
+  return NpyDescr(kind, sizeof(Scalar));
+}
+
+template <typename Derived>
+void WriteNpyFile(const char* filename, const Eigen::MatrixBase<Derived>& m) {
+  typedef typename Derived::Scalar Scalar;
+  // No copy if 'm' is a plain matrix.
+  typename Derived::EvalReturnType plain = m.eval();
+  NpyHeader header;
+  header.descr = NpyDescrOf<Scalar>();
+  if (Derived::IsVectorAtCompileTime) {
+    header.fortranOrder = false;
+    header.shape.push_back(plain.size());
+  } else {
+    header.fortranOrder = !Derived::IsRowMajor;
+    header.shape.push_back(plain.rows());
+    header.shape.push_back(plain.cols());
+  }
+  FileIO::BinaryWriter writer(filename, FileIO::NativeByteOrder());
+  WriteNpyHeader(header, &writer);
+  writer.Write(plain.data(), plain.size());
+}
+
+template <typename MatrixType>
+MatrixType ReadNpyFile(const char* filename) {
+  typedef typename MatrixType::Scalar Scalar;
+  FileIO::BinaryReader reader(filename, FileIO::NativeByteOrder());
+  NpyHeader header = ReadNpyHeader(filename, &reader);
+  int rows, cols;
+  bool swapBytes;
+  NpyMatrixSize(filename, header, NpyDescrOf<Scalar>(),
+                MatrixType::RowsAtCompileTime, MatrixType::ColsAtCompileTime,
+                &rows, &cols, &swapBytes);
+  if (swapBytes) {
+    reader.SetByteOrder(FileIO::NativeByteOrder() == FileIO::LittleEndian ?
+                        FileIO::BigEndian : FileIO::LittleEndian);
+  }
+  MatrixType m(rows, cols);
+  bool isRowMajor = MatrixType::IsRowMajor;
+  if (rows <= 1 || cols <= 1 || header.fortranOrder != isRowMajor) {
+    reader.Read(m.data(), m.size());
+  } else {
+    // Read in the storage order of the file, and then transpose. Vectors have
+    // a single valid storage order, but never get here.
+    enum {
+      OtherOrder = MatrixType::RowsAtCompileTime == 1 ? Eigen::RowMajor :
+                   MatrixType::ColsAtCompileTime == 1 ? Eigen::ColMajor :
+                   MatrixType::IsRowMajor ? Eigen::ColMajor : Eigen::RowMajor
+    };
+    typedef Eigen::Matrix<Scalar, MatrixType::RowsAtCompileTime,
+        MatrixType::ColsAtCompileTime, OtherOrder> OtherType;
+    OtherType other(rows, cols);
+    reader.Read(other.data(), other.size());
+    m = other;
+  }
+  return m;
+}
+
+template <typename MatrixType>
+MappedNpyFile<MatrixType>::MappedNpyFile(const char* filename)
+    : file_(filename, FileIO::MappedFile::NormalAccess),
+      header_(ParseNpyHeader(filename, file_.data(), file_.size())),
+      map_(NULL,
+           MatrixType::RowsAtCompileTime == Eigen::Dynamic ? 0 :
+           MatrixType::RowsAtCompileTime,
+           MatrixType::ColsAtCompileTime == Eigen::Dynamic ? 0 :
+           MatrixType::ColsAtCompileTime) {
+  int rows, cols;
+  bool swapBytes;
+  NpyMatrixSize(filename, header_, NpyDescrOf<typename MatrixType::Scalar>(),
+                MatrixType::RowsAtCompileTime, MatrixType::ColsAtCompileTime,
+                &rows, &cols, &swapBytes);
+  bool isRowMajor = MatrixType::IsRowMajor;
+  if (swapBytes) {
+    LOG(FATAL) << "Cannot map " << filename << " of data type \""
+               << header_.descr << "\" in non-native byte order.";
+  }
+  if (rows > 1 && cols > 1 && header_.fortranOrder == isRowMajor) {
+    LOG(FATAL) << "Cannot map " << filename << " in "
+               << (header_.fortranOrder ? "column" : "row")
+               << "-major order to a "
+               << (isRowMajor ? "row" : "column") << "-major matrix.";
+  }
+  typedef typename MatrixType::Scalar Scalar;
+  if (header_.dataOffset + int64_t(rows) * cols * sizeof(Scalar) >
+      file_.size()) {
+    LOG(FATAL) << "Unexpected end of file " << filename << ".";
+  }
+  // The Eigen way to change what a Map refers to.
+  const Scalar* data =
+      reinterpret_cast<const Scalar*>(file_.data() + header_.dataOffset);
+  new (&map_) MapType(data, rows, cols);
+}
+
+}   // namespace EigenUtils
+}   // namespace xyUtils
+
+#endif   // __XYUTILS_EIGEN_UTILS_TCC__
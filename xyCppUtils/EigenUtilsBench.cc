@@ -0,0 +1,109 @@
+/**
+  * Benchmarks for Eigen utilities.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "EigenUtils.h"
+
+#include <cstdio>
+#include <Eigen/Core>
+
+#include "Benchmark.h"
+#include "CommandLineFlags.h"
+#include "FileIO.h"
+#include "LogAndCheck.h"
+
+using namespace Eigen;
+using namespace xyUtils;
+
+int main(int argc, char** argv)  {
+  CommandLineFlagsInit(&argc, &argv, true);
+  BenchmarkSuite suite("EigenUtils");
+
+  // Matrix text parsing on the test data.
+  const char* nodesFile = "TestData/Models/skull_nodes.txt";
+  double nodesBytes = FileIO::ReadWholeFileToString(nodesFile).size();
+  MatrixXd m = EigenUtils::MatrixXdFromTextFile(nodesFile);
+  CHECK_GT(m.size(), 0);
+  suite.Run("MatrixXdFromTextFile/skull_nodes", [&]() {
+      m = EigenUtils::MatrixXdFromTextFile(nodesFile);
+    }, nodesBytes, m.size());
+
+  // Generated large matrix.
+  const int rows = 100000, cols = 10;
+  const char* largeFile = "/tmp/xyUtils_EigenUtilsBench_matrix.txt";
+  MatrixXd large = EigenUtils::RandnMatrixXd(rows, cols, 0);
+  FILE* fp = fopen(largeFile, "w");
+  CHECK(fp);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      fprintf(fp, "%.17g%c", large(i,j), j == cols-1 ? '\n' : ' ');
+    }
+  }
+  fclose(fp);
+  double largeBytes = FileIO::ReadWholeFileToString(largeFile).size();
+  if (suite.Run("MatrixXdFromTextFile/100000x10", [&]() {
+        m = EigenUtils::MatrixXdFromTextFile(largeFile);
+      }, largeBytes, rows * cols)) {
+    CHECK_EQ(m.rows(), rows);
+    CHECK_EQ(m.cols(), cols);
+  }
+  // Writing it back with the shortest digits, and with fprintf for comparison.
+  suite.Run("fprintf/100000x10", [&]() {
+      FILE* fp = fopen(largeFile, "w");
+      CHECK(fp);
+      for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+          fprintf(fp, "%.17g%c", large(i,j), j == cols-1 ? '\n' : ' ');
+        }
+      }
+      fclose(fp);
+    }, largeBytes, rows * cols);
+  if (suite.Run("WriteMatrixToTextFile/100000x10", [&]() {
+        EigenUtils::WriteMatrixToTextFile(largeFile, large);
+      }, largeBytes, rows * cols)) {
+    CHECK(EigenUtils::MatrixXdFromTextFile(largeFile) == large);
+  }
+  remove(largeFile);
+
+  // Binary .npy files of the same matrix.
+  const char* npyFile = "/tmp/xyUtils_EigenUtilsBench_matrix.npy";
+  double npyBytes = large.size() * sizeof(double);
+  EigenUtils::WriteNpyFile(npyFile, large);
+  suite.Run("WriteNpyFile/100000x10", [&]() {
+      EigenUtils::WriteNpyFile(npyFile, large);
+    }, npyBytes, rows * cols);
+  if (suite.Run("ReadNpyFile/100000x10", [&]() {
+        m = EigenUtils::ReadNpyFile<MatrixXd>(npyFile);
+      }, npyBytes, rows * cols)) {
+    CHECK(m == large);
+  }
+  suite.Run("ReadNpyFile/100000x10/transpose", [&]() {
+      EigenUtils::rMatrixXd rm =
+          EigenUtils::ReadNpyFile<EigenUtils::rMatrixXd>(npyFile);
+      DoNotOptimize(rm);
+    }, npyBytes, rows * cols);
+  double sum = 0.0;
+  suite.Run("MappedNpyFile/100000x10/sum", [&]() {
+      EigenUtils::MappedNpyFile<MatrixXd> mapped(npyFile);
+      sum = mapped.map().sum();
+    }, npyBytes, rows * cols);
+  DoNotOptimize(sum);
+  remove(npyFile);
+
+  // Random number generation.
+  VectorXd v;
+  suite.Run("RandnVectorXd/1M", [&]() {
+      v = EigenUtils::RandnVectorXd(1000000, 0);
+    }, 0, 1000000);
+  DoNotOptimize(v);
+  suite.Run("RandnMatrixXd/1000x1000", [&]() {
+      m = EigenUtils::RandnMatrixXd(1000, 1000, 0);
+    }, 0, 1000000);
+  DoNotOptimize(m);
+
+  suite.Finish();
+  return 0;
+}
@@ -7,8 +7,12 @@
 
 #include "EigenUtils.h"
 
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <string>
 
+#include "FileIO.h"
 #include "LogAndCheck.h"
 #include "NumericalCheck.h"
 #include "Timer.h"
@@ -34,6 +38,164 @@ int main() {
   MatrixXd m2 = MatrixXdFromTextFile("TestData/Texts/EigenUtilsTest_Matrix.txt");
   CheckNear(m1, m2, 1e-6);
 
-  LOG(INFO) << "Passed.";
+  // Random matrices are reproducible and do not depend on how the generation is
+  // split into tasks.
+  const int numRandn = 1000003;
+  VectorXd randn = RandnVectorXd(numRandn, 7, 2.0, 3.0);
+  CHECK(randn == RandnVectorXd(numRandn, 7, 2.0, 3.0));
+  CHECK(randn.head(1001) == RandnVectorXd(1001, 7, 2.0, 3.0));
+  CHECK(randn.segment(70000, 1) == RandnVectorXd(70001, 7, 2.0, 3.0).tail(1));
+  MatrixXd randm = RandnMatrixXd(1000, 1000, 7, 2.0, 3.0);
+  CHECK(Map<VectorXd>(randm.data(), randm.size()) == randn.head(randm.size()));
+  CHECK(randn.head(1000) != RandnVectorXd(1000, 8, 2.0, 3.0));
+  double mean = randn.mean();
+  double stddev = std::sqrt((randn.array() - mean).square().mean());
+  CHECK_NEAR(mean, 2.0, 0.01);
+  CHECK_NEAR(stddev, 3.0, 0.01);
+  int numWithin1Sigma = ((randn.array() - 2.0).abs() < 3.0).count();
+  CHECK_NEAR(numWithin1Sigma / double(numRandn), 0.6827, 0.002);
+
+  // Tabs, blank lines, Windows line ends and no '\n' at the end.
+  const char* textFile = "/tmp/xyUtils_EigenUtilsTest.txt";
+  FILE* fp = fopen(textFile, "w");
+  CHECK(fp);
+  fprintf(fp, "\n  1\t2.0  3e0\r\n\n4 +5 6.  \n \t \n");
+  fclose(fp);
+  m2 = MatrixXdFromTextFile(textFile);
+  CHECK_EQ(m2.rows(), 2);
+  CheckNear(m1, m2, 0.0);
+  fp = fopen(textFile, "w");
+  CHECK(fp);
+  fprintf(fp, "1 2 3 4");
+  fclose(fp);
+  v2 = VectorXdFromTextFile(textFile);
+  CheckNear(v1, v2, 0.0);
+  fp = fopen(textFile, "w");
+  CHECK(fp);
+  fclose(fp);
+  CHECK_EQ(MatrixXdFromTextFile(textFile).size(), 0);
+  CHECK_EQ(VectorXdFromTextFile(textFile).size(), 0);
+  fp = fopen(textFile, "w");
+  CHECK(fp);
+  fprintf(fp, "\n \n");
+  fclose(fp);
+  CHECK_EQ(MatrixXdFromTextFile(textFile).size(), 0);
+  CHECK_EQ(VectorXdFromTextFile(textFile).size(), 0);
+
+  // A large matrix, parsed in parallel, is read back exactly.
+  MatrixXd large = RandnMatrixXd(100000, 7, 0);
+  fp = fopen(textFile, "w");
+  CHECK(fp);
+  for (int i = 0; i < large.rows(); ++i) {
+    for (int j = 0; j < large.cols(); ++j) {
+      fprintf(fp, "%.*g%c", j == 0 ? 6 : 17, large(i,j),
+              j == large.cols() - 1 ? '\n' : ' ');
+    }
+    // Blank lines in some of the chunks.
+    if (i % 30000 == 0)   fprintf(fp, "\n");
+  }
+  fclose(fp);
+  m2 = MatrixXdFromTextFile(textFile);
+  CHECK_EQ(m2.rows(), large.rows());
+  CHECK_EQ(m2.cols(), large.cols());
+  for (int i = 0; i < large.rows(); ++i) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.6g", large(i,0));
+    large(i,0) = strtod(buffer, NULL);
+  }
+  CHECK((m2.array() == large.array()).all());
+
+  // Written text files are read back exactly, with the shortest digits.
+  large(0,0) = 0.1;
+  large(1,1) = -1e300;
+  large(2,2) = 5e-324;
+  WriteMatrixToTextFile(textFile, large);
+  m2 = MatrixXdFromTextFile(textFile);
+  CHECK_EQ(m2.rows(), large.rows());
+  CHECK((m2.array() == large.array()).all());
+  string written = FileIO::ReadWholeFileToString(textFile);
+  CHECK_EQ(written.substr(0, written.find(' ')), string("0.1"));
+  WriteMatrixToTextFile(textFile, m1);
+  CHECK_EQ(FileIO::ReadWholeFileToString(textFile), string("1 2 3\n4 5 6\n"));
+  WriteMatrixToTextFile(textFile, v1);
+  CHECK(VectorXdFromTextFile(textFile) == v1);
+  remove(textFile);
+
+  // .npy files in both storage orders.
+  const char* npyFile = "/tmp/xyUtils_EigenUtilsTest.npy";
+  MatrixXd md = RandnMatrixXd(5, 3, 1);
+  WriteNpyFile(npyFile, md);
+  CHECK((ReadNpyFile<MatrixXd>(npyFile).array() == md.array()).all());
+  rMatrixXd rmd = ReadNpyFile<rMatrixXd>(npyFile);
+  CHECK((rmd.array() == md.array()).all());
+  {
+    MappedNpyFile<MatrixXd> mapped(npyFile);
+    CHECK(mapped.header().fortranOrder);
+    CHECK((mapped.map().array() == md.array()).all());
+  }
+  WriteNpyFile(npyFile, rmd);
+  CHECK((ReadNpyFile<MatrixXd>(npyFile).array() == md.array()).all());
+  {
+    MappedNpyFile<rMatrixXd> mapped(npyFile);
+    CHECK(!mapped.header().fortranOrder);
+    CHECK((mapped.map().array() == md.array()).all());
+  }
+  // The header is the same as NumPy's.
+  rMatrixXd r23(2, 3);
+  r23 << 0, 1, 2, 3, 4, 5;
+  WriteNpyFile(npyFile, r23);
+  std::string content = FileIO::ReadWholeFileToString(npyFile);
+  CHECK_EQ(content.size(), 128 + 6 * sizeof(double));
+  CHECK_EQ(content.substr(0, 70), string("\x93NUMPY\x01\x00v\x00{'descr': "
+      "'<f8', 'fortran_order': False, 'shape': (2, 3), } ", 70));
+  CHECK_EQ(content[127], '\n');
+  // Expressions, other scalar types, fixed sizes and vectors.
+  WriteNpyFile(npyFile, md.cast<float>() * 2);
+  CHECK((ReadNpyFile<MatrixXf>(npyFile).array() ==
+         (md.cast<float>() * 2).array()).all());
+  typedef Matrix<int64_t, Dynamic, Dynamic> MatrixXi64;
+  MatrixXi64 mi = (md * 1e12).cast<int64_t>().transpose();
+  WriteNpyFile(npyFile, mi);
+  CHECK(ReadNpyFile<MatrixXi64>(npyFile) == mi);
+  Matrix3i m3 = Matrix3i::Random();
+  WriteNpyFile(npyFile, m3);
+  CHECK(ReadNpyFile<Matrix3i>(npyFile) == m3);
+  CHECK(ReadNpyFile<rMatrixXi>(npyFile) == m3);
+  typedef Matrix<uint8_t, Dynamic, 1> VectorXu8;
+  typedef Matrix<uint8_t, 1, Dynamic> RowVectorXu8;
+  VectorXu8 vu(4);
+  vu << 0, 1, 128, 255;
+  WriteNpyFile(npyFile, vu);
+  CHECK_EQ(ReadNpyHeader(npyFile).shape.size(), 1);
+  CHECK(ReadNpyFile<VectorXu8>(npyFile) == vu);
+  CHECK(ReadNpyFile<RowVectorXu8>(npyFile) == vu.transpose());
+  CHECK(MappedNpyFile<RowVectorXu8>(npyFile).map() == vu.transpose());
+  // Big endian data, as written on another machine.
+  {
+    NpyHeader header;
+    header.descr = ">i4";
+    header.fortranOrder = false;
+    header.shape.push_back(3);
+    FileIO::BinaryWriter writer(npyFile, FileIO::BigEndian);
+    WriteNpyHeader(header, &writer);
+    int32_t values[] = {1, -2, 300000};
+    writer.Write(values, 3);
+  }
+  CHECK(ReadNpyFile<Vector3i>(npyFile) == Vector3i(1, -2, 300000));
+  // Headers written by Python 2.
+  std::string py2("\x93NUMPY\x01\x00\x46\x00", 10);
+  py2 += "{'descr': '<f4', 'fortran_order': True, 'shape': (2L, 3L), }";
+  py2.resize(10 + 0x46 - 1, ' ');
+  py2.push_back('\n');
+  NpyHeader header = ParseNpyHeader("py2", py2.data(), py2.size());
+  CHECK_EQ(header.descr, string("<f4"));
+  CHECK(header.fortranOrder);
+  CHECK_EQ(header.shape.size(), 2);
+  CHECK_EQ(header.shape[0], 2);
+  CHECK_EQ(header.shape[1], 3);
+  CHECK_EQ(header.dataOffset, 10 + 0x46);
+  remove(npyFile);
+
+  LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
   return 0;
 }
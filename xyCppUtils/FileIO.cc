@@ -5,17 +5,60 @@
   * Created: Apr 30, 2013.
   */
 
+// Use 64-bit file offsets on 32-bit systems too.
+#define _FILE_OFFSET_BITS 64
+
 #include "FileIO.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdio>
 #include <cstring>
 #include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "LogAndCheck.h"
 
 namespace xyUtils  {
 namespace FileIO {
 
+namespace {
+// Size of the chunks read by 'FilteredLineReader'.
+const size_t kFilteredReadSize = 1 << 16;
+
+}   // namespace
+
+// The size of a regular file is known from fstat, so that it is read with a
+// single (unbuffered) read in most cases.
+void ReadRestOfFile(FILE* fp, std::string* str) {
+  size_t size = 0;
+  struct stat st;
+  long pos = ftell(fp);
+  if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) && pos >= 0 &&
+      pos < st.st_size) {
+    size = st.st_size - pos;
+  }
+  // One more byte to detect the end of file without another allocation.
+  str->resize(size + 1);
+  size = 0;
+  for (;;) {
+    if (size == str->size())   str->resize(2 * size + 4096);
+    size_t nRead = fread(&(*str)[size], 1, str->size() - size, fp);
+    size += nRead;
+    if (nRead == 0 || size < str->size()) {
+      if (ferror(fp)) {
+        perror(NULL);
+        LOG(FATAL) << "Error on reading file.";
+      }
+      if (feof(fp))   break;
+    }
+  }
+  str->resize(size);
+}
+
 std::string ReadWholeFileToString(const char* filename) {
   FILE* fp = fopen(filename, "r");
   if (fp == NULL) {
@@ -27,17 +70,8 @@ std::string ReadWholeFileToString(const char* filename) {
 
 std::string ReadRestOfFileToString(FILE* fp) {
   CHECK(fp);
-  const int kBufSize = 4096;
-  char buffer[kBufSize];
   std::string str;
-  int nRead;
-  while ((nRead = fread(buffer, 1, kBufSize, fp)) > 0) {
-    if (ferror(fp)) {
-      perror(NULL);
-      LOG(FATAL) << "Error on reading file.";
-    }
-    str.append(buffer, nRead);
-  }
+  ReadRestOfFile(fp, &str);
   fclose(fp);
   return str;
 }
@@ -58,9 +92,335 @@ std::string ReadLineToString(FILE* fp) {
         return str;
       }
     }
-    str.append(buffer, strlen(buffer));
-  } while ((strlen(buffer) == kBufSize) && (buffer[kBufSize-2] != '\n'));
-  return str;
+    size_t len = strlen(buffer);
+    str.append(buffer, len);
+    // Continue if the buffer was filled before the end of the line.
+    if (len < kBufSize - 1 || buffer[len-1] == '\n')   return str;
+  } while (true);
+}
+
+std::vector<const char*> SplitIntoLineChunks(StringView text,
+                                             size_t chunkSize) {
+  const char* end = text.end();
+  std::vector<const char*> chunks(1, text.begin());
+  while (size_t(end - chunks.back()) > chunkSize) {
+    const char* p = static_cast<const char*>(
+        memchr(chunks.back() + chunkSize, '\n',
+               end - chunks.back() - chunkSize));
+    if (!p || p + 1 == end)   break;
+    chunks.push_back(p + 1);
+  }
+  chunks.push_back(end);
+  return chunks;
+}
+
+FilteredLineReader::FilteredLineReader(const char* filename,
+                                       StringUtils::CommentStyle style)
+    : fp_(fopen(filename, "r")), filter_(style), chunk_(kFilteredReadSize, ' '),
+      pos_(0), eof_(false) {
+  if (fp_ == NULL) {
+    perror(filename);
+    LOG(FATAL) << "Error on opening file " << filename;
+  }
+}
+
+FilteredLineReader::~FilteredLineReader() {
+  fclose(fp_);
+}
+
+bool FilteredLineReader::Next(StringView* line) {
+  for (;;) {
+    const char* begin = text_.data() + pos_;
+    const char* eol = static_cast<const char*>(
+        memchr(begin, '\n', text_.size() - pos_));
+    if (eol) {
+      pos_ = eol + 1 - text_.data();
+      *line = StringUtils::StripWhiteSpace(StringView(begin, eol - begin));
+      if (!line->empty())   return true;
+    } else if (eof_) {
+      // The last line without '\n'.
+      *line = StringUtils::StripWhiteSpace(
+          StringView(begin, text_.size() - pos_));
+      pos_ = text_.size();
+      return !line->empty();
+    } else {
+      // Keep the incomplete line and read more of it.
+      text_.erase(0, pos_);
+      pos_ = 0;
+      ReadChunk();
+    }
+  }
+}
+
+void FilteredLineReader::ReadChunk() {
+  size_t nRead = fread(&chunk_[0], 1, chunk_.size(), fp_);
+  filter_.Filter(StringView(chunk_.data(), nRead), &text_);
+  if (nRead < chunk_.size()) {
+    if (ferror(fp_)) {
+      perror(NULL);
+      LOG(FATAL) << "Error on reading file.";
+    }
+    if (feof(fp_)) {
+      filter_.Finish(&text_);
+      eof_ = true;
+    }
+  }
+}
+
+MappedFile::MappedFile(const char* filename, AccessPattern access)
+    : data_(NULL), size_(0), mapped_(false) {
+  Open(filename, access);
+}
+
+MappedFile::MappedFile(const std::string& filename, AccessPattern access)
+    : data_(NULL), size_(0), mapped_(false) {
+  Open(filename.c_str(), access);
+}
+
+MappedFile::~MappedFile() {
+  if (mapped_)   munmap(const_cast<char*>(data_), size_);
+}
+
+void MappedFile::Open(const char* filename, AccessPattern access) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    perror(filename);
+    LOG(FATAL) << "Error on opening file " << filename;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      int advice = access == SequentialAccess ? MADV_SEQUENTIAL :
+          access == RandomAccess ? MADV_RANDOM : MADV_NORMAL;
+      madvise(addr, st.st_size, advice);
+      data_ = static_cast<const char*>(addr);
+      size_ = st.st_size;
+      mapped_ = true;
+      close(fd);
+      return;
+    }
+  }
+  FILE* fp = fdopen(fd, "r");
+  CHECK(fp);
+  ReadRestOfFile(fp, &buffer_);
+  fclose(fp);
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+}
+
+void SwapBytes(void* data, size_t n, size_t elemSize) {
+  char* p = static_cast<char*>(data);
+  switch (elemSize) {
+    case 1:
+      break;
+    case 2:
+      for (size_t i = 0; i < n; ++i, p += 2) {
+        uint16_t v;
+        memcpy(&v, p, 2);
+        v = __builtin_bswap16(v);
+        memcpy(p, &v, 2);
+      }
+      break;
+    case 4:
+      for (size_t i = 0; i < n; ++i, p += 4) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        v = __builtin_bswap32(v);
+        memcpy(p, &v, 4);
+      }
+      break;
+    case 8:
+      for (size_t i = 0; i < n; ++i, p += 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        v = __builtin_bswap64(v);
+        memcpy(p, &v, 8);
+      }
+      break;
+    default:
+      for (size_t i = 0; i < n; ++i, p += elemSize) {
+        std::reverse(p, p + elemSize);
+      }
+  }
+}
+
+BinaryReader::BinaryReader(const char* filename, ByteOrder byteOrder,
+                           size_t bufferSize)
+    : filename_(filename), byteOrder_(byteOrder), buffer_(bufferSize),
+      bufPos_(0), bufEnd_(0), filePos_(0), size_(0) {
+  CHECK_GT(bufferSize, 0u);
+  fd_ = open(filename, O_RDONLY);
+  if (fd_ < 0) {
+    perror(filename);
+    LOG(FATAL) << "Error on opening file " << filename;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    perror(filename);
+    LOG(FATAL) << "Error on getting the size of file " << filename;
+  }
+  size_ = st.st_size;
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+BinaryReader::~BinaryReader() {
+  close(fd_);
+}
+
+size_t BinaryReader::ReadFromFile(char* data, size_t n) {
+  size_t total = 0;
+  while (total < n) {
+    ssize_t nRead = read(fd_, data + total, n - total);
+    if (nRead < 0) {
+      if (errno == EINTR)   continue;
+      perror(filename_.c_str());
+      LOG(FATAL) << "Error on reading file " << filename_;
+    }
+    if (nRead == 0)   break;
+    total += nRead;
+  }
+  filePos_ += total;
+  return total;
+}
+
+size_t BinaryReader::ReadBytes(void* data, size_t n) {
+  char* dst = static_cast<char*>(data);
+  size_t total = 0;
+  while (total < n) {
+    if (bufPos_ == bufEnd_) {
+      // Large reads bypass the buffer, which is then empty at 'filePos_'.
+      if (n - total >= buffer_.size()) {
+        bufPos_ = bufEnd_ = 0;
+        total += ReadFromFile(dst + total, n - total);
+        break;
+      }
+      bufPos_ = 0;
+      bufEnd_ = ReadFromFile(buffer_.data(), buffer_.size());
+      if (bufEnd_ == 0)   break;
+    }
+    size_t m = std::min(n - total, bufEnd_ - bufPos_);
+    memcpy(dst + total, buffer_.data() + bufPos_, m);
+    bufPos_ += m;
+    total += m;
+  }
+  return total;
+}
+
+void BinaryReader::Seek(int64_t offset) {
+  CHECK_GE(offset, 0);
+  // Stay in the buffer if possible.
+  int64_t bufStart = filePos_ - int64_t(bufEnd_);
+  if (offset >= bufStart && offset <= filePos_) {
+    bufPos_ = offset - bufStart;
+    return;
+  }
+  if (lseek(fd_, offset, SEEK_SET) < 0) {
+    perror(filename_.c_str());
+    LOG(FATAL) << "Error on seeking to " << offset << " in file " << filename_;
+  }
+  filePos_ = offset;
+  bufPos_ = bufEnd_ = 0;
+}
+
+void BinaryReader::WillNeed(int64_t offset, int64_t length) {
+#ifdef POSIX_FADV_WILLNEED
+  posix_fadvise(fd_, offset, length, POSIX_FADV_WILLNEED);
+#endif
+}
+
+BinaryWriter::BinaryWriter(const char* filename, ByteOrder byteOrder,
+                           size_t bufferSize)
+    : filename_(filename), byteOrder_(byteOrder), buffer_(bufferSize),
+      bufEnd_(0), filePos_(0) {
+  CHECK_GT(bufferSize, 0u);
+  fd_ = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd_ < 0) {
+    perror(filename);
+    LOG(FATAL) << "Error on opening file " << filename << " for writing.";
+  }
+}
+
+BinaryWriter::~BinaryWriter() {
+  if (fd_ >= 0)   Close();
+}
+
+void BinaryWriter::WriteToFile(const char* data, size_t n) {
+  CHECK_GE(fd_, 0);
+  size_t total = 0;
+  while (total < n) {
+    ssize_t nWritten = write(fd_, data + total, n - total);
+    if (nWritten < 0) {
+      if (errno == EINTR)   continue;
+      perror(filename_.c_str());
+      LOG(FATAL) << "Error on writing file " << filename_;
+    }
+    total += nWritten;
+  }
+  filePos_ += n;
+}
+
+void BinaryWriter::WriteBytes(const void* data, size_t n) {
+  CHECK_GE(fd_, 0);
+  const char* src = static_cast<const char*>(data);
+  if (bufEnd_ + n > buffer_.size()) {
+    Flush();
+    // Large writes bypass the buffer.
+    if (n >= buffer_.size()) {
+      WriteToFile(src, n);
+      return;
+    }
+  }
+  memcpy(buffer_.data() + bufEnd_, src, n);
+  bufEnd_ += n;
+}
+
+void BinaryWriter::WriteSwapped(const char* data, size_t n, size_t elemSize) {
+  CHECK_GE(fd_, 0);
+  // Convert in the buffer, a chunk of whole values at a time.
+  size_t chunk = std::max(buffer_.size() / elemSize, size_t(1));
+  if (chunk * elemSize > buffer_.size())   buffer_.resize(chunk * elemSize);
+  while (n > 0) {
+    size_t m = std::min(n, (buffer_.size() - bufEnd_) / elemSize);
+    if (m == 0) {
+      Flush();
+      continue;
+    }
+    memcpy(buffer_.data() + bufEnd_, data, m * elemSize);
+    SwapBytes(buffer_.data() + bufEnd_, m, elemSize);
+    bufEnd_ += m * elemSize;
+    data += m * elemSize;
+    n -= m;
+  }
+}
+
+void BinaryWriter::Seek(int64_t offset) {
+  CHECK_GE(offset, 0);
+  Flush();
+  if (lseek(fd_, offset, SEEK_SET) < 0) {
+    perror(filename_.c_str());
+    LOG(FATAL) << "Error on seeking to " << offset << " in file " << filename_;
+  }
+  filePos_ = offset;
+}
+
+void BinaryWriter::Flush() {
+  if (bufEnd_ > 0) {
+    size_t n = bufEnd_;
+    bufEnd_ = 0;
+    WriteToFile(buffer_.data(), n);
+  }
+}
+
+void BinaryWriter::Close() {
+  Flush();
+  if (close(fd_) != 0) {
+    perror(filename_.c_str());
+    LOG(FATAL) << "Error on closing file " << filename_;
+  }
+  fd_ = -1;
 }
 
 }   // namespace FileIO
@@ -9,7 +9,21 @@
 #define __XYUTILS_FILE_IO_H__
 
 #include <cstdio>
+#include <cstring>
 #include <string>
+#include <vector>
+
+#include <type_traits>
+
+#ifdef __USE_TR1__
+#include <tr1/cstdint>
+#else
+#include <cstdint>
+#endif
+
+#include "LogAndCheck.h"
+#include "StringUtils.h"
+#include "StringView.h"
 
 namespace xyUtils  {
 namespace FileIO {
@@ -17,8 +31,10 @@ namespace FileIO {
 // Read the content of the file 'filename' into a single string.
 std::string ReadWholeFileToString(const char* filename);
 
-// Read the rest of file 'fp' into a single string.
+// Read the rest of file 'fp' into a single string, and close 'fp'.
 std::string ReadRestOfFileToString(FILE* fp);
+// Same as above, into 'str', without closing 'fp'.
+void ReadRestOfFile(FILE* fp, std::string* str);
 
 // Read one line of the file 'fp' into a string. The return value will contain
 // at least an '\n' character if the read is successful, and will be an empty
@@ -36,7 +52,264 @@ std::string ReadRestOfFileToString(FILE* fp);
 //   }
 //   fclose(fp);
 std::string ReadLineToString(FILE* fp);
-  
+
+// The whole content of a file as a read-only buffer. A regular file is mapped
+// into memory, so that no copy is made and only the touched pages are read.
+// Other files (e.g. pipes), or when the mapping fails, are read into an owned
+// buffer, with a single read sized by fstat when possible. The 'access' pattern
+// is passed to the kernel as a hint for the read ahead of a mapped file. Example
+// usage:
+//   FileIO::MappedFile file("/path/to/file");
+//   FileIO::LineIterator it(file);
+//   StringView line;
+//   while (it.Next(&line)) {
+//     /* Some code to process 'line', which is valid while 'file' is alive. */
+//   }
+class MappedFile {
+ public:
+  // How the content will be read: front to back (e.g. parsing text), at
+  // scattered places (e.g. lookups in a table), or no particular pattern.
+  enum AccessPattern { SequentialAccess, RandomAccess, NormalAccess };
+
+  // Open 'filename', or LOG(FATAL) if failed.
+  explicit MappedFile(const char* filename,
+                      AccessPattern access = SequentialAccess);
+  explicit MappedFile(const std::string& filename,
+                      AccessPattern access = SequentialAccess);
+  ~MappedFile();
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  StringView view() const { return StringView(data_, size_); }
+  // Whether the content is mapped rather than read into a buffer.
+  bool mapped() const { return mapped_; }
+ private:
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+  void Open(const char* filename, AccessPattern access);
+
+  const char* data_;
+  size_t size_;
+  bool mapped_;
+  std::string buffer_;    // The content if not mapped.
+};
+
+// Iterate over the lines of a buffer, yielding views into it. Each line is
+// without its '\n', and the last line is yielded even if it does not end with a
+// '\n'. The line ends are found with memchr.
+class LineIterator {
+ public:
+  LineIterator(const char* data, size_t size)
+      : pos_(data), end_(data + size), lineNumber_(0) { }
+  explicit LineIterator(StringView text)
+      : pos_(text.data()), end_(text.data() + text.size()), lineNumber_(0) { }
+  explicit LineIterator(const MappedFile& file)
+      : pos_(file.data()), end_(file.data() + file.size()), lineNumber_(0) { }
+
+  // Get the next line, or return false at the end of the buffer.
+  bool Next(StringView* line);
+  // Number of the last line returned by 'Next', starting from 1.
+  int lineNumber() const { return lineNumber_; }
+  // The rest of the buffer after the last line returned by 'Next'.
+  StringView rest() const { return StringView(pos_, end_ - pos_); }
+ private:
+  const char* pos_;
+  const char* end_;
+  int lineNumber_;
+};
+
+inline bool LineIterator::Next(StringView* line) {
+  if (pos_ == end_)   return false;
+  const char* eol = static_cast<const char*>(memchr(pos_, '\n', end_ - pos_));
+  if (eol) {
+    *line = StringView(pos_, eol - pos_);
+    pos_ = eol + 1;
+  } else {
+    *line = StringView(pos_, end_ - pos_);
+    pos_ = end_;
+  }
+  ++lineNumber_;
+  return true;
+}
+
+// Split 'text' into chunks of about 'chunkSize' bytes (or more, to end at a
+// line end), e.g. to be parsed by several threads. Chunk i is the text from
+// element i to element i+1 of the result, which has at least 2 elements.
+std::vector<const char*> SplitIntoLineChunks(StringView text, size_t chunkSize);
+
+// Read the lines of a text file in chunks, with the comments of 'style'
+// stripped (see StringUtils::CommentFilter) and the white space around each
+// line trimmed, skipping the lines left empty. Only a chunk and the current
+// line are kept in memory, however large the file is. Example usage:
+//   FileIO::FilteredLineReader reader("/path/to/file",
+//                                     StringUtils::ShellComment);
+//   StringView line;
+//   while (reader.Next(&line)) {
+//     /* Some code to process 'line', which is valid until the next call. */
+//   }
+class FilteredLineReader {
+ public:
+  FilteredLineReader(const char* filename, StringUtils::CommentStyle style);
+  ~FilteredLineReader();
+
+  // Get the next non-empty line, or return false at the end of the file.
+  bool Next(StringView* line);
+ private:
+  FilteredLineReader(const FilteredLineReader&);
+  FilteredLineReader& operator=(const FilteredLineReader&);
+  // Read and filter the next chunk of the file to the end of 'text_'.
+  void ReadChunk();
+
+  FILE* fp_;
+  StringUtils::CommentFilter filter_;
+  std::string chunk_;
+  std::string text_;      // The filtered text, with the lines before 'pos_'
+  size_t pos_;            // already returned.
+  bool eof_;
+};
+
+// Byte order of the multi-byte values in a binary file.
+enum ByteOrder { LittleEndian, BigEndian };
+
+// Byte order of this machine.
+inline ByteOrder NativeByteOrder() {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return BigEndian;
+#else
+  return LittleEndian;
+#endif
+}
+
+// Reverse the bytes of each of the 'n' values of 'elemSize' bytes in 'data'.
+void SwapBytes(void* data, size_t n, size_t elemSize);
+
+// Buffered reader of binary files, including files larger than 2 GB. Values
+// are converted from the byte order of the file. Any error, including reading
+// past the end of file with 'Read', is a LOG(FATAL). Example usage:
+//   FileIO::BinaryReader reader("/path/to/file", FileIO::BigEndian);
+//   int32_t n = reader.Read<int32_t>();
+//   std::vector<double> values(n);
+//   reader.Read(values.data(), n);
+class BinaryReader {
+ public:
+  // Open 'filename', telling the kernel that it will be read sequentially.
+  // Reads of at least 'bufferSize' bytes go directly to the destination.
+  explicit BinaryReader(const char* filename,
+                        ByteOrder byteOrder = LittleEndian,
+                        size_t bufferSize = 1 << 20);
+  ~BinaryReader();
+
+  // Read 'n' values into 'values'.
+  template <typename T>
+  void Read(T* values, size_t n);
+  template <typename T>
+  T Read() {
+    T value;
+    Read(&value, 1);
+    return value;
+  }
+  // Read at most 'n' bytes without conversion, and return the number of bytes
+  // read, which is less than 'n' only at the end of file.
+  size_t ReadBytes(void* data, size_t n);
+
+  // Current position, and move to 'offset' bytes from the beginning.
+  int64_t Tell() const { return filePos_ - (bufEnd_ - bufPos_); }
+  void Seek(int64_t offset);
+  // Size of the file in bytes.
+  int64_t size() const { return size_; }
+  bool eof() const { return Tell() >= size_; }
+  // Hint the kernel to start reading 'length' bytes from 'offset' ahead, e.g.
+  // before seeking there.
+  void WillNeed(int64_t offset, int64_t length);
+
+  ByteOrder byteOrder() const { return byteOrder_; }
+  void SetByteOrder(ByteOrder byteOrder) { byteOrder_ = byteOrder; }
+ private:
+  BinaryReader(const BinaryReader&);
+  BinaryReader& operator=(const BinaryReader&);
+  // Read from the file to 'data' until 'n' bytes or the end of file.
+  size_t ReadFromFile(char* data, size_t n);
+
+  std::string filename_;
+  int fd_;
+  ByteOrder byteOrder_;
+  std::vector<char> buffer_;
+  size_t bufPos_, bufEnd_;    // The unread bytes of 'buffer_'.
+  int64_t filePos_;           // File position of 'buffer_[bufEnd_]'.
+  int64_t size_;
+};
+
+// Buffered writer of binary files, the counterpart of 'BinaryReader'. The file
+// is truncated on opening, and flushed and closed on destruction.
+class BinaryWriter {
+ public:
+  explicit BinaryWriter(const char* filename,
+                        ByteOrder byteOrder = LittleEndian,
+                        size_t bufferSize = 1 << 20);
+  ~BinaryWriter();
+
+  // Write the 'n' values of 'values'.
+  template <typename T>
+  void Write(const T* values, size_t n);
+  template <typename T>
+  void Write(const T& value) {
+    Write(&value, 1);
+  }
+  // Write 'n' bytes without conversion.
+  void WriteBytes(const void* data, size_t n);
+
+  int64_t Tell() const { return filePos_ + bufEnd_; }
+  // Move to 'offset' bytes from the beginning, which could be past the end of
+  // file (leaving a hole of zeros).
+  void Seek(int64_t offset);
+  // Write the buffer to the file.
+  void Flush();
+  // Flush and close the file. No more writes are allowed.
+  void Close();
+
+  ByteOrder byteOrder() const { return byteOrder_; }
+  void SetByteOrder(ByteOrder byteOrder) { byteOrder_ = byteOrder; }
+ private:
+  BinaryWriter(const BinaryWriter&);
+  BinaryWriter& operator=(const BinaryWriter&);
+  // Write 'n' values of 'elemSize' bytes with their bytes reversed.
+  void WriteSwapped(const char* data, size_t n, size_t elemSize);
+  void WriteToFile(const char* data, size_t n);
+
+  std::string filename_;
+  int fd_;
+  ByteOrder byteOrder_;
+  std::vector<char> buffer_;
+  size_t bufEnd_;             // Number of bytes in 'buffer_'.
+  int64_t filePos_;           // File position of 'buffer_[0]'.
+};
+
+// ================================================================
+// Implementation for templated functions.
+// ================================================================
+template <typename T>
+void BinaryReader::Read(T* values, size_t n) {
+  static_assert(std::is_arithmetic<T>::value, "Only arithmetic types.");
+  size_t nBytes = n * sizeof(T);
+  if (ReadBytes(values, nBytes) != nBytes) {
+    LOG(FATAL) << "Unexpected end of file " << filename_ << " when reading "
+               << n << " values of " << sizeof(T) << " bytes.";
+  }
+  if (sizeof(T) > 1 && byteOrder_ != NativeByteOrder()) {
+    SwapBytes(values, n, sizeof(T));
+  }
+}
+
+template <typename T>
+void BinaryWriter::Write(const T* values, size_t n) {
+  static_assert(std::is_arithmetic<T>::value, "Only arithmetic types.");
+  if (sizeof(T) > 1 && byteOrder_ != NativeByteOrder()) {
+    WriteSwapped(reinterpret_cast<const char*>(values), n, sizeof(T));
+  } else {
+    WriteBytes(values, n * sizeof(T));
+  }
+}
+
 }   // namespace FileIO
 }   // namespace xyUtils
 
@@ -0,0 +1,102 @@
+/**
+  * Benchmarks for file I/O.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "FileIO.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CommandLineFlags.h"
+#include "LogAndCheck.h"
+#include "StringView.h"
+
+using namespace std;
+using namespace xyUtils;
+
+int main(int argc, char** argv)  {
+  CommandLineFlagsInit(&argc, &argv, true);
+  BenchmarkSuite suite("FileIO");
+
+  // Generated text file of about 64 MB.
+  const int numLines = 1000000;
+  const char* filename = "/tmp/xyUtils_FileIOBench.txt";
+  FILE* fp = fopen(filename, "w");
+  CHECK(fp);
+  for (int i = 0; i < numLines; ++i) {
+    fprintf(fp, "%d 0.%09d 1.%09d 2.%09d %s\n", i, i, 2*i, 3*i,
+            i % 10 ? "x" : "a somewhat longer line");
+  }
+  fclose(fp);
+  double bytes = FileIO::ReadWholeFileToString(filename).size();
+
+  size_t total = 0;
+  if (suite.Run("ReadWholeFileToString", [&]() {
+        total = FileIO::ReadWholeFileToString(filename).size();
+      }, bytes)) {
+    CHECK_EQ(double(total), bytes);
+  }
+  if (suite.Run("ReadLineToString", [&]() {
+        FILE* fp = fopen(filename, "r");
+        total = 0;
+        string line = FileIO::ReadLineToString(fp);
+        while (!line.empty()) {
+          total += line.size();
+          line = FileIO::ReadLineToString(fp);
+        }
+        fclose(fp);
+      }, bytes, numLines)) {
+    CHECK_EQ(double(total), bytes);
+  }
+  if (suite.Run("MappedFile/LineIterator", [&]() {
+        FileIO::MappedFile file(filename);
+        FileIO::LineIterator it(file);
+        StringView line;
+        total = 0;
+        while (it.Next(&line))   total += line.size() + 1;
+      }, bytes, numLines)) {
+    CHECK_EQ(double(total), bytes);
+  }
+  remove(filename);
+
+  // Binary files of 8M doubles, in native and swapped byte order.
+  const char* binFile = "/tmp/xyUtils_FileIOBench.bin";
+  const size_t numValues = 8 << 20;
+  vector<double> values(numValues, 1.5), values2(numValues);
+  const char* orderNames[] = {"Native", "Swapped"};
+  {
+    FileIO::BinaryWriter writer(binFile);
+    writer.Write(values.data(), numValues);
+  }
+  for (int i = 0; i < 2; ++i) {
+    FileIO::ByteOrder order = FileIO::NativeByteOrder();
+    if (i == 1) {
+      order = order == FileIO::LittleEndian ? FileIO::BigEndian
+                                            : FileIO::LittleEndian;
+    }
+    suite.Run((string("BinaryWriter/") + orderNames[i]).c_str(), [&]() {
+        FileIO::BinaryWriter writer(binFile, order);
+        // Many small writes through the buffer.
+        for (size_t j = 0; j < numValues; j += 1024) {
+          writer.Write(&values[j], 1024);
+        }
+      }, numValues * 8.0, numValues);
+    if (suite.Run((string("BinaryReader/") + orderNames[i]).c_str(), [&]() {
+          FileIO::BinaryReader reader(binFile, order);
+          for (size_t j = 0; j < numValues; j += 1024) {
+            reader.Read(&values2[j], 1024);
+          }
+        }, numValues * 8.0, numValues)) {
+      CHECK(values2 == values);
+    }
+  }
+  remove(binFile);
+
+  suite.Finish();
+  return 0;
+}
@@ -8,9 +8,15 @@
 #include "FileIO.h"
 
 #include <cstdio>
+#include <cmath>
 #include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
 
 #include "LogAndCheck.h"
+#include "StringUtils.h"
+#include "StringView.h"
 #include "Timer.h"
 
 using namespace xyUtils;
@@ -35,6 +41,224 @@ int main()  {
   CHECK_EQ(index, texts.size());
   fclose(fp);
 
+  // Memory mapped file, and iterate over its lines.
+  FileIO::MappedFile mappedFile(filename);
+  CHECK(mappedFile.mapped());
+  CHECK(mappedFile.view() == StringView(texts));
+  FileIO::LineIterator lineIt(mappedFile);
+  StringView lineView;
+  index = 0;
+  while (lineIt.Next(&lineView)) {
+    CHECK(lineView == StringView(texts).substr(index, lineView.size()));
+    index += lineView.size();
+    CHECK_EQ(texts[index], '\n');
+    ++index;
+  }
+  CHECK_EQ(index, texts.size());
+  CHECK_GT(lineIt.lineNumber(), 1);
+  // The access pattern is only a hint, the content is the same.
+  FileIO::MappedFile randomFile(filename, FileIO::MappedFile::RandomAccess);
+  CHECK(randomFile.mapped());
+  CHECK(randomFile.view() == StringView(texts));
+  FileIO::MappedFile normalFile(filename, FileIO::MappedFile::NormalAccess);
+  CHECK(normalFile.view() == StringView(texts));
+
+  // Long lines, empty lines, and no '\n' at the end of file.
+  const char* tmpFile = "/tmp/xyUtils_FileIOTest.txt";
+  std::vector<std::string> lines;
+  lines.push_back(std::string(1022, 'a'));
+  lines.push_back(std::string(1023, 'b'));
+  lines.push_back("");
+  lines.push_back(std::string(5000, 'c'));
+  lines.push_back("last");
+  fp = fopen(tmpFile, "w");
+  for (size_t i = 0; i < lines.size(); ++i) {
+    fprintf(fp, "%s%s", lines[i].c_str(), i + 1 < lines.size() ? "\n" : "");
+  }
+  fclose(fp);
+  fp = fopen(tmpFile, "r");
+  for (size_t i = 0; i < lines.size(); ++i) {
+    CHECK_EQ(FileIO::ReadLineToString(fp),
+             lines[i] + (i + 1 < lines.size() ? "\n" : ""));
+  }
+  CHECK(FileIO::ReadLineToString(fp).empty());
+  fclose(fp);
+  {
+    FileIO::MappedFile file(tmpFile);
+    FileIO::LineIterator it(file);
+    for (size_t i = 0; i < lines.size(); ++i) {
+      CHECK(it.Next(&lineView));
+      CHECK_EQ(lineView.ToString(), lines[i]);
+      CHECK_EQ(it.lineNumber(), int(i + 1));
+    }
+    CHECK(!it.Next(&lineView));
+    CHECK(it.rest().empty());
+  }
+  // Read the rest after a partial buffered read.
+  fp = fopen(tmpFile, "r");
+  CHECK_EQ(fgetc(fp), 'a');
+  CHECK_EQ(FileIO::ReadRestOfFileToString(fp),
+           FileIO::ReadWholeFileToString(tmpFile).substr(1));
+  // Empty file.
+  fclose(fopen(tmpFile, "w"));
+  {
+    FileIO::MappedFile file(tmpFile);
+    CHECK_EQ(file.size(), 0u);
+    FileIO::LineIterator it(file);
+    CHECK(!it.Next(&lineView));
+  }
+  remove(tmpFile);
+
+  // A pipe cannot be mapped, and is read into a buffer instead.
+  int pipeFds[2];
+  CHECK_EQ(pipe(pipeFds), 0);
+  std::string pipeText;
+  for (int i = 0; i < 20000; ++i)   pipeText += "line in a pipe\n";
+  std::thread writer([&]() {
+      CHECK_EQ(write(pipeFds[1], pipeText.data(), pipeText.size()),
+               ssize_t(pipeText.size()));
+      close(pipeFds[1]);
+    });
+  char pipeName[64];
+  snprintf(pipeName, sizeof(pipeName), "/dev/fd/%d", pipeFds[0]);
+  {
+    FileIO::MappedFile file(pipeName);
+    CHECK(!file.mapped());
+    CHECK(file.view() == StringView(pipeText));
+  }
+  writer.join();
+  close(pipeFds[0]);
+
+  // Binary files in both byte orders, with small buffers to test the buffer
+  // boundaries.
+  const char* binFile = "/tmp/xyUtils_FileIOTest.bin";
+  std::vector<double> doubles(1000);
+  std::vector<int16_t> shorts(777);
+  for (size_t i = 0; i < doubles.size(); ++i)   doubles[i] = std::sqrt(i + 0.5);
+  for (size_t i = 0; i < shorts.size(); ++i)   shorts[i] = int16_t(i * 97 - 30000);
+  for (int order = 0; order < 2; ++order) {
+    FileIO::ByteOrder byteOrder = static_cast<FileIO::ByteOrder>(order);
+    {
+      FileIO::BinaryWriter writer(binFile, byteOrder, 13);
+      writer.Write<uint32_t>(0x01020304u);
+      writer.Write(doubles.data(), doubles.size());
+      writer.Write<uint8_t>(255);
+      writer.Write(shorts.data(), shorts.size());
+      writer.Write<float>(-1.25f);
+      writer.Write<int64_t>(-1234567890123LL);
+      CHECK_EQ(writer.Tell(), int64_t(4 + 8*1000 + 1 + 2*777 + 4 + 8));
+    }
+    std::string bytes = FileIO::ReadWholeFileToString(binFile);
+    CHECK_EQ(bytes.substr(0, 4),
+             std::string(byteOrder == FileIO::BigEndian ? "\x01\x02\x03\x04"
+                                                        : "\x04\x03\x02\x01"));
+    for (int bufferSize = 7; bufferSize <= 1 << 20; bufferSize *= 32) {
+      FileIO::BinaryReader reader(binFile, byteOrder, bufferSize);
+      CHECK_EQ(reader.size(), int64_t(bytes.size()));
+      CHECK_EQ(reader.Read<uint32_t>(), 0x01020304u);
+      std::vector<double> doubles2(doubles.size());
+      reader.Read(doubles2.data(), doubles2.size());
+      CHECK(doubles2 == doubles);
+      CHECK_EQ(reader.Read<uint8_t>(), 255);
+      std::vector<int16_t> shorts2(shorts.size());
+      reader.Read(shorts2.data(), shorts2.size());
+      CHECK(shorts2 == shorts);
+      CHECK_EQ(reader.Read<float>(), -1.25f);
+      CHECK_EQ(reader.Read<int64_t>(), -1234567890123LL);
+      CHECK(reader.eof());
+      char c;
+      CHECK_EQ(reader.ReadBytes(&c, 1), 0u);
+      // Seek back inside and outside of the buffer.
+      reader.Seek(4 + 8*999);
+      CHECK_EQ(reader.Read<double>(), doubles[999]);
+      reader.Seek(4 + 8*3);
+      CHECK_EQ(reader.Tell(), 4 + 8*3);
+      CHECK_EQ(reader.Read<double>(), doubles[3]);
+      reader.Seek(0);
+      CHECK_EQ(reader.ReadBytes(&c, 1), 1u);
+      CHECK_EQ(c, bytes[0]);
+    }
+  }
+  // Seek after a large read that bypassed the buffer, back to where the buffer
+  // was before it.
+  {
+    {
+      FileIO::BinaryWriter writer(binFile, FileIO::NativeByteOrder());
+      for (int32_t i = 0; i < 100; ++i)   writer.Write(i);
+    }
+    FileIO::BinaryReader reader(binFile, FileIO::NativeByteOrder(), 16);
+    int32_t values[40];
+    reader.Read(values, 2);
+    reader.Read(values, 2);
+    reader.Read(values, 40);
+    CHECK_EQ(values[39], 43);
+    CHECK_EQ(reader.Tell(), 44*4);
+    reader.Seek(41*4);
+    CHECK_EQ(reader.Read<int32_t>(), 41);
+    reader.Seek(2*4);
+    CHECK_EQ(reader.Read<int32_t>(), 2);
+  }
+  // Lines without comments and white space, read in chunks.
+  {
+    FILE* fp = fopen(tmpFile, "w");
+    CHECK(fp);
+    fprintf(fp, "  # Header.\n\n--a=1   # One.\n\t--b=2\n");
+    // Lines and comments across the chunks.
+    for (int i = 0; i < 20000; ++i) {
+      fprintf(fp, "value %d # comment %d\n  \n", i, i);
+    }
+    fprintf(fp, "last");
+    fclose(fp);
+    FileIO::FilteredLineReader reader(tmpFile, StringUtils::ShellComment);
+    StringView line;
+    CHECK(reader.Next(&line));
+    CHECK(line == "--a=1");
+    CHECK(reader.Next(&line));
+    CHECK(line == "--b=2");
+    for (int i = 0; i < 20000; ++i) {
+      CHECK(reader.Next(&line));
+      CHECK(line == StringUtils::PrintfToString("value %d", i));
+    }
+    CHECK(reader.Next(&line));
+    CHECK(line == "last");
+    CHECK(!reader.Next(&line));
+    CHECK(!reader.Next(&line));
+    // A C comment over many lines and chunks.
+    fp = fopen(tmpFile, "w");
+    CHECK(fp);
+    fprintf(fp, "a /*");
+    for (int i = 0; i < 100000; ++i)   fprintf(fp, " * line %d\n", i);
+    fprintf(fp, "*/ b\nc");
+    fclose(fp);
+    FileIO::FilteredLineReader cReader(tmpFile, StringUtils::CComment);
+    CHECK(cReader.Next(&line));
+    CHECK(line == "a  b");
+    CHECK(cReader.Next(&line));
+    CHECK(line == "c");
+    CHECK(!cReader.Next(&line));
+  }
+  remove(tmpFile);
+
+  // Files larger than 4 GB, with a hole to keep the test fast.
+  const int64_t largeOffset = (int64_t(1) << 32) + 12345;
+  {
+    FileIO::BinaryWriter writer(binFile);
+    writer.Write<int32_t>(42);
+    writer.Seek(largeOffset);
+    writer.Write<double>(2.5);
+    CHECK_EQ(writer.Tell(), largeOffset + 8);
+  }
+  {
+    FileIO::BinaryReader reader(binFile);
+    CHECK_EQ(reader.size(), largeOffset + 8);
+    CHECK_EQ(reader.Read<int32_t>(), 42);
+    reader.WillNeed(largeOffset, 8);
+    reader.Seek(largeOffset);
+    CHECK_EQ(reader.Read<double>(), 2.5);
+    CHECK(reader.eof());
+  }
+  remove(binFile);
+
   LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
   return 0;
 }
@@ -24,6 +24,7 @@
 #include "png.h"
 
 #include "LogAndCheck.h"
+#include "Profiler.h"
 
 namespace xyUtils  {
 
@@ -102,6 +102,7 @@ void Image<T>::LoadMetaFromJpegFile(const char* filename) {
 
 template<typename T>
 void Image<T>::LoadFromJpegFile(const char* filename) {
+  PROFILE_SCOPE("Image::LoadFromJpegFile");
   // Set parameters.
   struct jpeg_decompress_struct cinfo;
   struct jpeg_error_mgr jerr;
@@ -302,6 +303,7 @@ void Image<T>::ReadRGBPngData(const png_bytep* png_data, int bit_depth) {
 
 template<typename T>
 void Image<T>::LoadFromPngFile(const char* filename) {
+  PROFILE_SCOPE("Image::LoadFromPngFile");
   FILE* fp = fopen(filename, "rb");
   CHECK(fp);
   png_structp png_ptr = NULL;
@@ -378,6 +380,7 @@ void Image<T>::LoadMetaFromPpmFile(const char* filename) {
 
 template<typename T>
 void Image<T>::LoadFromPpmFile(const char* filename) {
+  PROFILE_SCOPE("Image::LoadFromPpmFile");
   FILE* fp = fopen(filename, "rb");
   CHECK(fp);
   LoadMetaFromPpmFileHelper(fp);
@@ -397,6 +400,7 @@ void Image<T>::LoadFromPpmFile(const char* filename) {
 // A specific (faster) implementation for unsigned char.
 template<>
 inline void Image<unsigned char>::LoadFromPpmFile(const char* filename) {
+  PROFILE_SCOPE("Image::LoadFromPpmFile");
   FILE* fp = fopen(filename, "rb");
   CHECK(fp);
   LoadMetaFromPpmFileHelper(fp);
@@ -0,0 +1,70 @@
+/**
+  * Benchmarks for images.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "Image.h"
+
+#include <cstdio>
+#include <string>
+
+#include "Benchmark.h"
+#include "CommandLineFlags.h"
+#include "LogAndCheck.h"
+
+using namespace std;
+using namespace xyUtils;
+
+namespace {
+// Benchmark loading 'filename' into images of types 'Image_8u' and 'Image_32f',
+// with the throughput in decoded pixels.
+void LoadBenchmarks(BenchmarkSuite* suite, const string& name,
+                    const string& filename) {
+  Image_8u image_8u;
+  image_8u.LoadMetaFromFile(filename);
+  double numPixels = double(image_8u.GetWidth()) * image_8u.GetHeight();
+  suite->Run((name + "/8u").c_str(), [&]() {
+      image_8u.LoadFromFile(filename);
+    }, numPixels * image_8u.GetNumChannels(), numPixels);
+  Image_32f image_32f;
+  suite->Run((name + "/32f").c_str(), [&]() {
+      image_32f.LoadFromFile(filename);
+    }, numPixels * image_8u.GetNumChannels() * sizeof(float), numPixels);
+}
+}   // namespace
+
+int main(int argc, char** argv)  {
+  CommandLineFlagsInit(&argc, &argv, true);
+  BenchmarkSuite suite("Image");
+
+  // Test data.
+  LoadBenchmarks(&suite, "LoadJpeg/testorig",
+                 "TestData/Images/libjpeg-testorig.jpg");
+  LoadBenchmarks(&suite, "LoadPng/basn2c16",
+                 "TestData/Images/pngsuite/basn2c16.png");
+  LoadBenchmarks(&suite, "LoadPpm/testimg",
+                 "TestData/Images/libjpeg-testimg.ppm");
+
+  // Generated large image.
+  const int width = 2048, height = 1536;
+  Image_8u large(width, height, 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        large.Pixel(x, y, c) = (x * (c+1) + y * (3-c) + x*y/64) & 0xff;
+      }
+    }
+  }
+  const string largeFile = "/tmp/xyUtils_ImageBench_large.jpg";
+  large.WriteToJpegFile(largeFile, 80);
+  suite.Run("WriteJpeg/2048x1536", [&]() {
+      large.WriteToJpegFile(largeFile, 80);
+    }, width * height * 3.0, width * height);
+  LoadBenchmarks(&suite, "LoadJpeg/2048x1536", largeFile);
+  remove(largeFile.c_str());
+
+  suite.Finish();
+  return 0;
+}
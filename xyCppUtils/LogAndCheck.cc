@@ -9,50 +9,277 @@
 
 #include"stdlib.h"
 
+#include<atomic>
+#include<chrono>
+#include<condition_variable>
 #include<iostream>
+#include<mutex>
 #include<ostream>
+#include<streambuf>
+#include<string>
+#include<thread>
+#include<vector>
 
 #ifdef __MATLAB__
 #include "mex.h"
 #endif
 
+#include "CommandLineFlags.h"
+
 using std::ostream;
 
 namespace xyUtils  {
 namespace __LogAndCheck__ {
-Log::Log(LogSeverity severity, const char* file, int line)
-    : severity_(severity) {
-  switch (severity) {
-    case PLAIN:
-    case INFO:
-      out_stream_ = &std::cout;
-      break;
-    case ERROR:
-    case FATAL:
-      out_stream_ = &std::cerr;
-      break;
-    default:
-      std::cerr << "Internal Error: Unknown LogSeverity!\n";
-      exit(1);
+
+// Registered as a flag by hand, since DEFINE_FLAG makes a static variable that
+// the VLOG macro could not read.
+std::atomic<int> vlogLevel(0);
+static __CommandLineFlags__::RegisterFlag __REGISTER_v__(
+    "v", __data_type_pointer__(AtomicIntType, &vlogLevel),
+    "Verbosity of VLOG, i.e. VLOG(n) is printed if n <= v.");
+
+// A stream buffer appending to a string, which keeps its capacity between
+// messages so that formatting does not allocate in steady state.
+class StringAppendBuf : public std::streambuf {
+ public:
+  std::string& str() { return str_; }
+ protected:
+  virtual int_type overflow(int_type c) {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      str_.push_back(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
   }
-  if (severity != PLAIN) {
+  virtual std::streamsize xsputn(const char* s, std::streamsize n) {
+    str_.append(s, n);
+    return n;
+  }
+ private:
+  std::string str_;
+};
+
+// The message being formatted by one 'Log'.
+struct LogBuffer {
+  LogBuffer() : stream(&buf) { }
+  StringAppendBuf buf;
+  ostream stream;
+};
+
+namespace {
+// The message buffers of a thread, one per nesting level of 'Log' (e.g. a LOG
+// statement inside the operator<< of a logged object).
+struct ThreadBuffers {
+  ThreadBuffers() : depth(0) { }
+  ~ThreadBuffers() {
+    for (size_t i = 0; i < buffers.size(); ++i)   delete buffers[i];
+  }
+  std::vector<LogBuffer*> buffers;
+  int depth;
+};
+thread_local ThreadBuffers threadBuffers;
+
+void WriteSync(LogSeverity severity, const std::string& text) {
 #ifdef __MATLAB__
-    mexPrintf("[%s:%d] ", file, line);
+  mexPrintf("%s", text.c_str());
 #else
-    *out_stream_ << "[" << file << ": " << line << "] ";
+  ostream& os = (severity == PLAIN || severity == INFO) ? std::cout : std::cerr;
+  os.write(text.data(), text.size());
+  if (severity != PLAIN)   os.flush();
 #endif
+}
+
+// Bounded multi-producer single-consumer queue of messages. Each slot has a
+// sequence number telling whether it is free for the producer at position
+// 'pos' (seq == pos) or holds the message at 'pos' (seq == pos + 1), so that
+// producers only contend on 'enqueuePos' and never lock. The slot strings keep
+// their capacity, and the background writer batches the messages into a single
+// write per stream.
+const size_t kQueueSize = 4096;
+const int kWriterSpins = 100;
+
+struct Slot {
+  std::atomic<size_t> seq;
+  LogSeverity severity;
+  std::string text;
+};
+
+class AsyncQueue {
+ public:
+  AsyncQueue() : slots_(new Slot[kQueueSize]), enqueuePos_(0), dequeuePos_(0),
+                 writtenPos_(0), sleeping_(false), stopping_(false) {
+    for (size_t i = 0; i < kQueueSize; ++i)   slots_[i].seq = i;
+  }
+
+  void Push(LogSeverity severity, const std::string& text) {
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+      slot = &slots_[pos % kQueueSize];
+      size_t seq = slot->seq.load(std::memory_order_acquire);
+      if (seq == pos) {
+        if (enqueuePos_.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (seq + kQueueSize == pos + 1) {
+        // The queue is full, wait for the writer.
+        Wake();
+        std::this_thread::yield();
+        pos = enqueuePos_.load(std::memory_order_relaxed);
+      } else {
+        // Another producer got 'pos' first.
+        pos = enqueuePos_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->severity = severity;
+    slot->text.assign(text);
+    slot->seq.store(pos + 1);
+    // Only the first producer after the writer went to sleep wakes it.
+    if (sleeping_.load() && sleeping_.exchange(false))   Wake();
+  }
+
+  void Start() {
+    stopping_ = false;
+    writer_ = std::thread(&AsyncQueue::Run, this);
+  }
+
+  // Write all the messages and stop the writer. No producer may be pushing.
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+      wakeCv_.notify_one();
+    }
+    writer_.join();
+  }
+
+  void Flush() {
+    size_t target = enqueuePos_.load();
+    std::unique_lock<std::mutex> lock(mutex_);
+    wakeCv_.notify_one();
+    while (writtenPos_ < target)   writtenCv_.wait(lock);
+  }
+
+ private:
+  bool Ready(size_t pos) const {
+    return slots_[pos % kQueueSize].seq.load() == pos + 1;
+  }
+
+  void Wake() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wakeCv_.notify_one();
+  }
+
+  void Run() {
+    std::string out, err;
+    for (;;) {
+      size_t pos = dequeuePos_;
+      for (; Ready(pos); ++pos) {
+        Slot& slot = slots_[pos % kQueueSize];
+        bool toOut = slot.severity == PLAIN || slot.severity == INFO;
+        (toOut ? out : err).append(slot.text);
+        slot.seq.store(pos + kQueueSize, std::memory_order_release);
+      }
+      dequeuePos_ = pos;
+      if (!out.empty()) {
+        std::cout.write(out.data(), out.size());
+        std::cout.flush();
+        out.clear();
+      }
+      if (!err.empty()) {
+        std::cerr.write(err.data(), err.size());
+        std::cerr.flush();
+        err.clear();
+      }
+      // Wait a little for more messages before going to sleep, since waking up
+      // costs a system call in the producer.
+      for (int i = 0; i < kWriterSpins && !Ready(pos); ++i) {
+        std::this_thread::yield();
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      writtenPos_ = pos;
+      writtenCv_.notify_all();
+      // Announce the sleep before checking the queue again, so that a producer
+      // publishing a message after the check sees 'sleeping_' and wakes us.
+      sleeping_ = true;
+      if (!Ready(pos)) {
+        if (stopping_)   break;
+        wakeCv_.wait_for(lock, std::chrono::milliseconds(100));
+      }
+      sleeping_ = false;
+    }
+    sleeping_ = false;
+  }
+
+  Slot* slots_;
+  std::atomic<size_t> enqueuePos_;
+  size_t dequeuePos_;         // Only used by the writer.
+  size_t writtenPos_;         // Guarded by 'mutex_'.
+  std::atomic<bool> sleeping_;
+  bool stopping_;             // Guarded by 'mutex_'.
+  std::mutex mutex_;
+  std::condition_variable wakeCv_;
+  std::condition_variable writtenCv_;
+  std::thread writer_;
+};
+
+// The queue is never destroyed, so that it outlives all the logging threads.
+AsyncQueue* asyncQueue = NULL;
+std::atomic<bool> asyncEnabled(false);
+// Number of threads between checking 'asyncEnabled' and finishing the push.
+std::atomic<int> activeProducers(0);
+std::mutex asyncMutex;    // Serializes turning the asynchronous logging on/off.
+
+void StopAsyncAtExit() {
+  LogSetAsync(false);
+}
+
+// Push 'text' to the queue if the asynchronous logging is on.
+bool PushAsync(LogSeverity severity, const std::string& text) {
+  if (!asyncEnabled.load(std::memory_order_relaxed))   return false;
+  ++activeProducers;
+  if (!asyncEnabled.load()) {
+    --activeProducers;
+    return false;
+  }
+  asyncQueue->Push(severity, text);
+  --activeProducers;
+  return true;
+}
+}   // namespace
+
+Log::Log(LogSeverity severity, const char* file, int line)
+    : severity_(severity) {
+  if (severity != PLAIN && severity != INFO &&
+      severity != ERROR && severity != FATAL) {
+    std::cerr << "Internal Error: Unknown LogSeverity!\n";
+    exit(1);
+  }
+  ThreadBuffers& tb = threadBuffers;
+  if (tb.depth == int(tb.buffers.size()))   tb.buffers.push_back(new LogBuffer);
+  buffer_ = tb.buffers[tb.depth++];
+  stream_ = &buffer_->stream;
+  // Each message starts with the default format.
+  stream_->flags(std::ios_base::dec | std::ios_base::skipws);
+  stream_->precision(6);
+  stream_->width(0);
+  stream_->fill(' ');
+  if (severity != PLAIN) {
+    *stream_ << "[" << file << ": " << line << "] ";
   }
 }
 
 Log::~Log() {
+  std::string& text = buffer_->buf.str();
   if (severity_ != PLAIN)  {
-#ifdef __MATLAB__
-    mexPrintf("\n");
-#else
-    *out_stream_ << std::endl;
-#endif
+    text.push_back('\n');
   }
   if (severity_ == FATAL)  {
+    // Write all the pending messages first.
+    LogSetAsync(false);
+    WriteSync(severity_, text);
+    text.clear();
+    --threadBuffers.depth;
     // TODO: print stack trace.
 #ifdef __MATLAB__
     mexErrMsgTxt(""); // TODO.
@@ -60,12 +287,58 @@ Log::~Log() {
     exit(1);
 #endif
   }
+  if (!PushAsync(severity_, text))   WriteSync(severity_, text);
+  text.clear();
+  --threadBuffers.depth;
 }
 
 Log& operator<<(Log& log, ostream& (*pf)(ostream&))  {
-  *log.out_stream_ << pf;
+  *log.stream_ << pf;
   return log;
 }
 
 }   // namespace __LogAndCheck__
+
+void LogSetAsync(bool async) {
+#ifndef __MATLAB__
+  using namespace __LogAndCheck__;
+  std::lock_guard<std::mutex> lock(asyncMutex);
+  if (async == asyncEnabled.load())   return;
+  if (async) {
+    if (!asyncQueue) {
+      asyncQueue = new AsyncQueue;
+      atexit(StopAsyncAtExit);
+    }
+    asyncQueue->Start();
+    asyncEnabled = true;
+  } else {
+    asyncEnabled = false;
+    while (activeProducers.load() != 0)   std::this_thread::yield();
+    asyncQueue->Stop();
+  }
+#endif
+}
+
+void SetVLogLevel(int level) {
+  __LogAndCheck__::vlogLevel.store(level, std::memory_order_relaxed);
+}
+
+int GetVLogLevel() {
+  return __LogAndCheck__::vlogLevel.load(std::memory_order_relaxed);
+}
+
+bool LogIsAsync() {
+  return __LogAndCheck__::asyncEnabled.load();
+}
+
+void LogFlush() {
+  using namespace __LogAndCheck__;
+  {
+    std::lock_guard<std::mutex> lock(asyncMutex);
+    if (asyncEnabled.load())   asyncQueue->Flush();
+  }
+  std::cout.flush();
+  std::cerr.flush();
+}
+
 }   // namespace xyUtils
@@ -8,12 +8,9 @@
 #ifndef __XYUTILS_LOG_AND_CHECK_H__
 #define __XYUTILS_LOG_AND_CHECK_H__
 
+#include <atomic>
 #include <cstring>
 #include <ostream>
-#ifdef __MATLAB__  // Note: use -D__MATLAB__ when compiling for matlab.
-#include "mex.h"
-#include <sstream>
-#endif
 
 /** Prints message to stdout or stderr.
   * Example:
@@ -24,12 +21,48 @@
   *                                     // line number.
   *   LOG(FATAL) << "Error message.";   // Prints to stderr with file name and
   *                                     // line number, and exits the program.
+  *
+  * Each message is formatted into a buffer of the calling thread and written
+  * with a single write when the statement ends, so that the messages of
+  * different threads do not interleave. After 'LogSetAsync(true)', the messages
+  * are instead pushed to a lock-free queue and written by a background thread,
+  * so that logging threads never wait on the terminal (see 'LogSetAsync').
   */
 #define LOG(severity)                                                     \
   xyUtils::__LogAndCheck__::Log(xyUtils::__LogAndCheck__::severity,       \
       (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__),   \
       __LINE__)
 
+/** Conditional and verbose logging. The message, including the evaluation of
+  * its '<<' arguments, is skipped when not printed.
+  * Example:
+  *   LOG_IF(INFO, n > 100) << "Large n: " << n;
+  *   LOG_EVERY_N(INFO, 1000) << "Iteration " << i;   // Iterations 0, 1000, ...
+  *   VLOG(2) << "Details: " << ExpensiveDebugString();
+  *
+  * VLOG(level) logs as INFO when 'level' is at most the verbosity, which is set
+  * by the command line flag '--v' (0 by default) or 'SetVLogLevel'. A disabled
+  * VLOG costs a load and a predictable branch. When compiled with
+  * '-D__MAX_VLOG_LEVEL__=n' (e.g. 'make MAX_VLOG=n'), VLOG(level) with a
+  * constant 'level' greater than 'n' is removed at compile time.
+  */
+#define LOG_IF(severity, condition)                                       \
+  if (!(condition)) {} else LOG(severity)
+
+#define LOG_EVERY_N(severity, n)                                          \
+  LOG_IF(severity, __LOG_OCCURRENCES__()++ % static_cast<unsigned int>(n) == 0)
+
+#define VLOG_IS_ON(level)                                                 \
+  ((level) <= __MAX_VLOG_LEVEL__ &&                                       \
+   (level) <= xyUtils::__LogAndCheck__::vlogLevel.load(                   \
+       std::memory_order_relaxed))
+
+#define VLOG(level) LOG_IF(INFO, VLOG_IS_ON(level))
+
+#ifndef __MAX_VLOG_LEVEL__
+#define __MAX_VLOG_LEVEL__ 0x7fffffff
+#endif
+
 /** Prints an error message and exits the program if the 'condition' failed.
   * Example:
   *   CHECK(1 >= 0);    // Nothing happens.
@@ -91,6 +124,13 @@
 //==========================================================
 // Private sector.
 //==========================================================
+// A counter of its own for each expansion, e.g. of each LOG_EVERY_N statement.
+#define __LOG_OCCURRENCES__()                                             \
+  ([]() -> std::atomic<unsigned int>& {                                   \
+    static std::atomic<unsigned int> occurrences(0);                      \
+    return occurrences;                                                   \
+  })()
+
 #define __CHECK_OP__(op, obj1, obj2)   {                                  \
   __typeof__ (obj1) _obj1 = (obj1);                                       \
   __typeof__ (obj2) _obj2 = (obj2);                                       \
@@ -102,33 +142,52 @@
 }
 
 namespace xyUtils  {
+
+/** Turn the asynchronous logging on or off (off by default). When on, LOG
+  * statements only format the message and push it to a bounded queue, and a
+  * background thread writes the messages in order. A LOG(FATAL) turns it off,
+  * which drains the queue, before writing its own message and exiting, and so
+  * does the program exit. Has no effect with '__MATLAB__'.
+  */
+void LogSetAsync(bool async);
+bool LogIsAsync();
+
+/** Wait until all the messages logged so far have been written and flushed. */
+void LogFlush();
+
+/** The verbosity of VLOG, also set by the command line flag '--v'. */
+void SetVLogLevel(int level);
+int GetVLogLevel();
+
 namespace __LogAndCheck__ {
 enum LogSeverity  {
   PLAIN, INFO, ERROR, FATAL
 };
 
+struct LogBuffer;
+
+// The verbosity of VLOG, read inline by the macros from any thread, with a
+// relaxed load that costs the same as a plain one.
+extern std::atomic<int> vlogLevel;
+
 class Log {
  public:
-  // Constructor prints the file and line information.
+  // Constructor formats the file and line information.
   Log(LogSeverity severity, const char* file, int line);
-  // Destructor prints the endl and exits the program if necessary.
+  // Destructor appends the endl, writes the message and exits the program if
+  // necessary.
   ~Log();
-  // Forward the print operation to underlying stream.
+  // Forward the print operation to the message buffer.
   template<typename T> Log& operator<<(const T& data) {
-#ifdef __MATLAB__
-    std::stringstream ss;
-    ss << data;
-    mexPrintf("%s", ss.str().c_str());
-#else
-    *out_stream_ << data;
-#endif
+    *stream_ << data;
     return *this;
   }
   // Used to deal with endl, which is itself a function handle.
   friend Log& operator<<(Log& log, std::ostream& (*pf)(std::ostream&));
  private:
   LogSeverity severity_;
-  std::ostream* out_stream_;
+  LogBuffer* buffer_;
+  std::ostream* stream_;
 };
 Log& operator<<(Log& log, std::ostream& (*pf)(std::ostream&));
 
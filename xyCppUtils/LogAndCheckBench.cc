@@ -0,0 +1,72 @@
+/**
+  * Benchmarks for logging.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "LogAndCheck.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Benchmark.h"
+#include "CommandLineFlags.h"
+
+using namespace std;
+using namespace xyUtils;
+
+namespace {
+void LogMessages(int n) {
+  for (int i = 0; i < n; ++i) {
+    LOG(INFO) << "Iteration " << i << ", cost " << 0.5 * i << ".";
+  }
+}
+
+void VLogMessages(int n) {
+  for (int i = 0; i < n; ++i) {
+    VLOG(1) << "Iteration " << i << ", cost " << 0.5 * i << ".";
+  }
+}
+}   // namespace
+
+int main(int argc, char** argv)  {
+  CommandLineFlagsInit(&argc, &argv, true);
+  BenchmarkSuite suite("LogAndCheck");
+
+  // Send the messages to /dev/null, so that the terminal is not measured.
+  fflush(stdout);
+  int stdoutFd = dup(1);
+  int nullFd = open("/dev/null", O_WRONLY);
+  dup2(nullFd, 1);
+
+  const int N = 1000, numThreads = 4;
+  // A disabled VLOG only costs a branch.
+  suite.Run("VLOG/Disabled", [&]() {
+      VLogMessages(N);
+    }, 0, N);
+  for (int async = 0; async < 2; ++async) {
+    LogSetAsync(async);
+    suite.Run(async ? "LOG/Async" : "LOG/Sync", [&]() {
+        LogMessages(N);
+      }, 0, N);
+    suite.Run(async ? "LOG/Async/4Threads" : "LOG/Sync/4Threads", [&]() {
+        vector<thread> threads;
+        for (int t = 0; t < numThreads; ++t) {
+          threads.push_back(thread(LogMessages, N));
+        }
+        for (int t = 0; t < numThreads; ++t)   threads[t].join();
+      }, 0, N * numThreads);
+    LogFlush();
+  }
+  LogSetAsync(false);
+
+  dup2(stdoutFd, 1);
+  close(nullFd);
+  close(stdoutFd);
+  suite.Finish();
+  return 0;
+}
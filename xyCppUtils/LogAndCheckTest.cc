@@ -8,10 +8,19 @@
 #include"LogAndCheck.h"
 
 #include<string>
+#include<thread>
+#include<vector>
 
 using std::string;
 using namespace xyUtils;
 
+namespace {
+int numEvaluations = 0;
+int Evaluate() {
+  return ++numEvaluations;
+}
+}   // namespace
+
 int main()  {
   // Test logging.
   LOG(PLAIN) << "Plain text1...";
@@ -20,6 +29,47 @@ int main()  {
   LOG(ERROR) << "Print error info...";
   // LOG(FATAL) << "Print error info and kill the program!";
 
+  // Test conditional and verbose logging, which skips the arguments when not
+  // printed.
+  LOG_IF(INFO, 1 + 1 == 2) << "Printed LOG_IF " << Evaluate() << ".";
+  LOG_IF(INFO, 1 + 1 == 3) << "Not printed LOG_IF " << Evaluate() << ".";
+  CHECK_EQ(numEvaluations, 1);
+  for (int i = 0; i < 10; ++i) {
+    LOG_EVERY_N(INFO, 4) << "LOG_EVERY_N at " << i << ", " << Evaluate() << ".";
+  }
+  CHECK_EQ(numEvaluations, 1 + 3);
+  CHECK_EQ(GetVLogLevel(), 0);
+  VLOG(0) << "Printed VLOG(0) " << Evaluate() << ".";
+  VLOG(1) << "Not printed VLOG(1) " << Evaluate() << ".";
+  CHECK_EQ(numEvaluations, 5);
+  SetVLogLevel(2);
+  CHECK(VLOG_IS_ON(2) && !VLOG_IS_ON(3));
+  VLOG(1) << "Printed VLOG(1) " << Evaluate() << ".";
+  VLOG(3) << "Not printed VLOG(3) " << Evaluate() << ".";
+  CHECK_EQ(numEvaluations, 6);
+  SetVLogLevel(0);
+  if (numEvaluations < 0)
+    VLOG(0) << "Not printed.";
+  else
+    LOG(INFO) << "The else branch binds to the enclosing if.";
+
+  // Test asynchronous logging from several threads.
+  LogSetAsync(true);
+  CHECK(LogIsAsync());
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.push_back(std::thread([t]() {
+          for (int i = 0; i < 3; ++i) {
+            LOG(INFO) << "Async message " << i << " from thread " << t << ".";
+          }
+        }));
+  }
+  for (int t = 0; t < 4; ++t)   threads[t].join();
+  LogFlush();
+  LogSetAsync(false);
+  CHECK(!LogIsAsync());
+  LOG(INFO) << "Sync message after the async ones.";
+
   // Test cheching.
   CHECK("Pass");
   CHECK_EQ(1, 2-1);
@@ -29,7 +79,10 @@ int main()  {
   CHECK_GE(3, 3);
   CHECK_LE(1, 3);
 
-  // Following check will fail and exit the program.
+  // Following check will fail and exit the program, after writing the pending
+  // asynchronous messages.
+  LogSetAsync(true);
+  LOG(INFO) << "Async message before the failure.";
   CHECK_EQ(string("Intentionally"), "Fail");   // Should success.
   LOG(INFO) << "Shouldn't see this.";
 
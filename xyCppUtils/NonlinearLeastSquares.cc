@@ -9,10 +9,14 @@
 
 #include <iomanip>
 #include <limits>
+#include <vector>
 #include <Eigen/Core>
 #include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
 
 #include "LogAndCheck.h"
+#include "Profiler.h"
+#include "Timer.h"
 
 namespace xyUtils  {
 
@@ -44,6 +48,31 @@ void PrintIterInfo_LM(const NLLSOpts& opts, int iter, double F,
   }
 }
 
+void PrintIterInfoHeader_TR(const NLLSOpts& opts) {
+  if (opts.display >= NLLSOpts::DISPLAY_ITER) {
+    LOG(PLAIN) << std::setw(5) << "Iters" << "  "
+               << std::setw(15) << "F(x)";
+    if (opts.display >= NLLSOpts::DISPLAY_ITER_DETAILED) {
+      LOG(PLAIN) << std::setw(10) << "rho" << "  "
+                 << std::setw(10) << "radius";
+    }
+    LOG(PLAIN) << "\n";
+  }
+}
+
+void PrintIterInfo_TR(const NLLSOpts& opts, int iter, double F,
+                      double rho, double radius) {
+  if (opts.display >= NLLSOpts::DISPLAY_ITER) {
+    LOG(PLAIN) << std::setw(5) << iter << "  "
+               << std::setw(15) << std::setprecision(8) << F;
+    if (opts.display >= NLLSOpts::DISPLAY_ITER_DETAILED) {
+      LOG(PLAIN) << std::setw(10) << std::setprecision(3) << rho << "  "
+                 << std::setw(10) << std::setprecision(3) << radius;
+    }
+    LOG(PLAIN) << "\n";
+  }
+}
+
 void PrintFinalInfo(const NLLSOpts& opts, const NLLSResultInfo& result) {
   if (opts.display >= NLLSOpts::DISPLAY_FINAL) {
     LOG(PLAIN) << "Terminate in " << result.finalIter << " iterations: ";
@@ -63,12 +92,25 @@ void PrintFinalInfo(const NLLSOpts& opts, const NLLSResultInfo& result) {
       case 4:
         LOG(PLAIN) << "magnitude of search direction is less than eps.\n";
         break;
+      case 5:
+        LOG(PLAIN) << "terminated by 'iterCallback'.\n";
+        break;
       default:
         LOG(FATAL) << "Unknown 'exitflag'.";
     }
   }
 }
 
+// Pass the record of an iteration that took 'timeTotal' seconds to the user
+// callback, if any. Return true if the callback requests to terminate.
+bool ReportIterInfo(const NLLSOpts& opts, double timeTotal,
+                    NLLSIterInfo* info) {
+  if (!opts.iterCallback)   return false;
+  // Not negative by the rounding of the separately timed parts.
+  info->timeOther = std::max(0.0, timeTotal - info->timeFcn - info->timeSolve);
+  return !opts.iterCallback(*info, opts.iterCallbackParams);
+}
+
 int StopCriterion_LM(double rho_denom, double rho,
                      double F_old, double F, double aTolF,
                      const Eigen::VectorXd& x_old, const Eigen::VectorXd& x,
@@ -92,26 +134,286 @@ int StopCriterion_LM(double rho_denom, double rho,
   }
 }
 
-Eigen::VectorXd NonlinearLeastSquares_LM(
+// Get the bounds of 'x' in 'opts', with NaN or missing bounds replaced by
+// -inf/+inf. Return whether there is any finite bound.
+bool GetBounds(const NLLSOpts& opts, int N,
+               Eigen::VectorXd* lb, Eigen::VectorXd* ub) {
+  const double kInf = std::numeric_limits<double>::infinity();
+  lb->setConstant(N, -kInf);
+  ub->setConstant(N, kInf);
+  bool bounded = false;
+  for (int i = 0; i < opts.lowerBound.size(); ++i) {
+    if (!std::isnan(opts.lowerBound(i))) {
+      (*lb)(i) = opts.lowerBound(i);
+      bounded = true;
+    }
+  }
+  for (int i = 0; i < opts.upperBound.size(); ++i) {
+    if (!std::isnan(opts.upperBound(i))) {
+      (*ub)(i) = opts.upperBound(i);
+      bounded = true;
+    }
+  }
+  return bounded;
+}
+
+// Compute the Levenberg-Marquardt step for the box constrained problem at a
+// feasible 'x', by solving the damped system 'A' * h = -'Jf' reduced to the free
+// variables. A variable is fixed (h(i) = 0) if it is at a bound and either the
+// gradient or the reduced step points outward; the system is solved again until
+// the fixed set does not change.
+template <typename Scalar>
+Eigen::VectorXd BoundedLMStep(const Eigen::Matrix<Scalar, Eigen::Dynamic,
+                                                  Eigen::Dynamic>& A,
+                              const Eigen::VectorXd& Jf,
+                              const Eigen::VectorXd& x,
+                              const Eigen::VectorXd& lb,
+                              const Eigen::VectorXd& ub,
+                              int* numFactorizations) {
+  int N = x.size();
+  std::vector<bool> fixed(N);
+  for (int i = 0; i < N; ++i) {
+    fixed[i] = (x(i) <= lb(i) && Jf(i) > 0) || (x(i) >= ub(i) && Jf(i) < 0);
+  }
+  Eigen::VectorXd h = Eigen::VectorXd::Zero(N);
+  std::vector<int> freeIdx;
+  Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> A_free;
+  Eigen::Matrix<Scalar, Eigen::Dynamic, 1> Jf_free, h_free;
+  while (true) {
+    freeIdx.clear();
+    for (int i = 0; i < N; ++i) {
+      if (!fixed[i])   freeIdx.push_back(i);
+    }
+    int NF = freeIdx.size();
+    h.setZero();
+    if (NF == 0)   break;
+    A_free.resize(NF, NF);
+    Jf_free.resize(NF);
+    for (int c = 0; c < NF; ++c) {
+      for (int r = 0; r < NF; ++r) {
+        A_free(r, c) = A(freeIdx[r], freeIdx[c]);
+      }
+      Jf_free(c) = Scalar(Jf(freeIdx[c]));
+    }
+    h_free = - A_free.llt().solve(Jf_free);
+    ++(*numFactorizations);
+    bool changed = false;
+    for (int k = 0; k < NF; ++k) {
+      int i = freeIdx[k];
+      h(i) = double(h_free(k));
+      if ((x(i) <= lb(i) && h(i) < 0) || (x(i) >= ub(i) && h(i) > 0)) {
+        fixed[i] = true;
+        changed = true;
+      }
+    }
+    if (!changed)   break;
+  }
+  return h;
+}
+
+// Handle boundary condition (naively), by clamping 'x' into the box.
+void ClampToBounds(const NLLSOpts& opts, Eigen::VectorXd* x) {
+  int N = x->size();
+  if (opts.upperBound.size() > 0) {
+    for (int i = 0; i < N; ++i) {
+      (*x)(i) = std::isnan(opts.upperBound(i)) ? (*x)(i) :
+          std::min((*x)(i), opts.upperBound(i));
+    }
+  }
+  if (opts.lowerBound.size() > 0) {
+    for (int i = 0; i < N; ++i) {
+      (*x)(i) = std::isnan(opts.lowerBound(i)) ? (*x)(i) :
+          std::max((*x)(i), opts.lowerBound(i));
+    }
+  }
+}
+
+// Evaluate the robust cost F = sum_i rho(f_i^2) of residuals 'f', and replace
+// 'f' and 'J' (which could be NULL) by the reweighted ones, so that the model
+// ||f + J*h||^2 has the gradient and Gauss-Newton curvature of F. The cost is
+// always accumulated in double.
+template <typename Scalar>
+double ApplyLoss(const NLLSOpts::LossOpts& lossOpts,
+                 Eigen::Matrix<Scalar, Eigen::Dynamic, 1>* f,
+                 Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>* J) {
+  if (lossOpts.type == NLLSOpts::LossOpts::LOSS_SQUARED) {
+    return f->template cast<double>().squaredNorm();
+  }
+  const double a = lossOpts.scale;
+  const double a2 = a * a;
+  CHECK_GT(a, 0.0);
+  // Compute rho(s) and its first two derivatives for all residuals at once.
+  Eigen::ArrayXd s = f->array().template cast<double>().square();
+  Eigen::ArrayXd rho, rho1, rho2;
+  switch (lossOpts.type) {
+    case NLLSOpts::LossOpts::LOSS_HUBER: {
+      Eigen::ArrayXd r = s.sqrt();
+      rho = (s > a2).select(2.0*a*r - a2, s);
+      rho1 = (s > a2).select(a * r.inverse(), 1.0);
+      rho2 = (s > a2).select(-0.5 * rho1 * s.inverse(), 0.0);
+      break;
+    }
+    case NLLSOpts::LossOpts::LOSS_SOFT_L1: {
+      Eigen::ArrayXd sum = 1.0 + s / a2;
+      Eigen::ArrayXd tmp = sum.sqrt();
+      rho = 2.0 * a2 * (tmp - 1.0);
+      rho1 = tmp.inverse();
+      rho2 = -0.5 / a2 * rho1 * sum.inverse();
+      break;
+    }
+    case NLLSOpts::LossOpts::LOSS_CAUCHY: {
+      Eigen::ArrayXd sum = 1.0 + s / a2;
+      rho = a2 * sum.log();
+      rho1 = sum.inverse();
+      rho2 = -rho1.square() / a2;
+      break;
+    }
+    case NLLSOpts::LossOpts::LOSS_TUKEY: {
+      Eigen::ArrayXd value = 1.0 - s / a2;
+      rho = (s <= a2).select(a2 / 3.0 * (1.0 - value.cube()), a2 / 3.0);
+      rho1 = (s <= a2).select(value.square(), 0.0);
+      rho2 = (s <= a2).select(-2.0 / a2 * value, 0.0);
+      break;
+    }
+    default:
+      LOG(FATAL) << "Unknown 'LossType' option.";
+  }
+  // Triggs correction. For a scalar residual, the reweighted residual and
+  // Jacobian row are f_i*sqrt(rho1/D) and J_i*sqrt(rho1*D), with
+  //   D = 1 + 2*s*rho2/rho1,
+  // so that the gradient is rho1*J'f and the curvature is (rho1+2*s*rho2)*J'J.
+  // Where rho is concave (D < 1), the curvature can vanish or become negative,
+  // so D is clamped to 1, i.e. plain iteratively reweighted least squares.
+  Eigen::ArrayXd D = (rho1 > 0).select(1.0 + 2.0 * s * rho2 * rho1.inverse(),
+                                       1.0).max(1.0);
+  f->array() *= (rho1 / D).sqrt().template cast<Scalar>();
+  if (J) {
+    *J = (rho1 * D).sqrt().template cast<Scalar>().matrix().asDiagonal() *
+        (*J);
+  }
+  return rho.sum();
+}
+
+// Compute the Gauss-Newton step 'h_gn' solving (J'J) h_gn = -J'f. If 'JJ' is
+// numerically singular, a tiny damping is added to keep the step finite.
+Eigen::VectorXd GaussNewtonStep(const Eigen::MatrixXd& JJ,
+                                const Eigen::VectorXd& Jf,
+                                int* numFactorizations) {
+  Eigen::LLT<Eigen::MatrixXd> llt(JJ);
+  ++(*numFactorizations);
+  if (llt.info() != Eigen::Success) {
+    double damp = std::max(1.0e-10 * JJ.diagonal().maxCoeff(),
+                           std::numeric_limits<double>::min());
+    llt.compute(JJ + damp * Eigen::MatrixXd::Identity(JJ.rows(), JJ.cols()));
+    ++(*numFactorizations);
+  }
+  return -llt.solve(Jf);
+}
+
+// Compute Powell's dogleg step within trust region 'radius', given the
+// Gauss-Newton step 'h_gn' and the steepest descent step 'h_sd' (the minimizer
+// of the model along the negative gradient).
+Eigen::VectorXd DoglegStep(const Eigen::VectorXd& h_gn,
+                           const Eigen::VectorXd& h_sd,
+                           double radius) {
+  if (h_gn.norm() <= radius) {
+    return h_gn;
+  }
+  double sdNorm = h_sd.norm();
+  if (sdNorm >= radius) {
+    return (radius / sdNorm) * h_sd;
+  }
+  // Find 'beta' in (0,1] such that ||h_sd + beta*(h_gn-h_sd)|| = radius, i.e.
+  // the positive root of a*beta^2 + 2*b*beta + c = 0.
+  Eigen::VectorXd d = h_gn - h_sd;
+  double a = d.squaredNorm();
+  double b = h_sd.dot(d);
+  double c = sdNorm*sdNorm - radius*radius;
+  double s = sqrt(b*b - a*c);
+  double beta = (b <= 0) ? (s - b) / a : -c / (b + s);
+  return h_sd + beta * d;
+}
+
+// Solve the small trust region subproblem
+//   min_a  g'a + 0.5*a'Ba,   s.t. ||a|| <= radius,
+// by eigen-decomposition of 'B' and a safeguarded Newton's method on the
+// Lagrange multiplier.
+Eigen::VectorXd SolveSmallTrustRegion(const Eigen::MatrixXd& B,
+                                      const Eigen::VectorXd& g,
+                                      double radius) {
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig(B);
+  const Eigen::VectorXd& l = eig.eigenvalues();   // In increasing order.
+  const Eigen::MatrixXd& Q = eig.eigenvectors();
+  Eigen::VectorXd gt = Q.transpose() * g;
+  double eps = std::numeric_limits<double>::epsilon();
+  // Interior solution.
+  if (l(0) > eps * std::max(1.0, l.cwiseAbs().maxCoeff())) {
+    Eigen::VectorXd a = -gt.cwiseQuotient(l);
+    if (a.norm() <= radius)   return Q * a;
+  }
+  // Boundary solution a(lambda) = -(B + lambda*I)^{-1} g with ||a|| = radius.
+  // Newton's method on 1/radius - 1/||a(lambda)||, which is nearly linear in
+  // lambda (More and Sorensen), converges in a few iterations; it falls back to
+  // bisection when a step leaves the bracket [lo, hi] of the root.
+  double lo = std::max(0.0, -l(0));
+  double hi = lo + gt.norm() / radius;
+  double lambda = hi;
+  bool converged = false;
+  for (int iter = 0; iter < 100 && hi - lo > eps * hi; ++iter) {
+    double norm2 = 0.0, dnorm2 = 0.0;
+    for (int i = 0; i < l.size(); ++i) {
+      double d = l(i) + lambda;
+      norm2 += gt(i) * gt(i) / (d * d);
+      dnorm2 += gt(i) * gt(i) / (d * d * d);
+    }
+    double norm = sqrt(norm2);
+    if (std::abs(norm - radius) <= 1e-12 * radius) {
+      converged = true;
+      break;
+    }
+    if (norm > radius)          lo = lambda;
+    else                        hi = lambda;
+    lambda += (1.0 / radius - 1.0 / norm) * norm2 * norm / dnorm2;
+    if (!(lambda > lo && lambda < hi))   lambda = 0.5 * (lo + hi);
+  }
+  Eigen::VectorXd a =
+      -gt.cwiseQuotient((l.array() + (converged ? lambda : hi)).matrix());
+  // The "hard case": 'g' is (nearly) orthogonal to the eigenvector of the
+  // smallest eigenvalue, move along that eigenvector to reach the boundary.
+  double aNorm = a.norm();
+  if (aNorm < radius) {
+    a(0) += sqrt(radius*radius - aNorm*aNorm);
+  }
+  return Q * a;
+}
+
+// Trust region algorithms. The Gauss-Newton step (and for the subspace method
+// the reduced model) is computed once per accepted step, so that rejected steps
+// only shrink the radius without another factorization. With bounds, the steps
+// are taken on the variables not held at their bounds, as in the bounded LM.
+Eigen::VectorXd NonlinearLeastSquares_TR(
     const VectorFunctionJacobian& fcnJac,
     void* params,
     const Eigen::VectorXd& x0,
     const NLLSOpts& opts,
     NLLSResultInfo* result) {
+  PROFILE_SCOPE("NonlinearLeastSquares_TR");
   // ================================================================
   // Initialization.
   // ================================================================
   Eigen::VectorXd x = x0;
+  Eigen::VectorXd lb, ub;
+  bool bounded = GetBounds(opts, x.size(), &lb, &ub);
+  ClampToBounds(opts, &x);
   Eigen::VectorXd f;
   Eigen::MatrixXd J;
   fcnJac(x, params, &f, &J);
-  int N = x.size();
-  double F = f.squaredNorm();
+  double F = ApplyLoss(opts.lossOpts, &f, &J);
   Eigen::MatrixXd Jt = J.transpose();
   Eigen::MatrixXd JJ = Jt * J;
   Eigen::VectorXd Jf = Jt * f;
-  double mu = opts.lmOpts.tau * JJ.diagonal().maxCoeff();
-  if (mu < std::numeric_limits<double>::epsilon()) {
+  result->numFactorizations = 0;
+  if (JJ.diagonal().maxCoeff() < std::numeric_limits<double>::epsilon()) {
     // J is a zero matrix.
     result->exitflag = 1;
     result->finalIter = 0;
@@ -119,73 +421,450 @@ Eigen::VectorXd NonlinearLeastSquares_LM(
     PrintFinalInfo(opts, *result);
     return x;
   }
-  double mu_min = 1.0e-12;
-  double nu = 2.0;
+  // Zero for the length of the first Gauss-Newton step, set below.
+  double radius = opts.trOpts.initRadius;
+  CHECK_GE(radius, 0.0);
   double aTolX = opts.tolX / x.size();
   double aTolF = opts.tolF / x.size();
-  // The followings might be needed for the first iterations's stop criterion,
-  // in case one starts at a local minimum.
   Eigen::VectorXd x_old = x;
   double F_old = F;
-  PrintIterInfoHeader_LM(opts);
-  PrintIterInfo_LM(opts, 0, F, 0.0, mu, nu);
+  // Quantities that only change with the Jacobian.
+  bool newJacobian = true;
+  Eigen::VectorXd h_gn, h_sd;     // Gauss-Newton and steepest descent steps.
+  Eigen::MatrixXd V;              // Orthonormal basis of the subspace.
+  Eigen::MatrixXd B_sub;          // Reduced J'J, i.e. V'*J'J*V.
+  Eigen::VectorXd g_sub;          // Reduced J'f, i.e. V'*J'f.
+  PrintIterInfoHeader_TR(opts);
+  PrintIterInfo_TR(opts, 0, F, 0.0, radius);
   // ================================================================
   // Main loop.
   // ================================================================
   int iter;
+  Timer iterTimer, timer;
   for (iter = 0; iter < opts.maxIter; ++iter) {
-    // Compute direction 'h'.
+    PROFILE_SCOPE("Iteration");
+    iterTimer.reset();
+    NLLSIterInfo info;
+    timer.reset();
+    if (newJacobian) {
+      if (Jf.squaredNorm() == 0) {
+        // Zero gradient, a stationary point is reached.
+        result->exitflag = 1;
+        break;
+      }
+      // The gradient without the components pointing out of the active
+      // bounds, which is J'f if there are no bounds.
+      Eigen::VectorXd g = Jf;
+      if (bounded) {
+        for (int i = 0; i < x.size(); ++i) {
+          if ((x(i) <= lb(i) && Jf(i) > 0) || (x(i) >= ub(i) && Jf(i) < 0)) {
+            g(i) = 0.0;
+          }
+        }
+        // Damped as little as 'GaussNewtonStep' does for a singular J'J.
+        Eigen::MatrixXd A = JJ;
+        A.diagonal().array() += std::max(1.0e-10 * JJ.diagonal().maxCoeff(),
+                                         std::numeric_limits<double>::min());
+        h_gn = BoundedLMStep(A, Jf, x, lb, ub, &result->numFactorizations);
+      } else {
+        h_gn = GaussNewtonStep(JJ, Jf, &result->numFactorizations);
+      }
+      if (radius == 0.0)   radius = h_gn.norm();
+      double JJg = g.dot(JJ * g);
+      h_sd = (JJg > 0) ? Eigen::VectorXd(-g.squaredNorm() / JJg * g) :
+          Eigen::VectorXd(-g);
+      if (opts.algorithm == NLLSOpts::ALGORITHM_SUBSPACE_TR) {
+        // Span{g, h_gn} by Gram-Schmidt.
+        Eigen::VectorXd v1 = g.normalized();
+        Eigen::VectorXd v2 = h_gn - v1.dot(h_gn) * v1;
+        bool twoDim = (v2.norm() > 1e-8 * h_gn.norm());
+        V.resize(x.size(), twoDim ? 2 : 1);
+        V.col(0) = v1;
+        if (twoDim)   V.col(1) = v2.normalized();
+        B_sub = V.transpose() * JJ * V;
+        g_sub = V.transpose() * Jf;
+      }
+      newJacobian = false;
+    }
+    // Compute step 'h' within current trust region.
     Eigen::VectorXd h;
-    Eigen::MatrixXd damp;
-    if (opts.lmOpts.dampMatrix == NLLSOpts::LMOpts::DAMP_MATRIX_EYE) {
-      damp = mu * Eigen::MatrixXd::Identity(N, N);
-    } else if (opts.lmOpts.dampMatrix == NLLSOpts::LMOpts::DAMP_MATRIX_JJ) {
-      damp = mu * JJ.diagonal().asDiagonal();
+    if (opts.algorithm == NLLSOpts::ALGORITHM_DOGLEG) {
+      h = DoglegStep(h_gn, h_sd, radius);
     } else {
-      LOG(FATAL) << "Unknown 'DampMatrix' option.";
+      h = V * SolveSmallTrustRegion(B_sub, g_sub, radius);
     }
-    h = - (JJ + damp).llt().solve(Jf);
-    // Handle boundary condition (naively).
+    // Handle boundary condition, for the variables that are free but reach a
+    // bound within the step.
     Eigen::VectorXd x_new = x + h;
-    if (opts.upperBound.size() > 0) {
-      for (int i = 0; i < N; ++i) {
-        x_new(i) = std::isnan(opts.upperBound(i)) ? x_new(i) :
-            std::min(x_new(i), opts.upperBound(i));
+    ClampToBounds(opts, &x_new);
+    h = x_new - x;
+    info.timeSolve = timer.elapsed();
+    info.stepNorm = h.norm();
+    // Compute the new 'f' and 'J'.
+    timer.reset();
+    {
+      PROFILE_SCOPE("Function");
+      fcnJac(x_new, params, &f, &J);
+    }
+    info.timeFcn = timer.elapsed();
+    timer.reset();
+    double F_new = ApplyLoss(opts.lossOpts, &f, &J);
+    // Compute gain ratio 'rho', with model L(h) = ||f + J*h||^2.
+    double rho_denom = -(2.0*h.dot(Jf) + h.dot(JJ*h));
+    double rho = (F - F_new) / rho_denom;
+    // A step increasing the model (which may only happen when it is clamped to
+    // the bounds) is rejected, even if it happens to decrease 'F'.
+    if (rho_denom < 0)   rho = -1.0;
+    if (rho > 0) {
+      // Step accepted.
+      x_old = x;   x = x_new;
+      F_old = F;   F = F_new;
+      Jt = J.transpose();      JJ = Jt * J;      Jf = Jt * f;
+      newJacobian = true;
+    }
+    info.timeSolve += timer.elapsed();
+    // Update trust region radius.
+    if (rho > 0.75) {
+      radius = std::max(radius, 3.0 * h.norm());
+    } else if (rho < 0.25) {
+      radius /= 2.0;
+    }
+    // Display information.
+    PrintIterInfo_TR(opts, iter+1, F, rho, radius);
+    info.iter = iter+1;   info.F = F;   info.rho = rho;
+    info.mu = radius;     info.nu = 0.0;
+    if (ReportIterInfo(opts, iterTimer.elapsed(), &info)) {
+      result->exitflag = 5;
+      break;
+    }
+    // Check the stop criterion.
+    result->exitflag = rho_denom < 0 ? 0 :
+        StopCriterion_LM(rho_denom, rho, F_old, F, aTolF, x_old, x, aTolX);
+    if (!result->exitflag && radius <= std::numeric_limits<double>::epsilon() *
+        (x.norm() + std::numeric_limits<double>::epsilon())) {
+      result->exitflag = 4;
+    }
+    if (result->exitflag)   break;
+  }
+  result->finalIter = iter;
+  result->F = F;
+  PrintFinalInfo(opts, *result);
+  return x;
+}
+
+// The Levenberg-Marquardt system matrix A = J'J + mu*D for the matrix-free
+// algorithm, together with its (block) Jacobi preconditioner.
+class MatrixFreeLMSystem {
+ public:
+  MatrixFreeLMSystem(const MatrixFreeNLLSFunctions& fcns, void* params,
+                     const NLLSOpts& opts)
+      : fcns_(fcns), params_(params), opts_(opts), x_(NULL), mu_(0.0) {
+    precond_ = opts.cgOpts.preconditioner;
+    blockSize_ = (precond_ == NLLSOpts::CGOpts::PRECOND_BLOCK_JACOBI) ?
+        opts.cgOpts.blockSize : 1;
+    CHECK_GT(blockSize_, 0);
+    if (!fcns.gramBlocks) {
+      CHECK(opts.lmOpts.dampMatrix == NLLSOpts::LMOpts::DAMP_MATRIX_EYE);
+      precond_ = NLLSOpts::CGOpts::PRECOND_NONE;
+    }
+  }
+  // Set the current point 'x', and compute the diagonal blocks of J'J if
+  // needed. Note that 'x' is kept by reference.
+  void SetPoint(const Eigen::VectorXd& x) {
+    x_ = &x;
+    if (fcns_.gramBlocks) {
+      fcns_.gramBlocks(x, params_, blockSize_, &gramBlocks_);
+      CHECK_EQ(gramBlocks_.rows(), x.size());
+      CHECK_EQ(gramBlocks_.cols(), blockSize_);
+      if (blockSize_ == 1) {
+        gramDiag_ = gramBlocks_.col(0);
+      } else {
+        gramDiag_.resize(x.size());
+        for (int i = 0; i < x.size(); ++i) {
+          gramDiag_(i) = gramBlocks_(i, i % blockSize_);
+        }
       }
     }
-    if (opts.lowerBound.size() > 0) {
-      for (int i = 0; i < N; ++i) {
-        x_new(i) = std::isnan(opts.lowerBound(i)) ? x_new(i) :
-            std::max(x_new(i), opts.lowerBound(i));
+  }
+  // Set the damping 'mu' and update the preconditioner.
+  void SetDamping(double mu) {
+    mu_ = mu;
+    int N = x_->size();
+    dampDiag_ = DampDiag();
+    if (precond_ == NLLSOpts::CGOpts::PRECOND_JACOBI) {
+      invDiag_ = (gramDiag_ + mu * dampDiag_).cwiseInverse();
+    } else if (precond_ == NLLSOpts::CGOpts::PRECOND_BLOCK_JACOBI) {
+      blockLLTs_.resize((N + blockSize_ - 1) / blockSize_);
+      Eigen::MatrixXd block;
+      for (size_t k = 0; k < blockLLTs_.size(); ++k) {
+        int start = k * blockSize_;
+        int n = std::min(blockSize_, N - start);
+        block = gramBlocks_.block(start, 0, n, n);
+        block.diagonal() += mu * dampDiag_.segment(start, n);
+        blockLLTs_[k].compute(block);
       }
     }
-    // Compute the new 'f' and 'J'.
-    fcnJac(x_new, params, &f, &J);
-    double F_new = f.squaredNorm();
-    // Compute gain ratio 'rho'.
+  }
+  // Compute J*v ('transpose' false) or J'*v ('transpose' true).
+  void JacProd(const Eigen::VectorXd& v, bool transpose,
+               Eigen::VectorXd* Jv) const {
+    fcns_.jacProd(*x_, params_, v, transpose, Jv);
+  }
+  // Compute A*v.
+  void Apply(const Eigen::VectorXd& v, Eigen::VectorXd* Av) const {
+    Eigen::VectorXd Jv;
+    JacProd(v, false, &Jv);
+    JacProd(Jv, true, Av);
+    *Av += mu_ * dampDiag_.cwiseProduct(v);
+  }
+  // Apply the preconditioner, z = P^{-1} * r.
+  void Precondition(const Eigen::VectorXd& r, Eigen::VectorXd* z) const {
+    if (precond_ == NLLSOpts::CGOpts::PRECOND_JACOBI) {
+      *z = invDiag_.cwiseProduct(r);
+    } else if (precond_ == NLLSOpts::CGOpts::PRECOND_BLOCK_JACOBI) {
+      z->resize(r.size());
+      for (size_t k = 0; k < blockLLTs_.size(); ++k) {
+        int start = k * blockSize_;
+        int n = std::min(blockSize_, int(r.size()) - start);
+        z->segment(start, n) = blockLLTs_[k].solve(r.segment(start, n));
+      }
+    } else {
+      *z = r;
+    }
+  }
+  // The diagonal of the damping matrix D.
+  Eigen::VectorXd DampDiag() const {
+    if (opts_.lmOpts.dampMatrix == NLLSOpts::LMOpts::DAMP_MATRIX_JJ) {
+      return gramDiag_;
+    } else {
+      return Eigen::VectorXd::Ones(x_->size());
+    }
+  }
+  // The maximum of diag(J'J), or an estimate of it if not available.
+  double MaxGramDiag(const Eigen::VectorXd& Jf) const {
+    if (fcns_.gramBlocks) {
+      return gramDiag_.maxCoeff();
+    }
+    // Rayleigh quotient of J'J along J'f.
+    double JfNorm2 = Jf.squaredNorm();
+    if (JfNorm2 == 0)   return 0.0;
+    Eigen::VectorXd JJf;
+    JacProd(Jf, false, &JJf);
+    return JJf.squaredNorm() / JfNorm2;
+  }
+ private:
+  const MatrixFreeNLLSFunctions& fcns_;
+  void* params_;
+  const NLLSOpts& opts_;
+  NLLSOpts::CGOpts::Preconditioner precond_;
+  int blockSize_;
+  const Eigen::VectorXd* x_;
+  double mu_;
+  Eigen::MatrixXd gramBlocks_;
+  Eigen::VectorXd gramDiag_;
+  Eigen::VectorXd dampDiag_;
+  Eigen::VectorXd invDiag_;
+  std::vector<Eigen::LLT<Eigen::MatrixXd> > blockLLTs_;
+};
+
+// Solve A*h = b approximately by preconditioned conjugate gradients, stopping
+// when ||A*h - b|| <= 'tol'. Return the number of CG iterations.
+int SolvePCG(const MatrixFreeLMSystem& A, const Eigen::VectorXd& b,
+             double tol, int maxIter, Eigen::VectorXd* h) {
+  h->setZero(b.size());
+  Eigen::VectorXd r = b, z, Ap;
+  A.Precondition(r, &z);
+  Eigen::VectorXd p = z;
+  double rz = r.dot(z);
+  int iter;
+  for (iter = 0; iter < maxIter; ++iter) {
+    if (r.norm() <= tol)   break;
+    A.Apply(p, &Ap);
+    double pAp = p.dot(Ap);
+    if (pAp <= 0)   break;
+    double alpha = rz / pAp;
+    *h += alpha * p;
+    r -= alpha * Ap;
+    A.Precondition(r, &z);
+    double rz_new = r.dot(z);
+    p = z + (rz_new / rz) * p;
+    rz = rz_new;
+  }
+  return iter;
+}
+}   // namespace
+
+template <typename JScalar, typename SolveScalar>
+NLLSSolverT<JScalar, SolveScalar>::NLLSSolverT(const NLLSOpts& opts)
+    : opts_(opts), hasSolution_(false), mu_(0.0), nu_(2.0) { }
+
+template <typename JScalar, typename SolveScalar>
+const Eigen::VectorXd& NLLSSolverT<JScalar, SolveScalar>::Solve(
+    const FcnJac& fcnJac,
+    void* params,
+    const Eigen::VectorXd& x0,
+    NLLSResultInfo* result) {
+  x_ = x0;
+  return Run(fcnJac, params, false, result);
+}
+
+template <typename JScalar, typename SolveScalar>
+const Eigen::VectorXd& NLLSSolverT<JScalar, SolveScalar>::SolveWarm(
+    const FcnJac& fcnJac,
+    void* params,
+    NLLSResultInfo* result) {
+  CHECK(hasSolution_);
+  return Run(fcnJac, params, true, result);
+}
+
+template <typename JScalar, typename SolveScalar>
+const Eigen::VectorXd& NLLSSolverT<JScalar, SolveScalar>::Run(
+    const FcnJac& fcnJac,
+    void* params,
+    bool warm,
+    NLLSResultInfo* result) {
+  PROFILE_SCOPE("NLLSSolver::Run");
+  NLLSResultInfo _result;
+  if (!result) {
+    result = &_result;
+  }
+  const NLLSOpts& opts = opts_;
+  // ================================================================
+  // Initialization.
+  // ================================================================
+  Eigen::VectorXd& x = x_;
+  int N = x.size();
+  bool bounded = GetBounds(opts, N, &lb_, &ub_);
+  ClampToBounds(opts, &x);
+  fcnJac(x, params, &f_, &J_);
+  double F = ApplyLoss(opts.lossOpts, &f_, &J_);
+  UpdateNormalEquations();
+  result->numFactorizations = 0;
+  hasSolution_ = true;
+  double maxDiag = JJdiag_.maxCoeff();
+  if (maxDiag < std::numeric_limits<double>::epsilon()) {
+    // J is a zero matrix.
+    result->exitflag = 1;
+    result->finalIter = 0;
+    result->F = F;
+    PrintFinalInfo(opts, *result);
+    return x;
+  }
+  double mu_min = 1.0e-12;
+  double& mu = mu_;
+  double& nu = nu_;
+  if (!warm) {
+    mu = opts.lmOpts.tau * maxDiag;
+  } else {
+    // Continue with the damping of the last solve.
+    mu = std::max(mu, mu_min);
+  }
+  nu = 2.0;
+  double aTolX = opts.tolX / x.size();
+  double aTolF = opts.tolF / x.size();
+  // The followings might be needed for the first iterations's stop criterion,
+  // in case one starts at a local minimum.
+  x_old_ = x;
+  double F_old = F;
+  PrintIterInfoHeader_LM(opts);
+  PrintIterInfo_LM(opts, 0, F, 0.0, mu, nu);
+  // ================================================================
+  // Main loop.
+  // ================================================================
+  const bool dampEye =
+      (opts.lmOpts.dampMatrix == NLLSOpts::LMOpts::DAMP_MATRIX_EYE);
+  if (!dampEye && opts.lmOpts.dampMatrix != NLLSOpts::LMOpts::DAMP_MATRIX_JJ) {
+    LOG(FATAL) << "Unknown 'DampMatrix' option.";
+  }
+  int iter;
+  Timer iterTimer, timer;
+  for (iter = 0; iter < opts.maxIter; ++iter) {
+    PROFILE_SCOPE("Iteration");
+    iterTimer.reset();
+    NLLSIterInfo info;
+    // Compute direction 'h' from the damped system A = J'J + mu*D.
+    timer.reset();
+    A_ = JJ_.template cast<SolveScalar>();
+    if (dampEye) {
+      A_.diagonal().array() += SolveScalar(mu);
+    } else {
+      A_.diagonal() *= SolveScalar(1.0 + mu);
+    }
     double rho_denom;
-    if (opts.lmOpts.dampMatrix == NLLSOpts::LMOpts::DAMP_MATRIX_EYE) {
-      rho_denom = h.dot(mu*h - Jf);
+    if (!bounded) {
+      {
+        PROFILE_SCOPE("Factorize");
+        llt_.compute(A_);
+      }
+      ++result->numFactorizations;
+      h_s_ = -Jf_.template cast<SolveScalar>();
+      llt_.solveInPlace(h_s_);
+      h_ = h_s_.template cast<double>();
+      x_new_ = x + h_;
+      if (dampEye) {
+        rho_denom = mu * h_.squaredNorm() - h_.dot(Jf_);
+      } else {
+        rho_denom = mu * h_.dot(JJdiag_.cwiseProduct(h_)) - h_.dot(Jf_);
+      }
     } else {
-      rho_denom = h.dot(damp*h - Jf);
+      // Projected step on the free variables, with model decrease computed
+      // from L(h) = ||f + J*h||^2 since the projection changes 'h'.
+      h_ = BoundedLMStep(A_, Jf_, x, lb_, ub_, &result->numFactorizations);
+      x_new_ = x + h_;
+      ClampToBounds(opts, &x_new_);
+      rho_denom = ModelDecrease(x_new_ - x);
+      if (rho_denom <= 0) {
+        // The projection spoils the step, so truncate it at the first bound
+        // instead, which always decreases the (convex) model.
+        double alpha = 1.0;
+        for (int i = 0; i < N; ++i) {
+          if (h_(i) > 0) {
+            alpha = std::min(alpha, (ub_(i) - x(i)) / h_(i));
+          } else if (h_(i) < 0) {
+            alpha = std::min(alpha, (lb_(i) - x(i)) / h_(i));
+          }
+        }
+        x_new_ = x + alpha * h_;
+        ClampToBounds(opts, &x_new_);
+        rho_denom = ModelDecrease(x_new_ - x);
+      }
+    }
+    info.timeSolve = timer.elapsed();
+    info.stepNorm = (x_new_ - x).norm();
+    // Compute the new 'f' and 'J'.
+    timer.reset();
+    {
+      PROFILE_SCOPE("Function");
+      fcnJac(x_new_, params, &f_, &J_);
     }
+    info.timeFcn = timer.elapsed();
+    timer.reset();
+    double F_new = ApplyLoss(opts.lossOpts, &f_, &J_);
+    // Compute gain ratio 'rho'.
     double rho = (F - F_new) / rho_denom;
     if (rho > 0) {
       // Step accepted.
-      x_old = x;   x = x_new;
-      F_old = F;   F = F_new;
-      Jt = J.transpose();      JJ = Jt * J;      Jf = Jt * f;
+      x.swap(x_new_);   x_old_.swap(x_new_);
+      F_old = F;        F = F_new;
+      UpdateNormalEquations();
       mu = std::max(mu_min, mu*std::max(1.0/3.0, 1.0-pow(2.0*rho-1, 3)));
       nu = 2;
     } else {
       // Step not accepted.
       mu *= nu;      nu *= 2;
     }
+    info.timeSolve += timer.elapsed();
     // Display information.
     PrintIterInfo_LM(opts, iter+1, F, rho, mu, nu);
+    info.iter = iter+1;   info.F = F;   info.rho = rho;
+    info.mu = mu;         info.nu = nu;
+    if (ReportIterInfo(opts, iterTimer.elapsed(), &info)) {
+      result->exitflag = 5;
+      break;
+    }
     // Check the stop criterion.
     result->exitflag = StopCriterion_LM(rho_denom, rho, F_old, F, aTolF,
-                                        x_old, x, aTolX);
+                                        x_old_, x, aTolX);
     if (result->exitflag)   break;
   }
   result->finalIter = iter;
@@ -193,7 +872,25 @@ Eigen::VectorXd NonlinearLeastSquares_LM(
   PrintFinalInfo(opts, *result);
   return x;
 }
-}   // namespace
+
+template <typename JScalar, typename SolveScalar>
+void NLLSSolverT<JScalar, SolveScalar>::UpdateNormalEquations() {
+  JJ_.noalias() = J_.transpose() * J_;
+  Jf_j_.noalias() = J_.transpose() * f_;
+  Jf_ = Jf_j_.template cast<double>();
+  JJdiag_ = JJ_.diagonal().template cast<double>();
+}
+
+template <typename JScalar, typename SolveScalar>
+double NLLSSolverT<JScalar, SolveScalar>::ModelDecrease(
+    const Eigen::VectorXd& h) const {
+  return -(2.0*h.dot(Jf_) +
+           h.dot(JJ_.template cast<double>() * h));
+}
+
+template class NLLSSolverT<double, double>;
+template class NLLSSolverT<float, double>;
+template class NLLSSolverT<float, float>;
 
 Eigen::VectorXd NonlinearLeastSquares(
     const VectorFunctionJacobian& fcnJac,
@@ -209,12 +906,165 @@ Eigen::VectorXd NonlinearLeastSquares(
   }
   // Dispatch the job.
   switch (opts.algorithm) {
-    case NLLSOpts::ALGORITHM_LM:
-      return NonlinearLeastSquares_LM(fcnJac, params, x0, opts, result);
+    case NLLSOpts::ALGORITHM_LM: {
+      NLLSSolver solver(opts);
+      return solver.Solve(fcnJac, params, x0, result);
+    }
+    case NLLSOpts::ALGORITHM_DOGLEG:
+    case NLLSOpts::ALGORITHM_SUBSPACE_TR:
+      return NonlinearLeastSquares_TR(fcnJac, params, x0, opts, result);
     default:
       LOG(FATAL) << "Unhandled algorithm.";
       return x0;
   }
 }
 
+Eigen::VectorXd NonlinearLeastSquares(
+    const VectorFunctionJacobianF& fcnJac,
+    void* params,
+    const Eigen::VectorXd& x0,
+    const NLLSOpts& opts,
+    NLLSResultInfo* result) {
+  if (opts.algorithm != NLLSOpts::ALGORITHM_LM) {
+    LOG(FATAL) << "Only 'ALGORITHM_LM' supports single precision Jacobian.";
+  }
+  NLLSSolverMixed solver(opts);
+  return solver.Solve(fcnJac, params, x0, result);
+}
+
+Eigen::VectorXd NonlinearLeastSquaresMatrixFree(
+    const MatrixFreeNLLSFunctions& fcns,
+    void* params,
+    const Eigen::VectorXd& x0,
+    const NLLSOpts& opts,
+    NLLSResultInfo* result) {
+  PROFILE_SCOPE("NonlinearLeastSquaresMatrixFree");
+  NLLSResultInfo _result;
+  if (!result) {
+    result = &_result;
+  }
+  CHECK(fcns.fcn);
+  CHECK(fcns.jacProd);
+  if (opts.lossOpts.type != NLLSOpts::LossOpts::LOSS_SQUARED) {
+    LOG(FATAL) << "Robust loss is not supported by the matrix-free algorithm.";
+  }
+  // ================================================================
+  // Initialization.
+  // ================================================================
+  Eigen::VectorXd x = x0;
+  Eigen::VectorXd f;
+  fcns.fcn(x, params, &f);
+  double F = f.squaredNorm();
+  MatrixFreeLMSystem A(fcns, params, opts);
+  A.SetPoint(x);
+  Eigen::VectorXd Jf;
+  A.JacProd(f, true, &Jf);
+  result->numFactorizations = 0;
+  double mu = opts.lmOpts.tau * A.MaxGramDiag(Jf);
+  if (mu < std::numeric_limits<double>::epsilon()) {
+    // J is a zero matrix.
+    result->exitflag = 1;
+    result->finalIter = 0;
+    result->F = F;
+    PrintFinalInfo(opts, *result);
+    return x;
+  }
+  double mu_min = 1.0e-12;
+  double nu = 2.0;
+  double aTolX = opts.tolX / x.size();
+  double aTolF = opts.tolF / x.size();
+  Eigen::VectorXd x_old = x;
+  double F_old = F;
+  PrintIterInfoHeader_LM(opts);
+  PrintIterInfo_LM(opts, 0, F, 0.0, mu, nu);
+  // ================================================================
+  // Main loop.
+  // ================================================================
+  int iter;
+  Eigen::VectorXd h, Jh, x_new;
+  Timer iterTimer, timer;
+  for (iter = 0; iter < opts.maxIter; ++iter) {
+    PROFILE_SCOPE("Iteration");
+    iterTimer.reset();
+    NLLSIterInfo info;
+    // Compute direction 'h' by inexact Newton with forcing term 'eta'.
+    timer.reset();
+    A.SetDamping(mu);
+    double JfNorm = Jf.norm();
+    double eta = std::min(opts.cgOpts.forcingMax, sqrt(JfNorm));
+    SolvePCG(A, -Jf, eta * JfNorm, opts.cgOpts.maxIter, &h);
+    info.timeSolve = timer.elapsed();
+    // Handle boundary condition (naively).
+    x_new = x + h;
+    ClampToBounds(opts, &x_new);
+    h = x_new - x;
+    // Model decrease with L(h) = ||f + J*h||^2.
+    A.JacProd(h, false, &Jh);
+    double rho_denom = -(2.0*h.dot(Jf) + Jh.squaredNorm());
+    info.stepNorm = h.norm();
+    // Compute the new 'f'.
+    Eigen::VectorXd f_new;
+    timer.reset();
+    {
+      PROFILE_SCOPE("Function");
+      fcns.fcn(x_new, params, &f_new);
+    }
+    info.timeFcn = timer.elapsed();
+    double F_new = f_new.squaredNorm();
+    double rho = (F - F_new) / rho_denom;
+    if (rho > 0) {
+      // Step accepted.
+      x_old = x;   x = x_new;
+      F_old = F;   F = F_new;
+      f = f_new;
+      timer.reset();
+      A.SetPoint(x);
+      A.JacProd(f, true, &Jf);
+      info.timeFcn += timer.elapsed();
+      mu = std::max(mu_min, mu*std::max(1.0/3.0, 1.0-pow(2.0*rho-1, 3)));
+      nu = 2;
+    } else {
+      // Step not accepted.
+      mu *= nu;      nu *= 2;
+    }
+    // Display information.
+    PrintIterInfo_LM(opts, iter+1, F, rho, mu, nu);
+    info.iter = iter+1;   info.F = F;   info.rho = rho;
+    info.mu = mu;         info.nu = nu;
+    if (ReportIterInfo(opts, iterTimer.elapsed(), &info)) {
+      result->exitflag = 5;
+      break;
+    }
+    // Check the stop criterion.
+    result->exitflag = StopCriterion_LM(rho_denom, rho, F_old, F, aTolF,
+                                        x_old, x, aTolX);
+    if (result->exitflag)   break;
+  }
+  result->finalIter = iter;
+  result->F = F;
+  PrintFinalInfo(opts, *result);
+  return x;
+}
+
+NLLSIterHistory::NLLSIterHistory(int capacity)
+    : records_(capacity), start_(0), size_(0) {
+  CHECK_GT(capacity, 0);
+}
+
+void NLLSIterHistory::Push(const NLLSIterInfo& info) {
+  int cap = records_.size();
+  if (size_ < cap) {
+    records_[(start_ + size_) % cap] = info;
+    ++size_;
+  } else {
+    records_[start_] = info;
+    start_ = (start_ + 1) % cap;
+  }
+}
+
+bool RecordNLLSIterInfo(const NLLSIterInfo& info, void* history) {
+  static_cast<NLLSIterHistory*>(history)->Push(info);
+  return true;
+}
+
 }   // namespace xyUtils
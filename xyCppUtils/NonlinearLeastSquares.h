@@ -8,14 +8,36 @@
 #ifndef __XYUTILS_NONLINEAR_LEAST_SQUARES_H__
 #define __XYUTILS_NONLINEAR_LEAST_SQUARES_H__
 
+#include <vector>
 #include <Eigen/Core>
+#include <Eigen/Cholesky>
 
 #include "NumericalFunctionTypes.h"
 
 namespace xyUtils  {
 
+// Record of one iteration of the solvers. For the trust region algorithms, 'mu'
+// is the trust region radius and 'nu' is unused (zero).
+struct NLLSIterInfo {
+  int iter;
+  double F;
+  double rho;
+  double mu;
+  double nu;
+  double stepNorm;
+  double timeFcn;       // Time (in seconds) spent in the user functions.
+  double timeSolve;     // Time spent in the linear algebra: applying the loss,
+                        // forming J'J and J'f, factorizations and solves.
+  double timeOther;     // Time spent in everything else, e.g. the display.
+};
+
+// Callback called after each iteration with its record. Returning false
+// terminates the solver (with 'exitflag' 5).
+typedef bool (*NLLSIterCallback)(const NLLSIterInfo& info,
+                                 void* callbackParams);
+
 struct NLLSOpts {
-  enum AlgorithmType { ALGORITHM_LM };
+  enum AlgorithmType { ALGORITHM_LM, ALGORITHM_DOGLEG, ALGORITHM_SUBSPACE_TR };
   enum DisplayType { DISPLAY_OFF, DISPLAY_FINAL, DISPLAY_FINAL_DETAILED,
                      DISPLAY_ITER, DISPLAY_ITER_DETAILED };
   // Options for Levenberg-Marquardt algorithm.
@@ -28,27 +50,96 @@ struct NLLSOpts {
     DampMatrix dampMatrix;
     double tau;
   };
+  // Options for trust region algorithms (Powell's dogleg and the
+  // two-dimensional subspace method). Both factorize J'J only once per
+  // accepted step, and reuse the factorization when the radius shrinks.
+  struct TROpts {
+    // Constructor that sets default values.
+    TROpts() :
+        initRadius(0.0) { }
+
+    // Initial trust region radius, or 0 for the length of the first
+    // Gauss-Newton step, which scales with the problem.
+    double initRadius;
+  };
+  // Options for the conjugate gradient solver in matrix-free
+  // Levenberg-Marquardt algorithm (see 'NonlinearLeastSquaresMatrixFree').
+  struct CGOpts {
+    enum Preconditioner { PRECOND_NONE, PRECOND_JACOBI, PRECOND_BLOCK_JACOBI };
+    // Constructor that sets default values.
+    CGOpts() :
+        preconditioner(PRECOND_JACOBI), blockSize(1), maxIter(100),
+        forcingMax(0.1) { }
+
+    // Preconditioners other than PRECOND_NONE require the 'gramBlocks'
+    // function, and fall back to PRECOND_NONE without it.
+    Preconditioner preconditioner;
+    // Block size for PRECOND_BLOCK_JACOBI.
+    int blockSize;
+    // Maximum number of CG iterations per step.
+    int maxIter;
+    // CG stops when the residual is less than eta * ||J'f||, with the forcing
+    // term eta = min(forcingMax, sqrt(||J'f||)).
+    double forcingMax;
+  };
+  // Robust loss applied to each residual, i.e. the cost to be minimized is
+  //   F(x) = sum_i rho(f_i(x)^2),
+  // with 'rho' one of the following ('a' being 'scale'):
+  //   LOSS_SQUARED:  rho(s) = s.
+  //   LOSS_HUBER:    rho(s) = s if s <= a^2, and 2*a*sqrt(s) - a^2 otherwise.
+  //   LOSS_SOFT_L1:  rho(s) = 2*a^2 * (sqrt(1 + s/a^2) - 1).
+  //   LOSS_CAUCHY:   rho(s) = a^2 * log(1 + s/a^2).
+  //   LOSS_TUKEY:    rho(s) = a^2/3 * (1 - (1 - s/a^2)^3) if s <= a^2, and
+  //                  a^2/3 otherwise.
+  // The residuals and Jacobian rows are reweighted inside each iteration, with
+  // the second order correction of Triggs et al., "Bundle Adjustment -- A
+  // Modern Synthesis" where 'rho' is convex (for the losses above, which are
+  // all concave, this reduces to iteratively reweighted least squares). The
+  // matrix-free algorithm only supports LOSS_SQUARED.
+  struct LossOpts {
+    enum LossType { LOSS_SQUARED, LOSS_HUBER, LOSS_SOFT_L1, LOSS_CAUCHY,
+                    LOSS_TUKEY };
+    // Constructor that sets default values.
+    LossOpts() :
+        type(LOSS_SQUARED), scale(1.0) { }
+
+    LossType type;
+    // Residuals with magnitude larger than 'scale' are considered outliers.
+    double scale;
+  };
 
   // Constructor that sets default values.
   NLLSOpts() :
-      algorithm(ALGORITHM_LM), display(DISPLAY_OFF), lmOpts(),
+      algorithm(ALGORITHM_LM), display(DISPLAY_OFF), lmOpts(), trOpts(),
+      cgOpts(), lossOpts(),
       upperBound(), lowerBound(),
-      tolX(1e-6), tolF(1e-6), maxIter(400) { }
+      tolX(1e-6), tolF(1e-6), maxIter(400),
+      iterCallback(NULL), iterCallbackParams(NULL) { }
 
   AlgorithmType algorithm;
   DisplayType display;
   LMOpts lmOpts;
+  TROpts trOpts;
+  CGOpts cgOpts;
+  LossOpts lossOpts;
+  // Optional bounds on 'x', with NaN meaning unbounded. The dense algorithms
+  // handle them by projected steps on the variables not held at a bound, while
+  // the matrix-free algorithm simply clamps 'x' into the box.
   Eigen::VectorXd upperBound;
   Eigen::VectorXd lowerBound;
   double tolX;
   double tolF;
   int maxIter;
+  // Optional per-iteration callback, and the parameters passed to it.
+  NLLSIterCallback iterCallback;
+  void* iterCallbackParams;
 };
 
 struct NLLSResultInfo {
   int exitflag;
   int finalIter;
   double F;
+  int numFactorizations;    // Number of matrix factorizations performed.
 };
 
 Eigen::VectorXd NonlinearLeastSquares(
@@ -58,6 +149,142 @@ Eigen::VectorXd NonlinearLeastSquares(
     const NLLSOpts& opts,
     NLLSResultInfo* result);
 
+// Same as above, but with the function and Jacobian computed in single
+// precision. This runs the Levenberg-Marquardt algorithm in mixed precision (see
+// 'NLLSSolverMixed' below), and other 'opts.algorithm' are not supported.
+Eigen::VectorXd NonlinearLeastSquares(
+    const VectorFunctionJacobianF& fcnJac,
+    void* params,
+    const Eigen::VectorXd& x0,
+    const NLLSOpts& opts,
+    NLLSResultInfo* result);
+
+// Levenberg-Marquardt solver for a sequence of slowly changing problems (e.g.
+// one per video frame). It keeps the last solution, the damping 'mu' and all the
+// workspace between solves, so that a warm solve starts where the last one
+// stopped, and the vectors, matrices and factorization are not reallocated for
+// an unbounded problem of the same size with LOSS_SQUARED. The 'opts.algorithm'
+// is ignored. Example usage:
+//   NLLSSolver solver(nllsOpts);
+//   solver.Solve(fcnJac, &params, x0, &nllsResult);
+//   for (...) {
+//     // Update the data in 'params'.
+//     const Eigen::VectorXd& x = solver.SolveWarm(fcnJac, &params, &nllsResult);
+//   }
+//
+// The 'JScalar' is the precision of the residuals 'f', the Jacobian 'J' and J'J,
+// and 'SolveScalar' the precision of the damped system and its Cholesky
+// factorization. The parameters 'x', the gradient J'f, the cost and the gain
+// ratio are always in double, so that the accepted steps decrease the cost
+// computed in double. Only the three instantiations typedef'ed below are
+// available.
+template <typename JScalar, typename SolveScalar>
+class NLLSSolverT {
+ public:
+  typedef Eigen::Matrix<JScalar, Eigen::Dynamic, 1> JVector;
+  typedef Eigen::Matrix<JScalar, Eigen::Dynamic, Eigen::Dynamic> JMatrix;
+  typedef Eigen::Matrix<SolveScalar, Eigen::Dynamic, 1> SolveVector;
+  typedef Eigen::Matrix<SolveScalar, Eigen::Dynamic, Eigen::Dynamic>
+  SolveMatrix;
+  typedef void (*FcnJac)(const Eigen::VectorXd& x, const void* params,
+                         JVector* f, JMatrix* J);
+
+  explicit NLLSSolverT(const NLLSOpts& opts);
+  // Solve from 'x0', with the initial damping set from the Jacobian.
+  const Eigen::VectorXd& Solve(const FcnJac& fcnJac,
+                               void* params,
+                               const Eigen::VectorXd& x0,
+                               NLLSResultInfo* result);
+  // Solve from the last solution with the last damping. Must be called after
+  // 'Solve'.
+  const Eigen::VectorXd& SolveWarm(const FcnJac& fcnJac,
+                                   void* params,
+                                   NLLSResultInfo* result);
+  // The last solution.
+  const Eigen::VectorXd& x() const { return x_; }
+  // The options, which could be changed between solves.
+  NLLSOpts& opts() { return opts_; }
+ private:
+  const Eigen::VectorXd& Run(const FcnJac& fcnJac,
+                             void* params,
+                             bool warm,
+                             NLLSResultInfo* result);
+  // Update J'J, J'f and diag(J'J) from 'J_' and 'f_'.
+  void UpdateNormalEquations();
+  // Decrease of the linear model, L(0) - L(h) = -2h'J'f - h'J'Jh.
+  double ModelDecrease(const Eigen::VectorXd& h) const;
+
+  NLLSOpts opts_;
+  bool hasSolution_;
+  double mu_;
+  double nu_;
+  // Workspace.
+  Eigen::VectorXd x_, x_old_, x_new_, h_, Jf_, JJdiag_, lb_, ub_;
+  JVector f_, Jf_j_;
+  JMatrix J_, JJ_;
+  SolveVector h_s_;
+  SolveMatrix A_;
+  Eigen::LLT<SolveMatrix> llt_;
+};
+
+// Everything in double.
+typedef NLLSSolverT<double, double> NLLSSolver;
+// Residuals, Jacobian and J'J in single precision, and the factorization in
+// double. This halves the memory and bandwidth of the largest matrices, while
+// the steps are almost as accurate as 'NLLSSolver' on well-conditioned problems.
+typedef NLLSSolverT<float, double> NLLSSolverMixed;
+// Everything in single precision except the parameters and the cost. Fastest,
+// but the steps lose accuracy when J'J is ill-conditioned.
+typedef NLLSSolverT<float, float> NLLSSolverSingle;
+
+// A least squares problem given by its function and Jacobian products, without
+// ever forming the Jacobian. The 'gramBlocks' is optional (could be NULL) and
+// only used for preconditioning and DAMP_MATRIX_JJ.
+struct MatrixFreeNLLSFunctions {
+  VectorFunction fcn;
+  JacobianProduct jacProd;
+  JacobianGramBlocks gramBlocks;
+};
+
+// Matrix-free (inexact) Levenberg-Marquardt algorithm. Each step is solved by
+// preconditioned conjugate gradients using only J*v and J'*v products, so that
+// the memory is O(M+N) besides the preconditioner. The 'opts.algorithm' is
+// ignored, and 'opts.cgOpts' controls the linear solver.
+Eigen::VectorXd NonlinearLeastSquaresMatrixFree(
+    const MatrixFreeNLLSFunctions& fcns,
+    void* params,
+    const Eigen::VectorXd& x0,
+    const NLLSOpts& opts,
+    NLLSResultInfo* result);
+
+// A ring buffer keeping the records of the last 'capacity' iterations, all
+// allocated on construction. Example usage:
+//   NLLSIterHistory history(100);
+//   nllsOpts.iterCallback = RecordNLLSIterInfo;
+//   nllsOpts.iterCallbackParams = &history;
+//   NonlinearLeastSquares(fcnJac, params, x0, nllsOpts, &nllsResult);
+//   for (int i = 0; i < history.size(); ++i)   Process(history[i]);
+class NLLSIterHistory {
+ public:
+  explicit NLLSIterHistory(int capacity);
+  // Add a record, overwriting the oldest one if full.
+  void Push(const NLLSIterInfo& info);
+  void Clear() { start_ = size_ = 0; }
+  int size() const { return size_; }
+  int capacity() const { return records_.size(); }
+  // The i-th oldest record kept.
+  const NLLSIterInfo& operator[](int i) const {
+    return records_[(start_ + i) % records_.size()];
+  }
+ private:
+  std::vector<NLLSIterInfo> records_;
+  int start_;
+  int size_;
+};
+
+// An 'NLLSIterCallback' that pushes 'info' to the 'NLLSIterHistory' pointed by
+// 'history', and never terminates the solver.
+bool RecordNLLSIterInfo(const NLLSIterInfo& info, void* history);
 
 }   // namespace xyUtils
 
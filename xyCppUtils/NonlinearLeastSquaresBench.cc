@@ -0,0 +1,144 @@
+/**
+  * Benchmarks for nonlinear least squares.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "NonlinearLeastSquares.h"
+
+#include <cmath>
+#include <Eigen/Dense>
+
+#include "Benchmark.h"
+#include "CommandLineFlags.h"
+#include "LogAndCheck.h"
+
+using namespace Eigen;
+using namespace xyUtils;
+
+namespace {
+struct ExpLinearParams {
+  MatrixXd B;
+  MatrixXf B_f;
+  VectorXd m;
+};
+
+// f = exp(B*x) - m, elementwise, in double precision.
+void ExpLinearFcn(const VectorXd& x, const void* params,
+                  VectorXd* f, MatrixXd* J) {
+  const ExpLinearParams* p = static_cast<const ExpLinearParams*>(params);
+  VectorXd e = (p->B * x).array().exp();
+  *f = e - p->m;
+  if (J)   *J = e.asDiagonal() * p->B;
+}
+
+// Same as above, in single precision.
+void ExpLinearFcnF(const VectorXd& x, const void* params,
+                   VectorXf* f, MatrixXf* J) {
+  const ExpLinearParams* p = static_cast<const ExpLinearParams*>(params);
+  VectorXf e = (p->B_f * x.cast<float>()).array().exp();
+  *f = e - p->m.cast<float>();
+  if (J)   *J = e.asDiagonal() * p->B_f;
+}
+
+// Fit model(x; t) = x[2] * exp(x[0]*t) + x[3] * exp(x[1]*t) to the samples 'm'
+// at 't', as in NonlinearLeastSquaresTest.
+struct TwoExpParams {
+  VectorXd t;
+  VectorXd m;
+};
+
+void TwoExpFcn(const VectorXd& x, const void* params,
+               VectorXd* f, MatrixXd* J) {
+  const TwoExpParams* p = static_cast<const TwoExpParams*>(params);
+  VectorXd exp_x0t = (x(0) * p->t).array().exp();
+  VectorXd exp_x1t = (x(1) * p->t).array().exp();
+  *f = x(2) * exp_x0t + x(3) * exp_x1t - p->m;
+  if (J) {
+    J->resize(f->size(), 4);
+    J->col(0) = x(2) * p->t.cwiseProduct(exp_x0t);
+    J->col(1) = x(3) * p->t.cwiseProduct(exp_x1t);
+    J->col(2) = exp_x0t;
+    J->col(3) = exp_x1t;
+  }
+}
+}   // namespace
+
+int main(int argc, char** argv)  {
+  CommandLineFlagsInit(&argc, &argv, true);
+  BenchmarkSuite suite("NonlinearLeastSquares");
+
+  const int M = 2000, N = 100;
+  ExpLinearParams params;
+  params.B = MatrixXd::Random(M, N) / std::sqrt(double(N));
+  params.B_f = params.B.cast<float>();
+  VectorXd x_gt = 0.5 * VectorXd::Random(N);
+  params.m = (params.B * x_gt).array().exp();
+  VectorXd x0 = VectorXd::Zero(N);
+  NLLSOpts opts;
+  NLLSResultInfo result;
+  VectorXd x;
+
+  // Algorithms in double precision.
+  const char* algNames[] = {"ExpLinear/LM", "ExpLinear/Dogleg",
+                            "ExpLinear/SubspaceTR"};
+  for (int a = 0; a < 3; ++a) {
+    opts.algorithm = static_cast<NLLSOpts::AlgorithmType>(a);
+    if (suite.Run(algNames[a], [&]() {
+          x = NonlinearLeastSquares(ExpLinearFcn, &params, x0, opts, &result);
+        }, 0, M)) {
+      CHECK_LT((x - x_gt).cwiseAbs().maxCoeff(), 1e-6);
+    }
+  }
+
+  // A small problem that takes many iterations, without and with a bound on
+  // x[0]. The trust region algorithms factorize only after accepted steps, and
+  // the iterations and factorizations are logged to compare with their time.
+  TwoExpParams twoExp;
+  twoExp.t = VectorXd::LinSpaced(10, -1.5, 3.5);
+  twoExp.m = 2.0 * twoExp.t.array().exp() +
+      3.0 * (-0.5 * twoExp.t).array().exp();
+  VectorXd x0_twoExp = VectorXd::Zero(4);
+  const char* twoExpNames[] = {"TwoExp/LM", "TwoExp/Dogleg",
+                               "TwoExp/SubspaceTR", "TwoExp/LM/Bounded",
+                               "TwoExp/Dogleg/Bounded",
+                               "TwoExp/SubspaceTR/Bounded"};
+  for (int a = 0; a < 6; ++a) {
+    opts = NLLSOpts();
+    opts.algorithm = static_cast<NLLSOpts::AlgorithmType>(a % 3);
+    if (a >= 3) {
+      opts.upperBound = VectorXd::Constant(4, std::nan(""));
+      opts.upperBound(0) = 0.5;
+    }
+    if (suite.Run(twoExpNames[a], [&]() {
+          x = NonlinearLeastSquares(TwoExpFcn, &twoExp, x0_twoExp, opts,
+                                    &result);
+        })) {
+      CHECK_LT(result.F, 1e-6);
+      LOG(INFO) << twoExpNames[a] << ": " << result.finalIter
+                << " iterations, " << result.numFactorizations
+                << " factorizations.";
+    }
+  }
+
+  // Precisions of Levenberg-Marquardt.
+  opts = NLLSOpts();
+  suite.Run("ExpLinear/LM/Double", [&]() {
+      NLLSSolver solver(opts);
+      x = solver.Solve(ExpLinearFcn, &params, x0, &result);
+    }, 0, M);
+  suite.Run("ExpLinear/LM/Mixed", [&]() {
+      NLLSSolverMixed solver(opts);
+      x = solver.Solve(ExpLinearFcnF, &params, x0, &result);
+    }, 0, M);
+  if (suite.Run("ExpLinear/LM/Single", [&]() {
+        NLLSSolverSingle solver(opts);
+        x = solver.Solve(ExpLinearFcnF, &params, x0, &result);
+      }, 0, M)) {
+    CHECK_LT((x - x_gt).cwiseAbs().maxCoeff(), 1e-4);
+  }
+
+  suite.Finish();
+  return 0;
+}
@@ -9,6 +9,7 @@
 
 #include <cmath>
 #include <cstdlib>
+#include <iomanip>
 
 #ifdef __USE_TR1__
 #include <tr1/random>
@@ -16,7 +17,6 @@
 #include <random>
 #endif
 
-#include "EigenUtils.h"
 #include "LogAndCheck.h"
 #include "NumericalCheck.h"
 #include "Timer.h"
@@ -60,6 +60,121 @@ static void TestFcn(const VectorXd& x, const void* params,
   }
 }
 
+// Matrix-free interface of 'TestFcn', using the dense Jacobian internally.
+static void TestFcnOnly(const VectorXd& x, const void* params, VectorXd* f) {
+  TestFcn(x, params, f, NULL);
+}
+
+static void TestFcnJacProd(const VectorXd& x, const void* params,
+                           const VectorXd& v, bool transpose, VectorXd* Jv) {
+  VectorXd f;
+  MatrixXd J;
+  TestFcn(x, params, &f, &J);
+  *Jv = transpose ? VectorXd(J.transpose() * v) : VectorXd(J * v);
+}
+
+static void TestFcnGramBlocks(const VectorXd& x, const void* params,
+                              int blockSize, MatrixXd* D) {
+  VectorXd f;
+  MatrixXd J;
+  TestFcn(x, params, &f, &J);
+  MatrixXd JJ = J.transpose() * J;
+  int N = x.size();
+  D->resize(N, blockSize);
+  for (int start = 0; start < N; start += blockSize) {
+    int n = min(blockSize, N - start);
+    D->block(start, 0, n, n) = JJ.block(start, start, n, n);
+  }
+}
+
+/**
+ * The extended Rosenbrock function, which is to be solved matrix-free
+ *   f(2i) = 10 * (x(2i+1) - x(2i)^2),   f(2i+1) = 1 - x(2i).
+ * The J'J is block diagonal with 2x2 blocks.
+ */
+static void RosenbrockFcn(const VectorXd& x, const void* params, VectorXd* f) {
+  (void) params;
+  int N = x.size();
+  f->resize(N);
+  for (int i = 0; i < N; i += 2) {
+    (*f)(i) = 10.0 * (x(i+1) - x(i)*x(i));
+    (*f)(i+1) = 1.0 - x(i);
+  }
+}
+
+static void RosenbrockJacProd(const VectorXd& x, const void* params,
+                              const VectorXd& v, bool transpose, VectorXd* Jv) {
+  (void) params;
+  int N = x.size();
+  Jv->resize(N);
+  for (int i = 0; i < N; i += 2) {
+    if (transpose) {
+      (*Jv)(i) = -20.0 * x(i) * v(i) - v(i+1);
+      (*Jv)(i+1) = 10.0 * v(i);
+    } else {
+      (*Jv)(i) = -20.0 * x(i) * v(i) + 10.0 * v(i+1);
+      (*Jv)(i+1) = -v(i);
+    }
+  }
+}
+
+static void RosenbrockGramBlocks(const VectorXd& x, const void* params,
+                                 int blockSize, MatrixXd* D) {
+  (void) params;
+  CHECK(blockSize == 1 || blockSize % 2 == 0);
+  int N = x.size();
+  D->setZero(N, blockSize);
+  for (int i = 0; i < N; i += 2) {
+    double a = 400.0 * x(i) * x(i) + 1.0, b = -200.0 * x(i), c = 100.0;
+    if (blockSize == 1) {
+      (*D)(i, 0) = a;
+      (*D)(i+1, 0) = c;
+    } else {
+      int r = i % blockSize;
+      (*D)(i, r) = a;      (*D)(i, r+1) = b;
+      (*D)(i+1, r) = b;    (*D)(i+1, r+1) = c;
+    }
+  }
+}
+
+struct ExpLinearParams {
+  MatrixXd B;
+  MatrixXf B_f;
+  VectorXd m;
+};
+
+/**
+ * A larger test function f = exp(B*x) - m, elementwise, with 'B' of size M x N.
+ * The residuals and Jacobian are computed in 'Scalar' precision.
+ */
+template <typename Scalar>
+static void ExpLinearFcn(const VectorXd& x, const void* params,
+                         Matrix<Scalar, Dynamic, 1>* f,
+                         Matrix<Scalar, Dynamic, Dynamic>* J);
+
+template <>
+void ExpLinearFcn<double>(const VectorXd& x, const void* params,
+                          VectorXd* f, MatrixXd* J) {
+  const ExpLinearParams* p = static_cast<const ExpLinearParams*>(params);
+  VectorXd e = (p->B * x).array().exp();
+  *f = e - p->m;
+  if (J)   *J = e.asDiagonal() * p->B;
+}
+
+template <>
+void ExpLinearFcn<float>(const VectorXd& x, const void* params,
+                         VectorXf* f, MatrixXf* J) {
+  const ExpLinearParams* p = static_cast<const ExpLinearParams*>(params);
+  VectorXf e = (p->B_f * x.cast<float>()).array().exp();
+  *f = e - p->m.cast<float>();
+  if (J)   *J = e.asDiagonal() * p->B_f;
+}
+
+// An 'NLLSIterCallback' that stops when F is less than '*params'.
+static bool StopBelowF(const NLLSIterInfo& info, void* params) {
+  return info.F >= *static_cast<double*>(params);
+}
+
 int main()  {
   Timer timer;
   LOG(INFO) << "Test on NonlinearLeastSquares ...";
@@ -81,7 +196,9 @@ int main()  {
   // Generate data.
   int M = 10;
   TestFcnParams params(M);
-  params.t = EigenUtils::RandnVectorXd(M, rand());
+  // Evenly spaced sample points, over a range wide enough for the two
+  // exponentials to be told apart from any of the starting points below.
+  params.t = VectorXd::LinSpaced(M, -1.5, 3.5);
   params.m = x_gt(2) * (x_gt(0)*params.t).array().exp() +
       x_gt(3) * (x_gt(1)*params.t).array().exp();
   CheckJacobian(TestFcn, &params, N);
@@ -101,6 +218,54 @@ int main()  {
   double F = f.squaredNorm();
   CHECK_NEAR(F, nllsResult.F, 1e-6);
 
+  // Iteration records in a ring buffer.
+  NLLSIterHistory history(5);
+  nllsOpts.iterCallback = RecordNLLSIterInfo;
+  nllsOpts.iterCallbackParams = &history;
+  NonlinearLeastSquares(TestFcn, &params, x0, nllsOpts, &nllsResult);
+  CHECK_EQ(history.size(), 5);
+  for (int i = 0; i < history.size(); ++i) {
+    CHECK_EQ(history[i].iter, nllsResult.finalIter - 3 + i);
+    CHECK_GE(history[i].timeFcn, 0.0);
+    CHECK_GE(history[i].timeSolve, 0.0);
+    // The buckets do not overlap, so the rest is never negative.
+    CHECK_GE(history[i].timeOther, 0.0);
+  }
+  CHECK_EQ(history[4].F, nllsResult.F);
+  // Early termination by the callback.
+  double stopF = 1.0;
+  nllsOpts.iterCallback = StopBelowF;
+  nllsOpts.iterCallbackParams = &stopF;
+  NonlinearLeastSquares(TestFcn, &params, x0, nllsOpts, &nllsResult);
+  CHECK_EQ(nllsResult.exitflag, 5);
+  CHECK_LT(nllsResult.F, stopF);
+  nllsOpts.iterCallback = NULL;
+  nllsOpts.iterCallbackParams = NULL;
+
+  // A sequence of slowly changing problems, solved from the last solution
+  // either from scratch or warm started with the last damping.
+  NLLSOpts solverOpts;
+  NLLSSolver solver(solverOpts);
+  solver.Solve(TestFcn, &params, x_gt, NULL);
+  TestFcnParams frameParams = params;
+  VectorXd x_cold = solver.x();
+  int coldIters = 0, warmIters = 0;
+  for (int k = 1; k <= 10; ++k) {
+    VectorXd x_frame = x_gt + 0.01 * k * VectorXd::Ones(N);
+    frameParams.m = x_frame(2) * (x_frame(0)*frameParams.t).array().exp() +
+        x_frame(3) * (x_frame(1)*frameParams.t).array().exp();
+    x_cold = NonlinearLeastSquares(TestFcn, &frameParams, x_cold, solverOpts,
+                                   &nllsResult);
+    coldIters += nllsResult.finalIter;
+    CheckNear(x_cold, x_frame, 1e-4);
+    solver.SolveWarm(TestFcn, &frameParams, &nllsResult);
+    warmIters += nllsResult.finalIter;
+    CheckNear(solver.x(), x_frame, 1e-4);
+  }
+  LOG(INFO) << "Sequential solves: " << coldIters << " iterations cold, "
+            << warmIters << " iterations warm.";
+  CHECK_LT(warmIters, coldIters);
+
   // Bounded optimization.
   nllsOpts.upperBound = VectorXd(4);
   nllsOpts.upperBound(0) = 0.5;
@@ -111,6 +276,189 @@ int main()  {
   x = NonlinearLeastSquares(TestFcn, &params, x0, nllsOpts, NULL);
   CheckNear(x, x_gt2, 0.01);
 
+  // Bounds that are active at the solution. The result should satisfy the
+  // first order optimality conditions, i.e. zero gradient for the free
+  // variables, and the gradient pointing outward at the active bounds.
+  NLLSOpts boundedOpts;
+  boundedOpts.lowerBound = VectorXd::Constant(N, nan(""));
+  boundedOpts.upperBound = VectorXd::Constant(N, nan(""));
+  boundedOpts.lowerBound(1) = -0.4;
+  boundedOpts.upperBound(2) = 1.5;
+  x = NonlinearLeastSquares(TestFcn, &params, x0, boundedOpts, &nllsResult);
+  LOG(INFO) << "Bounded LM with active bounds: " << nllsResult.finalIter
+            << " iterations.";
+  MatrixXd J;
+  TestFcn(x, &params, &f, &J);
+  VectorXd grad = J.transpose() * f;
+  double gradTol = 1e-3 * grad.cwiseAbs().maxCoeff() + 1e-6;
+  for (int i = 0; i < N; ++i) {
+    CHECK(!(x(i) < boundedOpts.lowerBound(i)) &&
+          !(x(i) > boundedOpts.upperBound(i)));
+    if (x(i) == boundedOpts.lowerBound(i)) {
+      CHECK_GE(grad(i), -gradTol);
+    } else if (x(i) == boundedOpts.upperBound(i)) {
+      CHECK_LE(grad(i), gradTol);
+    } else {
+      CHECK_NEAR(grad(i), 0.0, gradTol);
+    }
+  }
+
+  // Different algorithms on the same problems. The trust region algorithms
+  // factorize only after accepted steps, so they need fewer factorizations than
+  // LM. Their timing is in NonlinearLeastSquaresBench.
+  const char* algNames[] = {"LM", "Dogleg", "SubspaceTR"};
+  NLLSOpts::AlgorithmType algs[] = {NLLSOpts::ALGORITHM_LM,
+                                    NLLSOpts::ALGORITHM_DOGLEG,
+                                    NLLSOpts::ALGORITHM_SUBSPACE_TR};
+  LOG(INFO) << "Algorithm      Bounded   Iters  Factorizations";
+  for (int bounded = 0; bounded <= 1; ++bounded) {
+    int lmFactorizations = 0;
+    for (int i = 0; i < 3; ++i) {
+      NLLSOpts opts;
+      opts.algorithm = algs[i];
+      if (bounded)   opts.upperBound = nllsOpts.upperBound;
+      x = NonlinearLeastSquares(TestFcn, &params, x0, opts, &nllsResult);
+      if (bounded) {
+        CheckNear(x, x_gt2, 0.01);
+      } else {
+        CHECK(CheckNear(x, x_gt, 0.01, false) ||
+              CheckNear(x, x_gt2, 0.01, false));
+      }
+      TestFcn(x, &params, &f, NULL);
+      CHECK_NEAR(f.squaredNorm(), nllsResult.F, 1e-6);
+      LOG(INFO) << std::setw(10) << algNames[i] << std::setw(12) << bounded
+                << std::setw(8) << nllsResult.finalIter
+                << std::setw(16) << nllsResult.numFactorizations;
+      if (algs[i] == NLLSOpts::ALGORITHM_LM) {
+        lmFactorizations = nllsResult.numFactorizations;
+      } else {
+        CHECK_LT(nllsResult.numFactorizations, lmFactorizations);
+      }
+    }
+  }
+
+  // Robust losses on data contaminated by outliers.
+  int M_outlier = 50;
+  TestFcnParams outlierParams(M_outlier);
+  outlierParams.t = VectorXd::LinSpaced(M_outlier, -1.5, 3.5);
+  outlierParams.m = x_gt(2) * (x_gt(0)*outlierParams.t).array().exp() +
+      x_gt(3) * (x_gt(1)*outlierParams.t).array().exp();
+  for (int i = 0; i < M_outlier; i += 10) {
+    outlierParams.m(i) += (i % 2 ? 1.0 : -1.0) * (10.0 + i);
+  }
+  VectorXd x0_outlier(N);
+  x0_outlier << 0.5, -0.2, 1.0, 1.0;
+  // Tukey loss rejects all residuals larger than 'scale', so it needs a larger
+  // scale to start from 'x0_outlier'.
+  const char* lossNames[] = {"Squared", "Huber", "SoftL1", "Cauchy", "Tukey"};
+  double lossScales[] = {1.0, 1.0, 1.0, 1.0, 3.0};
+  // Every robust loss should fit better and in fewer iterations than the
+  // squared loss, which is run first.
+  double squaredErr = 0.0;
+  int squaredIters = 0;
+  LOG(INFO) << "Loss     Iters       Error";
+  for (int i = 0; i < 5; ++i) {
+    NLLSOpts opts;
+    opts.lossOpts.type = static_cast<NLLSOpts::LossOpts::LossType>(i);
+    opts.lossOpts.scale = lossScales[i];
+    x = NonlinearLeastSquares(TestFcn, &outlierParams, x0_outlier, opts,
+                              &nllsResult);
+    double err = min((x - x_gt).cwiseAbs().maxCoeff(),
+                     (x - x_gt2).cwiseAbs().maxCoeff());
+    LOG(INFO) << std::setw(7) << lossNames[i] << std::setw(8)
+              << nllsResult.finalIter << std::setw(12) << err;
+    if (opts.lossOpts.type == NLLSOpts::LossOpts::LOSS_SQUARED) {
+      CHECK_GT(err, 0.5);
+      squaredErr = err;
+      squaredIters = nllsResult.finalIter;
+      continue;
+    }
+    CHECK_LT(err, squaredErr);
+    CHECK_LT(nllsResult.finalIter, squaredIters);
+    if (opts.lossOpts.type == NLLSOpts::LossOpts::LOSS_HUBER ||
+        opts.lossOpts.type == NLLSOpts::LossOpts::LOSS_SOFT_L1) {
+      CHECK_LT(err, 0.1);
+    } else if (opts.lossOpts.type == NLLSOpts::LossOpts::LOSS_CAUCHY) {
+      CHECK_LT(err, 0.05);
+    } else if (opts.lossOpts.type == NLLSOpts::LossOpts::LOSS_TUKEY) {
+      CHECK_LT(err, 1e-4);
+    }
+  }
+
+  // Matrix-free algorithm on the same problem. The inexact steps take a
+  // different path than the dense ones, and the problem has other local minima
+  // (e.g. starting at zero), so start from a point closer to the solution.
+  MatrixFreeNLLSFunctions testFcns = {TestFcnOnly, TestFcnJacProd,
+                                      TestFcnGramBlocks};
+  nllsOpts = NLLSOpts();
+  VectorXd x0_mf(N);
+  x0_mf << 0.5, -0.2, 1.0, 1.0;
+  x = NonlinearLeastSquaresMatrixFree(testFcns, &params, x0_mf, nllsOpts,
+                                      &nllsResult);
+  CHECK(CheckNear(x, x_gt, 0.01, false) ||
+        CheckNear(x, x_gt2, 0.01, false));
+  TestFcn(x, &params, &f, NULL);
+  CHECK_NEAR(f.squaredNorm(), nllsResult.F, 1e-6);
+
+  // Large matrix-free problem with different preconditioners.
+  int N_rosen = 20000;
+  VectorXd x0_rosen(N_rosen);
+  for (int i = 0; i < N_rosen; i += 2) {
+    x0_rosen(i) = -1.2;
+    x0_rosen(i+1) = 1.0;
+  }
+  MatrixFreeNLLSFunctions rosenFcns = {RosenbrockFcn, RosenbrockJacProd,
+                                       RosenbrockGramBlocks};
+  const char* precondNames[] = {"None", "Jacobi", "BlockJacobi"};
+  for (int p = 0; p < 3; ++p) {
+    nllsOpts.cgOpts.preconditioner =
+        static_cast<NLLSOpts::CGOpts::Preconditioner>(p);
+    nllsOpts.cgOpts.blockSize = 2;
+    Timer mfTimer;
+    x = NonlinearLeastSquaresMatrixFree(rosenFcns, NULL, x0_rosen, nllsOpts,
+                                        &nllsResult);
+    CheckNear(x, VectorXd::Ones(N_rosen), 1e-4);
+    LOG(INFO) << "Matrix-free LM (" << precondNames[p] << "): "
+              << nllsResult.finalIter << " iterations, "
+              << mfTimer.elapsed() << " seconds.";
+  }
+
+  // Double, mixed and single precision LM on a larger problem.
+  int M_exp = 2000, N_exp = 100;
+  ExpLinearParams expParams;
+  expParams.B = MatrixXd::Random(M_exp, N_exp) / sqrt(double(N_exp));
+  expParams.B_f = expParams.B.cast<float>();
+  VectorXd x_gt_exp = 0.5 * VectorXd::Random(N_exp);
+  expParams.m = (expParams.B * x_gt_exp).array().exp();
+  VectorXd x0_exp = VectorXd::Zero(N_exp);
+  nllsOpts = NLLSOpts();
+  const char* precNames[] = {"Double", "Mixed", "Single"};
+  LOG(INFO) << "Precision   Iters        Cost       Error   Time (s)";
+  for (int i = 0; i < 3; ++i) {
+    Timer precTimer;
+    VectorXd x_exp;
+    if (i == 0) {
+      NLLSSolver solver(nllsOpts);
+      x_exp = solver.Solve(ExpLinearFcn<double>, &expParams, x0_exp,
+                           &nllsResult);
+    } else if (i == 1) {
+      x_exp = NonlinearLeastSquares(ExpLinearFcn<float>, &expParams, x0_exp,
+                                    nllsOpts, &nllsResult);
+    } else {
+      NLLSSolverSingle solver(nllsOpts);
+      x_exp = solver.Solve(ExpLinearFcn<float>, &expParams, x0_exp,
+                           &nllsResult);
+    }
+    double t = precTimer.elapsed();
+    double err = (x_exp - x_gt_exp).cwiseAbs().maxCoeff();
+    LOG(INFO) << std::setw(9) << precNames[i] << std::setw(8)
+              << nllsResult.finalIter << std::setw(12) << nllsResult.F
+              << std::setw(12) << err << std::setw(11) << t;
+    // The single precision residuals limit the accuracy to about the float
+    // epsilon times the condition number.
+    CHECK_LT(err, i == 0 ? 1e-9 : 1e-4);
+  }
+
   LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
   return 0;
 }
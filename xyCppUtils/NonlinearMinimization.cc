@@ -0,0 +1,279 @@
+/**
+  * Nonlinear minimization of smooth scalar functions.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "NonlinearMinimization.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <Eigen/Core>
+
+#include "LogAndCheck.h"
+
+namespace xyUtils  {
+
+namespace {
+void PrintIterInfoHeader(const NLMOpts& opts) {
+  if (opts.display >= NLMOpts::DISPLAY_ITER) {
+    LOG(PLAIN) << std::setw(5) << "Iters" << "  "
+               << std::setw(15) << "F(x)";
+    if (opts.display >= NLMOpts::DISPLAY_ITER_DETAILED) {
+      LOG(PLAIN) << std::setw(12) << "Step size";
+    }
+    LOG(PLAIN) << "\n";
+  }
+}
+
+void PrintIterInfo(const NLMOpts& opts, int iter, double f, double alpha) {
+  if (opts.display >= NLMOpts::DISPLAY_ITER) {
+    LOG(PLAIN) << std::setw(5) << iter << "  "
+               << std::setw(15) << std::setprecision(8) << f;
+    if (opts.display >= NLMOpts::DISPLAY_ITER_DETAILED) {
+      LOG(PLAIN) << std::setw(12) << std::setprecision(3) << alpha;
+    }
+    LOG(PLAIN) << "\n";
+  }
+}
+
+void PrintFinalInfo(const NLMOpts& opts, const NLMResultInfo& result) {
+  if (opts.display >= NLMOpts::DISPLAY_FINAL) {
+    LOG(PLAIN) << "Terminate in " << result.finalIter << " iterations: ";
+    switch (result.exitflag) {
+      case 0:
+        LOG(PLAIN) << "maximum number of iterations reached.\n";
+        break;
+      case 1:
+        LOG(PLAIN) << "magnitude of gradient less than 'tolFun' ("
+                   << opts.tolFun << ").\n";
+        break;
+      case 2:
+        LOG(PLAIN) << "change in 'x' less than 'tolX' (" << opts.tolX << ").\n";
+        break;
+      case 3:
+        LOG(PLAIN) << "change in 'f' less than 'tolFun' (" << opts.tolFun
+                   << ").\n";
+        break;
+      default:
+        LOG(FATAL) << "Unknown 'exitflag'.";
+    }
+  }
+}
+
+// Stop criterion as 'NLOBox/NLM_StopCriterion.m', with 's' = x - x_old.
+int StopCriterion(const Eigen::VectorXd& s, double tolX,
+                  double f_old, double f, double tolFun,
+                  const Eigen::VectorXd& g) {
+  if (g.cwiseAbs().maxCoeff() < tolFun) {
+    return 1;
+  } else if (s.cwiseAbs().maxCoeff() < tolX) {
+    return 2;
+  } else if (f_old - f < tolFun) {
+    return 3;
+  } else {
+    return 0;
+  }
+}
+
+// Evaluate phi(alpha) = fcn(x0 + alpha*h) at point 'x', with the derivative
+// 'dphi' = h'*g.
+void EvalPhi(const ScalarFunctionGradient& fcn, void* params,
+             const Eigen::VectorXd& x0, const Eigen::VectorXd& h, double alpha,
+             Eigen::VectorXd* x, double* f, Eigen::VectorXd* g, double* dphi,
+             int* numFcnEvals) {
+  *x = x0 + alpha * h;
+  fcn(*x, params, f, g);
+  *dphi = h.dot(*g);
+  ++(*numFcnEvals);
+}
+
+// Line search on phi(alpha) = fcn(x0 + alpha*h), a port of
+// 'NLOBox/NLM_LineSearch.m'. The bracket [a,b] starting from [0,1] is first
+// expanded, and then refined by safeguarded quadratic interpolation, to find
+// 'alpha' satisfying the Wolfe conditions
+//   f(x) <= f(x0) + c1 * alpha * h'*g0,     --- (W1)
+//   h'*g(x) >= c2 * h'*g0.                  --- (W2)
+// It stops in a finite number of steps and never increases the function. On
+// return, 'x', 'f' and 'g' are at the accepted step, and 'alpha' is returned.
+double LineSearch(const ScalarFunctionGradient& fcn, void* params,
+                  const Eigen::VectorXd& x0, const Eigen::VectorXd& h,
+                  double f0, const Eigen::VectorXd& g0,
+                  Eigen::VectorXd* x, double* f, Eigen::VectorXd* g,
+                  int* numFcnEvals) {
+  const double c1 = 1e-4;
+  const double c2 = 0.9;
+  const double b_max = 1e2;     // Maximum allowable step size.
+  const int maxIter = 10;       // Maximum number of refinement iterations.
+  const double dphi0 = h.dot(g0);
+  const double c1_dphi0 = c1 * dphi0;
+  const double c2_dphi0 = c2 * dphi0;
+  // The lower end 'a' always satisfies (W1), and its point is kept in case the
+  // refinement fails.
+  double a = 0, fa = f0, dphi_a = dphi0;
+  Eigen::VectorXd x_a = x0, g_a = g0;
+  double b = 1, fb, dphi_b;
+  EvalPhi(fcn, params, x0, h, b, x, &fb, g, &dphi_b, numFcnEvals);
+  // Refine the bracket such that 'b' does not satisfy (W1) or 'b' satisfies
+  // (W2).
+  while (fb <= f0 + b*c1_dphi0 && dphi_b < c2_dphi0 && b < b_max) {
+    a = b;   fa = fb;   dphi_a = dphi_b;
+    x_a.swap(*x);   g_a.swap(*g);
+    b = 2*b;
+    EvalPhi(fcn, params, x0, h, b, x, &fb, g, &dphi_b, numFcnEvals);
+  }
+  // Find 'alpha' in bracket [a,b] that satisfies both (W1) and (W2).
+  double alpha = b, f_alpha = fb, dphi_alpha = dphi_b;
+  for (int iter = 0; iter < maxIter &&
+           (f_alpha > f0 + alpha*c1_dphi0 || dphi_alpha < c2_dphi0); ++iter) {
+    // Minimizer of the quadratic interpolating fa, dphi_a and fb, kept in the
+    // middle 80% of the bracket.
+    double c = (fb - fa - (b-a)*dphi_a) / ((b-a)*(b-a));
+    if (c > 0) {
+      alpha = std::max(0.9*a + 0.1*b,
+                       std::min(0.1*a + 0.9*b, a - dphi_a/2/c));
+    } else {
+      alpha = (a+b) / 2;
+    }
+    EvalPhi(fcn, params, x0, h, alpha, x, &f_alpha, g, &dphi_alpha,
+            numFcnEvals);
+    if (f_alpha <= f0 + alpha*c1_dphi0) {
+      a = alpha;   fa = f_alpha;   dphi_a = dphi_alpha;
+      x_a = *x;    g_a = *g;
+    } else {
+      b = alpha;   fb = f_alpha;   dphi_b = dphi_alpha;
+    }
+  }
+  if (f_alpha > f0 + alpha*c1_dphi0) {
+    // Fall back to the lower end of the bracket.
+    alpha = a;
+    f_alpha = fa;
+    x->swap(x_a);   g->swap(g_a);
+  }
+  *f = f_alpha;
+  return alpha;
+}
+}   // namespace
+
+Eigen::VectorXd NonlinearMinimization(
+    const ScalarFunctionGradient& fcn,
+    void* params,
+    const Eigen::VectorXd& x0,
+    const NLMOpts& opts,
+    NLMResultInfo* result) {
+  NLMResultInfo _result;
+  if (!result) {
+    result = &_result;
+  }
+  // ================================================================
+  // Initialization.
+  // ================================================================
+  int N = x0.size();
+  Eigen::VectorXd x = x0;
+  double f;
+  Eigen::VectorXd g;
+  fcn(x, params, &f, &g);
+  CHECK_EQ(g.size(), N);
+  result->numFcnEvals = 1;
+  if (g.cwiseAbs().maxCoeff() < opts.tolFun) {
+    result->exitflag = 1;
+    result->finalIter = 0;
+    result->f = f;
+    PrintFinalInfo(opts, *result);
+    return x;
+  }
+  const bool lbfgs = (opts.algorithm == NLMOpts::ALGORITHM_LBFGS);
+  if (!lbfgs && opts.algorithm != NLMOpts::ALGORITHM_BFGS) {
+    LOG(FATAL) << "Unknown 'AlgorithmType' option.";
+  }
+  // For L-BFGS, the last 'm' pairs of s = x - x_old and y = g - g_old are kept
+  // in the columns of 'S' and 'Y' as a ring buffer, with rho = 1 / (s'*y). For
+  // BFGS, the inverse Hessian 'Binv' is kept.
+  int m = lbfgs ? opts.lbfgsOpts.memory : 1;
+  CHECK_GT(m, 0);
+  Eigen::MatrixXd S(N, m), Y(N, m);
+  Eigen::VectorXd rho(m), alphas(m);
+  int numPairs = 0, newest = -1;
+  Eigen::MatrixXd Binv;
+  if (!lbfgs) {
+    Binv = Eigen::MatrixXd::Identity(N, N);
+  }
+  Eigen::VectorXd h(N), x_prev(N), g_prev(N), v;
+  PrintIterInfoHeader(opts);
+  PrintIterInfo(opts, 0, f, 0.0);
+  // ================================================================
+  // Main loop.
+  // ================================================================
+  int iter;
+  result->exitflag = 0;
+  for (iter = 0; iter < opts.maxIter; ++iter) {
+    // Compute descent direction 'h'.
+    if (lbfgs) {
+      // Two-loop recursion, h = -H*g with H the L-BFGS inverse Hessian.
+      h = -g;
+      for (int i = 0; i < numPairs; ++i) {
+        int k = (newest - i + m) % m;
+        alphas(k) = rho(k) * S.col(k).dot(h);
+        h -= alphas(k) * Y.col(k);
+      }
+      if (numPairs > 0) {
+        h *= 1.0 / (rho(newest) * Y.col(newest).squaredNorm());
+      }
+      for (int i = numPairs - 1; i >= 0; --i) {
+        int k = (newest - i + m) % m;
+        double beta = rho(k) * Y.col(k).dot(h);
+        h += (alphas(k) - beta) * S.col(k);
+      }
+    } else {
+      h.noalias() = -Binv * g;
+    }
+    if (h.dot(g) >= 0) {
+      // Not a descent direction due to round-off, restart from steepest
+      // descent.
+      h = -g;
+      numPairs = 0;
+      if (!lbfgs)   Binv.setIdentity();
+    }
+    // Perform line search.
+    double f_old = f;
+    x_prev.swap(x);
+    g_prev.swap(g);
+    double alpha = LineSearch(fcn, params, x_prev, h, f_old, g_prev,
+                              &x, &f, &g, &result->numFcnEvals);
+    // Display results.
+    PrintIterInfo(opts, iter+1, f, alpha);
+    // Check stop criterion, with 'x_prev' and 'g_prev' becoming 's' and 'y'.
+    x_prev = x - x_prev;
+    g_prev = g - g_prev;
+    result->exitflag = StopCriterion(x_prev, opts.tolX, f_old, f, opts.tolFun,
+                                     g);
+    if (result->exitflag)   break;
+    // Update the inverse Hessian approximation, skipping pairs with no positive
+    // curvature information.
+    const Eigen::VectorXd& s = x_prev;
+    const Eigen::VectorXd& y = g_prev;
+    double sy = s.dot(y);
+    if (sy <= std::numeric_limits<double>::epsilon() * s.norm() * y.norm()) {
+      continue;
+    }
+    if (lbfgs) {
+      newest = (newest + 1) % m;
+      S.col(newest) = s;
+      Y.col(newest) = y;
+      rho(newest) = 1.0 / sy;
+      numPairs = std::min(numPairs + 1, m);
+    } else {
+      v.noalias() = Binv * y;
+      Binv += (sy + y.dot(v)) / (sy*sy) * s * s.transpose() -
+          (s * v.transpose() + v * s.transpose()) / sy;
+    }
+  }
+  result->finalIter = std::min(iter + 1, opts.maxIter);
+  result->f = f;
+  PrintFinalInfo(opts, *result);
+  return x;
+}
+
+}   // namespace xyUtils
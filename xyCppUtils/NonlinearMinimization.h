@@ -0,0 +1,77 @@
+/**
+  * Nonlinear minimization of smooth scalar functions, a C++ port of
+  * 'NLOBox/NonlinearMinimization.m' (without bound constraints).
+  *
+  * Example usage:
+  *   NLMOpts nlmOpts;
+  *   nlmOpts.lbfgsOpts.memory = 5;
+  *   NLMResultInfo nlmResult;
+  *   x = NonlinearMinimization(MyFcnGrad, &myParams, x0, nlmOpts, &nlmResult);
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#ifndef __XYUTILS_NONLINEAR_MINIMIZATION_H__
+#define __XYUTILS_NONLINEAR_MINIMIZATION_H__
+
+#include <Eigen/Core>
+
+#include "NumericalFunctionTypes.h"
+
+namespace xyUtils  {
+
+struct NLMOpts {
+  enum AlgorithmType { ALGORITHM_LBFGS, ALGORITHM_BFGS };
+  enum DisplayType { DISPLAY_OFF, DISPLAY_FINAL, DISPLAY_FINAL_DETAILED,
+                     DISPLAY_ITER, DISPLAY_ITER_DETAILED };
+  // Options for limited-memory BFGS algorithm.
+  struct LBFGSOpts {
+    // Constructor that sets default values.
+    LBFGSOpts() :
+        memory(10) { }
+
+    // Number of most recent (s, y) pairs kept, i.e. the memory is
+    // O(memory * N).
+    int memory;
+  };
+
+  // Constructor that sets default values.
+  NLMOpts() :
+      algorithm(ALGORITHM_LBFGS), display(DISPLAY_OFF), lbfgsOpts(),
+      tolX(1e-6), tolFun(1e-6), maxIter(400) { }
+
+  // ALGORITHM_BFGS keeps a dense N x N inverse Hessian as 'NLM_BFGS.m', and is
+  // only suitable for small problems.
+  AlgorithmType algorithm;
+  DisplayType display;
+  LBFGSOpts lbfgsOpts;
+  double tolX;
+  double tolFun;
+  int maxIter;
+};
+
+// The 'exitflag' is one of
+//   0: number of iterations exceeded 'maxIter'.
+//   1: magnitude of gradient smaller than 'tolFun'.
+//   2: change in 'x' smaller than 'tolX'.
+//   3: change in 'f' smaller than 'tolFun'.
+struct NLMResultInfo {
+  int exitflag;
+  int finalIter;
+  double f;
+  int numFcnEvals;          // Number of function evaluations.
+};
+
+// Minimize the function 'fcn' starting from 'x0'. Each iteration performs a
+// line search satisfying the Wolfe conditions, as 'NLOBox/NLM_LineSearch.m'.
+Eigen::VectorXd NonlinearMinimization(
+    const ScalarFunctionGradient& fcn,
+    void* params,
+    const Eigen::VectorXd& x0,
+    const NLMOpts& opts,
+    NLMResultInfo* result);
+
+}   // namespace xyUtils
+
+#endif   // __XYUTILS_NONLINEAR_MINIMIZATION_H__
@@ -0,0 +1,103 @@
+/**
+  * Test for nonlinear minimization.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "NonlinearMinimization.h"
+
+#include <Eigen/Core>
+
+#include "LogAndCheck.h"
+#include "NumericalCheck.h"
+#include "Timer.h"
+
+using namespace Eigen;
+using namespace xyUtils;
+
+/**
+ * The extended Rosenbrock function
+ *   f(x) = sum_i 100 * (x(2i+1) - x(2i)^2)^2 + (1 - x(2i))^2,
+ * with minimum 0 at x = ones.
+ */
+static void RosenbrockFcn(const VectorXd& x, const void* params,
+                          double* f, VectorXd* g) {
+  (void) params;
+  int N = x.size();
+  *f = 0;
+  if (g)   g->resize(N);
+  for (int i = 0; i < N; i += 2) {
+    double t1 = x(i+1) - x(i)*x(i);
+    double t2 = 1 - x(i);
+    *f += 100*t1*t1 + t2*t2;
+    if (g) {
+      (*g)(i) = -400*t1*x(i) - 2*t2;
+      (*g)(i+1) = 200*t1;
+    }
+  }
+}
+
+static VectorXd RosenbrockStart(int N) {
+  VectorXd x0(N);
+  for (int i = 0; i < N; i += 2) {
+    x0(i) = -1.2;
+    x0(i+1) = 1.0;
+  }
+  return x0;
+}
+
+int main()  {
+  Timer timer;
+  LOG(INFO) << "Test on NonlinearMinimization ...";
+
+  NLMOpts opts;
+  opts.tolFun = 1e-12;
+  NLMResultInfo result;
+  VectorXd x;
+
+  // Both algorithms on a small problem.
+  int N = 100;
+  opts.algorithm = NLMOpts::ALGORITHM_BFGS;
+  x = NonlinearMinimization(RosenbrockFcn, NULL, RosenbrockStart(N), opts,
+                            &result);
+  CheckNear(x, VectorXd::Ones(N), 1e-3);
+  LOG(INFO) << "BFGS: " << result.finalIter << " iterations, "
+            << result.numFcnEvals << " function evaluations.";
+  opts.algorithm = NLMOpts::ALGORITHM_LBFGS;
+  x = NonlinearMinimization(RosenbrockFcn, NULL, RosenbrockStart(N), opts,
+                            &result);
+  CheckNear(x, VectorXd::Ones(N), 1e-3);
+  LOG(INFO) << "L-BFGS: " << result.finalIter << " iterations, "
+            << result.numFcnEvals << " function evaluations.";
+  CHECK_GT(result.exitflag, 0);
+
+  // Starting at the minimum.
+  x = NonlinearMinimization(RosenbrockFcn, NULL, VectorXd::Ones(N), opts,
+                            &result);
+  CHECK_EQ(result.exitflag, 1);
+  CHECK_EQ(result.finalIter, 0);
+  CHECK_EQ(result.f, 0.0);
+
+  // Maximum number of iterations.
+  opts.maxIter = 3;
+  NonlinearMinimization(RosenbrockFcn, NULL, RosenbrockStart(N), opts,
+                        &result);
+  CHECK_EQ(result.exitflag, 0);
+  CHECK_EQ(result.finalIter, 3);
+  opts.maxIter = NLMOpts().maxIter;
+  opts.tolFun = 1e-9;
+
+  // Large problem with L-BFGS.
+  N = 100000;
+  opts.lbfgsOpts.memory = 5;
+  Timer largeTimer;
+  x = NonlinearMinimization(RosenbrockFcn, NULL, RosenbrockStart(N), opts,
+                            &result);
+  CheckNear(x, VectorXd::Ones(N), 1e-3);
+  LOG(INFO) << "L-BFGS with " << N << " variables: " << result.finalIter
+            << " iterations, " << largeTimer.elapsed() << " seconds.";
+
+  LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
+  return 0;
+}
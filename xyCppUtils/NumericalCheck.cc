@@ -7,20 +7,78 @@
 
 #include "NumericalCheck.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <functional>
 #include <limits>
+#include <sstream>
+#include <vector>
 #include <Eigen/Core>
 
 #include "EigenUtils.h"
 #include "LogAndCheck.h"
 #include "NumericalFunctionTypes.h"
+#include "ThreadPool.h"
 
 namespace xyUtils  {
 
-bool CheckNear(Eigen::MatrixXd m1, Eigen::MatrixXd m2, double tol,
-               bool exit_on_fail) {
-  Eigen::MatrixXd diff = m1 - m2;
-  double errAbs = diff.norm();
+namespace {
+// Shared state for the threads checking the directions. Direction k < N is the
+// k-th coordinate direction, and k >= N the (k-N)-th column of 'randomDirs'.
+struct JacobianCheckWork {
+  VectorFunctionJacobian fcnJac;
+  void* params;
+  const Eigen::VectorXd* x0;
+  const Eigen::VectorXd* f0;
+  const Eigen::MatrixXd* J0;
+  const Eigen::MatrixXd* randomDirs;
+  const JacobianCheckOpts* opts;
+  // Error of each direction.
+  Eigen::VectorXd errors;
+};
+
+// Check the directions in [begin, end).
+void JacobianCheckWorker(JacobianCheckWork* work, int begin, int end) {
+  const Eigen::VectorXd& x0 = *work->x0;
+  const Eigen::VectorXd& f0 = *work->f0;
+  const Eigen::MatrixXd& J0 = *work->J0;
+  const double delta = work->opts->delta;
+  const int N = x0.size();
+  Eigen::VectorXd x = x0;
+  Eigen::VectorXd f, v1, v2;
+  for (int k = begin; k < end; ++k) {
+    if (k < N) {
+      x(k) += delta;
+      v2 = delta * J0.col(k);
+    } else {
+      x.noalias() += delta * work->randomDirs->col(k - N);
+      v2.noalias() = delta * J0 * work->randomDirs->col(k - N);
+    }
+    work->fcnJac(x, work->params, &f, NULL);
+    CHECK_EQ(f.size(), f0.size());
+    v1 = f - f0;
+    double errAbs = (v1 - v2).norm();
+    double errRel = errAbs / std::max(std::max(v1.norm(), v2.norm()),
+                                      std::numeric_limits<double>::epsilon());
+    work->errors(k) = std::min(errAbs / (work->opts->m * delta),
+                               errRel / (work->opts->M * delta));
+    x = x0;
+  }
+}
+
+// Order indices by decreasing 'errors'.
+struct ByDecreasingError {
+  explicit ByDecreasingError(const Eigen::VectorXd& _errors)
+      : errors(_errors) { }
+  bool operator()(int a, int b) const { return errors(a) > errors(b); }
+  const Eigen::VectorXd& errors;
+};
+}   // namespace
+
+bool CheckNear(const Eigen::Ref<const Eigen::MatrixXd>& m1,
+               const Eigen::Ref<const Eigen::MatrixXd>& m2,
+               double tol, bool exit_on_fail) {
+  double errAbs = (m1 - m2).norm();
   double errRel = errAbs / std::max(std::max(m1.norm(), m2.norm()),
                                     std::numeric_limits<double>::epsilon());
   if ((errAbs<=tol) || (errRel<=tol)) {
@@ -36,10 +94,10 @@ bool CheckNear(Eigen::MatrixXd m1, Eigen::MatrixXd m2, double tol,
   }
 }
 
-bool CheckNearAbs(Eigen::MatrixXd m1, Eigen::MatrixXd m2, double tol,
-                  bool exit_on_fail) {
-  Eigen::MatrixXd diff = m1 - m2;
-  double errAbs = diff.norm();
+bool CheckNearAbs(const Eigen::Ref<const Eigen::MatrixXd>& m1,
+                  const Eigen::Ref<const Eigen::MatrixXd>& m2,
+                  double tol, bool exit_on_fail) {
+  double errAbs = (m1 - m2).norm();
   if (errAbs <= tol) {
     return true;
   } else {
@@ -52,10 +110,10 @@ bool CheckNearAbs(Eigen::MatrixXd m1, Eigen::MatrixXd m2, double tol,
   }
 }
 
-bool CheckNearRel(Eigen::MatrixXd m1, Eigen::MatrixXd m2, double tol,
-                  bool exit_on_fail) {
-  Eigen::MatrixXd diff = m1 - m2;
-  double errRel = diff.norm() / std::max(std::max(m1.norm(), m2.norm()),
+bool CheckNearRel(const Eigen::Ref<const Eigen::MatrixXd>& m1,
+                  const Eigen::Ref<const Eigen::MatrixXd>& m2,
+                  double tol, bool exit_on_fail) {
+  double errRel = (m1 - m2).norm() / std::max(std::max(m1.norm(), m2.norm()),
                                          std::numeric_limits<double>::epsilon());
   if (errRel <= tol) {
     return true;
@@ -111,4 +169,75 @@ bool CheckJacobian(const VectorFunctionJacobian& fcnJac, void* params, int N,
   }
 }
 
+bool CheckJacobianColumns(const VectorFunctionJacobian& fcnJac, void* params,
+                          int N, const JacobianCheckOpts& opts,
+                          JacobianCheckReport* report, bool exit_on_fail,
+                          const Eigen::VectorXd* x0) {
+  JacobianCheckReport _report;
+  if (!report)   report = &_report;
+  // Set default 'x0', and the random directions.
+  Eigen::VectorXd default_x0;
+  if (!x0) {
+    default_x0 = EigenUtils::RandnVectorXd(N, rand());
+    x0 = &default_x0;
+  }
+  CHECK_EQ(x0->size(), N);
+  int K = opts.numRandomDirs;
+  Eigen::MatrixXd randomDirs(N, K);
+  for (int k = 0; k < K; ++k) {
+    randomDirs.col(k) = EigenUtils::RandnVectorXd(N, rand());
+    randomDirs.col(k) /= randomDirs.col(k).norm();
+  }
+  // Evaluate the function and Jacobian at 'x0'.
+  Eigen::VectorXd f0;
+  Eigen::MatrixXd J0;
+  fcnJac(*x0, params, &f0, &J0);
+  CHECK_EQ(J0.rows(), f0.size());
+  CHECK_EQ(J0.cols(), N);
+  // Check all the directions on 'numThreads' threads, with the calling thread
+  // being one of them.
+  JacobianCheckWork work;
+  work.fcnJac = fcnJac;
+  work.params = params;
+  work.x0 = x0;
+  work.f0 = &f0;
+  work.J0 = &J0;
+  work.randomDirs = &randomDirs;
+  work.opts = &opts;
+  work.errors.resize(N + K);
+  ParallelForOnThreads(opts.numThreads, 0, N + K, 1,
+                       std::bind(JacobianCheckWorker, &work,
+                                 std::placeholders::_1, std::placeholders::_2));
+  // Fill in the report.
+  report->colErrors = work.errors.head(N);
+  report->randomErrors = work.errors.tail(K);
+  report->numFailedCols = (report->colErrors.array() > 1.0).count();
+  report->numFailedRandomDirs = (report->randomErrors.array() > 1.0).count();
+  std::vector<int> order(N);
+  for (int j = 0; j < N; ++j)   order[j] = j;
+  int numWorst = std::max(0, std::min(opts.numWorstCols, N));
+  std::partial_sort(order.begin(), order.begin() + numWorst, order.end(),
+                    ByDecreasingError(report->colErrors));
+  report->worstCols.assign(order.begin(), order.begin() + numWorst);
+  if (report->numFailedCols == 0 && report->numFailedRandomDirs == 0) {
+    return true;
+  } else {
+    if (exit_on_fail) {
+      std::ostringstream worst;
+      for (int i = 0; i < numWorst; ++i) {
+        worst << "  column " << report->worstCols[i] << ": error "
+              << report->colErrors(report->worstCols[i]) << "\n";
+      }
+      LOG(FATAL) << "CheckJacobianColumns failed:\n"
+                 << report->numFailedCols << " of " << N
+                 << " columns and " << report->numFailedRandomDirs << " of "
+                 << K << " random directions have error > 1, "
+                 << "where the error is min(absolute difference / (m*delta), "
+                 << "relative difference / (M*delta)).\n"
+                 << "Worst columns:\n" << worst.str();
+    }
+    return false;
+  }
+}
+
 }   // namespace xyUtils
@@ -8,6 +8,7 @@
 #ifndef __XYUTILS_NUMERICAL_CHECK_H__
 #define __XYUTILS_NUMERICAL_CHECK_H__
 
+#include <vector>
 #include <Eigen/Core>
 
 #include "NumericalFunctionTypes.h"
@@ -18,17 +19,21 @@ namespace xyUtils  {
 // under tolerance 'tol', in the sense that
 //   (absolute)   || m1 - m2 || <= tol,   ** or **
 //   (relative)   || m1 - m2 || / max( ||m1||, ||m2||, eps ) <= tol,
-// where ||.|| is the Frobenius norm.
-bool CheckNear(Eigen::MatrixXd m1, Eigen::MatrixXd m2, double tol,
-               bool exit_on_fail = true);
+// where ||.|| is the Frobenius norm. Vectors and matrices stored as 'MatrixXd'
+// or 'VectorXd' are not copied.
+bool CheckNear(const Eigen::Ref<const Eigen::MatrixXd>& m1,
+               const Eigen::Ref<const Eigen::MatrixXd>& m2,
+               double tol, bool exit_on_fail = true);
 
 // Same as 'CheckNear' but only check in the "absolute" sense.
-bool CheckNearAbs(Eigen::MatrixXd m1, Eigen::MatrixXd m2, double tol,
-                  bool exit_on_fail = true);
+bool CheckNearAbs(const Eigen::Ref<const Eigen::MatrixXd>& m1,
+                  const Eigen::Ref<const Eigen::MatrixXd>& m2,
+                  double tol, bool exit_on_fail = true);
 
 // Same as 'CheckNear' but only check in the "relative" sense.
-bool CheckNearRel(Eigen::MatrixXd m1, Eigen::MatrixXd m2, double tol,
-                  bool exit_on_fail = true);
+bool CheckNearRel(const Eigen::Ref<const Eigen::MatrixXd>& m1,
+                  const Eigen::Ref<const Eigen::MatrixXd>& m2,
+                  double tol, bool exit_on_fail = true);
 
 // Numerically check the Jacobian matrix calculation of 'fcnJac'. The Jacobian
 // matrix is correct if the following vectors are close
@@ -46,6 +51,54 @@ bool CheckJacobian(const VectorFunctionJacobian& fcnJac,
                    double M = 10.0,
                    const Eigen::VectorXd* x0 = NULL,
                    const Eigen::VectorXd* dx = NULL);
+
+struct JacobianCheckOpts {
+  // Constructor that sets default values.
+  JacobianCheckOpts() :
+      delta(1e-4), m(0.01), M(10.0), numRandomDirs(4), numThreads(1),
+      numWorstCols(5) { }
+
+  // The step size and tolerances, as in 'CheckJacobian'.
+  double delta;
+  double m;
+  double M;
+  // Number of random directions checked besides the N coordinate directions.
+  int numRandomDirs;
+  // Number of threads used to evaluate the function. If larger than 1, the
+  // function must be safe to call concurrently with the same 'params'. Zero
+  // means using the default thread pool (see 'ThreadPool.h').
+  int numThreads;
+  // Number of columns listed in 'JacobianCheckReport::worstCols'.
+  int numWorstCols;
+};
+
+// The error of a direction is
+//   min(absolute difference / (m*delta), relative difference / (M*delta)),
+// with the differences as in 'CheckJacobian', so that it passes if the error is
+// at most 1.
+struct JacobianCheckReport {
+  // Error of each coordinate direction, i.e. of each column of J.
+  Eigen::VectorXd colErrors;
+  // Error of each random direction.
+  Eigen::VectorXd randomErrors;
+  // Indices of the columns with largest errors, in decreasing order of error.
+  std::vector<int> worstCols;
+  int numFailedCols;
+  int numFailedRandomDirs;
+};
+
+// Check the Jacobian matrix of 'fcnJac' at 'x0' as 'CheckJacobian', along all
+// the N coordinate directions and 'opts.numRandomDirs' random unit directions,
+// so that a wrong column (or block of columns) is located in one call. The
+// 'report' could be NULL, and 'x0' is random if NULL. Return true if all the
+// directions pass.
+bool CheckJacobianColumns(const VectorFunctionJacobian& fcnJac,
+                          void* params,
+                          int N,
+                          const JacobianCheckOpts& opts,
+                          JacobianCheckReport* report,
+                          bool exit_on_fail = true,
+                          const Eigen::VectorXd* x0 = NULL);
 }   // namespace xyUtils
 
 #endif   // __XYUTILS_NUMERICAL_CHECK_H__
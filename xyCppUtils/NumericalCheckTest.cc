@@ -40,6 +40,29 @@ void TestFcnWrongJac(const Eigen::VectorXd& x,
   TestFcnJac(x, params, f, J);
   (*f) *= -1.0;
 }
+
+// A chain test function
+//   f_i(x) = x_i^2 * sin(x_{i+1}),   i = 0, ..., N-2,
+// with an optional wrong derivative with respect to x_{wrongCol}.
+void ChainFcnJac(const Eigen::VectorXd& x,
+                 const void* params,
+                 Eigen::VectorXd* f,
+                 Eigen::MatrixXd* J) {
+  int wrongCol = params ? *static_cast<const int*>(params) : -1;
+  int N = x.size();
+  f->resize(N-1);
+  for (int i = 0; i < N-1; ++i) {
+    (*f)(i) = x(i) * x(i) * sin(x(i+1));
+  }
+  if (J) {
+    J->setZero(N-1, N);
+    for (int i = 0; i < N-1; ++i) {
+      (*J)(i,i) = 2 * x(i) * sin(x(i+1));
+      (*J)(i,i+1) = x(i) * x(i) * cos(x(i+1));
+    }
+    if (wrongCol >= 0)   J->col(wrongCol) *= 1.5;
+  }
+}
 } // namespace
 
 int main()  {
@@ -69,10 +92,31 @@ int main()  {
   CHECK(CheckNearRel(v1, v2, 1e-6));
   CHECK(CheckNearRel(v1, v3, 1e-6, false) == false);
 
+  // Test 'CheckNear' on expressions and blocks.
+  CHECK(CheckNear(m1.block(0, 0, 2, 2), m2.leftCols(2), 1e-6));
+  CHECK(CheckNear(m1 * 2, m3, 1e-6));
+
   // Test CheckJacobian.,
   CHECK(CheckJacobian(TestFcnJac, NULL, 2));
   CHECK(CheckJacobian(TestFcnWrongJac, NULL, 2, false, 1e-4, 0.01, 1.0) == false);
 
+  // Test 'CheckJacobianColumns', which locates the wrong column.
+  JacobianCheckOpts checkOpts;
+  checkOpts.numThreads = 3;
+  JacobianCheckReport report;
+  int N = 50;
+  CHECK(CheckJacobianColumns(ChainFcnJac, NULL, N, checkOpts, &report));
+  CHECK_EQ(report.colErrors.size(), N);
+  CHECK_EQ(report.randomErrors.size(), checkOpts.numRandomDirs);
+  CHECK_EQ(report.numFailedCols, 0);
+  int wrongCol = 17;
+  CHECK(CheckJacobianColumns(ChainFcnJac, &wrongCol, N, checkOpts, &report,
+                             false) == false);
+  CHECK_EQ(report.numFailedCols, 1);
+  CHECK_EQ(int(report.worstCols.size()), checkOpts.numWorstCols);
+  CHECK_EQ(report.worstCols[0], wrongCol);
+  CHECK_GT(report.numFailedRandomDirs, 0);
+
   LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
   return 0;
 }
@@ -12,6 +12,11 @@
 
 namespace xyUtils  {
 
+// Compute the function value only.
+typedef void (*VectorFunction)(const Eigen::VectorXd& x,
+                               const void* params,
+                               Eigen::VectorXd* f);
+
 // Compute the function and its Jacobian. Note that the output 'J' matrix could
 // be NULL, in which case the Jacobian is not needed by the user.
 typedef void (*VectorFunctionJacobian)(const Eigen::VectorXd& x,
@@ -19,6 +24,37 @@ typedef void (*VectorFunctionJacobian)(const Eigen::VectorXd& x,
                                        Eigen::VectorXd* f,
                                        Eigen::MatrixXd* J);
 
+// Same as above, but with 'f' and 'J' in single precision.
+typedef void (*VectorFunctionJacobianF)(const Eigen::VectorXd& x,
+                                        const void* params,
+                                        Eigen::VectorXf* f,
+                                        Eigen::MatrixXf* J);
+
+// Compute a scalar function 'f' and its gradient 'g'. Note that 'g' could be
+// NULL, in which case the gradient is not needed by the user.
+typedef void (*ScalarFunctionGradient)(const Eigen::VectorXd& x,
+                                       const void* params,
+                                       double* f,
+                                       Eigen::VectorXd* g);
+
+// Compute the product of the Jacobian J at 'x' with vector 'v', i.e. 'Jv' is
+// J*v if 'transpose' is false, and J'*v otherwise. Used by matrix-free solvers
+// that never form J.
+typedef void (*JacobianProduct)(const Eigen::VectorXd& x,
+                                const void* params,
+                                const Eigen::VectorXd& v,
+                                bool transpose,
+                                Eigen::VectorXd* Jv);
+
+// Compute the diagonal blocks of J'J at 'x', stacked vertically into an
+// N x 'blockSize' matrix 'D', i.e. rows k*blockSize to (k+1)*blockSize-1 of 'D'
+// hold the k-th diagonal block (the last block might be smaller if N is not a
+// multiple of 'blockSize'). With 'blockSize' 1, 'D' is diag(J'J).
+typedef void (*JacobianGramBlocks)(const Eigen::VectorXd& x,
+                                   const void* params,
+                                   int blockSize,
+                                   Eigen::MatrixXd* D);
+
 }   // namespace xyUtils
 
 #endif   // __XYUTILS_NUMERICAL_FUNCTION_TYPES_H__
@@ -0,0 +1,210 @@
+/**
+  * Numerical Jacobian by finite differences.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "NumericalJacobian.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <Eigen/Core>
+
+#include "LogAndCheck.h"
+#include "ThreadPool.h"
+
+namespace xyUtils  {
+
+namespace {
+// Shared state for the threads computing the Jacobian. Each "group" is a set of
+// columns that are perturbed together; without a sparsity pattern every column
+// is its own group.
+struct JacobianWork {
+  VectorFunction fcn;
+  const void* params;
+  const Eigen::VectorXd* x0;
+  const Eigen::VectorXd* f0;
+  const NumericalJacobianOpts* opts;
+  // Columns in each group, empty if dense.
+  std::vector<std::vector<int> > groupCols;
+  // Non-zero rows of each column, empty if dense.
+  std::vector<std::vector<int> > colRows;
+  int numGroups;
+  Eigen::MatrixXd* J;
+};
+
+// Compute the Jacobian columns of groups in [begin, end).
+void JacobianWorker(const JacobianWork* work, int begin, int end) {
+  const Eigen::VectorXd& x0 = *work->x0;
+  const Eigen::VectorXd& f0 = *work->f0;
+  const double dx = work->opts->dx;
+  const bool central =
+      (work->opts->method == NumericalJacobianOpts::METHOD_CENTRAL);
+  const bool dense = work->groupCols.empty();
+  const double denom = central ? 2.0*dx : dx;
+  Eigen::MatrixXd& J = *work->J;
+  Eigen::VectorXd x = x0;
+  Eigen::VectorXd f_plus, f_minus, df;
+  std::vector<int> denseCol(1);
+  for (int g = begin; g < end; ++g) {
+    const std::vector<int>* cols;
+    if (dense) {
+      denseCol[0] = g;
+      cols = &denseCol;
+    } else {
+      cols = &work->groupCols[g];
+    }
+    // Evaluate the function at perturbed point(s).
+    for (size_t k = 0; k < cols->size(); ++k)   x((*cols)[k]) += dx;
+    work->fcn(x, work->params, &f_plus);
+    CHECK_EQ(f_plus.size(), f0.size());
+    if (central) {
+      for (size_t k = 0; k < cols->size(); ++k)   x((*cols)[k]) -= 2.0*dx;
+      work->fcn(x, work->params, &f_minus);
+      CHECK_EQ(f_minus.size(), f0.size());
+      df = f_plus - f_minus;
+    } else {
+      df = f_plus - f0;
+    }
+    for (size_t k = 0; k < cols->size(); ++k)   x((*cols)[k]) = x0((*cols)[k]);
+    // Fill in the columns.
+    if (dense) {
+      J.col(g) = df / denom;
+    } else {
+      for (size_t k = 0; k < cols->size(); ++k) {
+        int j = (*cols)[k];
+        const std::vector<int>& rows = work->colRows[j];
+        for (size_t r = 0; r < rows.size(); ++r) {
+          J(rows[r], j) = df(rows[r]) / denom;
+        }
+      }
+    }
+  }
+}
+
+void NumericalJacobian_Impl(const VectorFunction& fcn,
+                            const void* params,
+                            const Eigen::VectorXd& x0,
+                            const NumericalJacobianOpts& opts,
+                            const std::vector<int>& colors,
+                            int numColors,
+                            Eigen::VectorXd* f0,
+                            Eigen::MatrixXd* J) {
+  Eigen::VectorXd _f0;
+  if (!f0)   f0 = &_f0;
+  fcn(x0, params, f0);
+  if (!J)   return;
+  int N = x0.size();
+  int M = f0->size();
+  CHECK_GT(opts.dx, 0.0);
+  // Setup the work.
+  JacobianWork work;
+  work.fcn = fcn;
+  work.params = params;
+  work.x0 = &x0;
+  work.f0 = f0;
+  work.opts = &opts;
+  work.J = J;
+  if (opts.sparsity.size() > 0) {
+    CHECK_EQ(opts.sparsity.rows(), M);
+    CHECK_EQ(opts.sparsity.cols(), N);
+    CHECK_EQ(int(colors.size()), N);
+    work.numGroups = numColors;
+    work.groupCols.resize(numColors);
+    work.colRows.resize(N);
+    for (int j = 0; j < N; ++j) {
+      work.groupCols[colors[j]].push_back(j);
+      for (int i = 0; i < M; ++i) {
+        if (opts.sparsity(i,j))   work.colRows[j].push_back(i);
+      }
+    }
+    J->setZero(M, N);
+  } else {
+    work.numGroups = N;
+    J->resize(M, N);
+  }
+  // Run the work on 'numThreads' threads, with the calling thread being one of
+  // them.
+  ParallelForOnThreads(opts.numThreads, 0, work.numGroups, 1,
+                       std::bind(JacobianWorker, &work, std::placeholders::_1,
+                                 std::placeholders::_2));
+}
+}   // namespace
+
+int ColorJacobianColumns(const JacobianSparsity& sparsity,
+                         std::vector<int>* colors) {
+  int M = sparsity.rows();
+  int N = sparsity.cols();
+  std::vector<std::vector<int> > colRows(N), rowCols(M);
+  for (int j = 0; j < N; ++j) {
+    for (int i = 0; i < M; ++i) {
+      if (sparsity(i,j)) {
+        colRows[j].push_back(i);
+        rowCols[i].push_back(j);
+      }
+    }
+  }
+  // Visit the columns with more non-zeros first.
+  std::vector<std::pair<int,int> > order(N);
+  for (int j = 0; j < N; ++j) {
+    order[j] = std::make_pair(-int(colRows[j].size()), j);
+  }
+  std::sort(order.begin(), order.end());
+  // Greedy coloring: give each column the smallest color not used by any column
+  // sharing a row with it. 'forbidden[c] == j' means color 'c' is taken by a
+  // neighbor of column 'j'.
+  colors->assign(N, -1);
+  std::vector<int> forbidden(N, -1);
+  int numColors = 0;
+  for (int k = 0; k < N; ++k) {
+    int j = order[k].second;
+    for (size_t r = 0; r < colRows[j].size(); ++r) {
+      const std::vector<int>& cols = rowCols[colRows[j][r]];
+      for (size_t c = 0; c < cols.size(); ++c) {
+        if ((*colors)[cols[c]] >= 0)   forbidden[(*colors)[cols[c]]] = j;
+      }
+    }
+    int color = 0;
+    while (color < numColors && forbidden[color] == j)   ++color;
+    (*colors)[j] = color;
+    if (color == numColors)   ++numColors;
+  }
+  return numColors;
+}
+
+void NumericalJacobian(const VectorFunction& fcn,
+                       const void* params,
+                       const Eigen::VectorXd& x0,
+                       const NumericalJacobianOpts& opts,
+                       Eigen::VectorXd* f0,
+                       Eigen::MatrixXd* J) {
+  std::vector<int> colors;
+  int numColors = 0;
+  if (J && opts.sparsity.size() > 0) {
+    numColors = ColorJacobianColumns(opts.sparsity, &colors);
+  }
+  NumericalJacobian_Impl(fcn, params, x0, opts, colors, numColors, f0, J);
+}
+
+NumericalJacobianParams::NumericalJacobianParams(
+    VectorFunction _fcn, const void* _params,
+    const NumericalJacobianOpts& _opts)
+    : fcn(_fcn), params(_params), opts(_opts), colors(), numColors(0) {
+  if (opts.sparsity.size() > 0) {
+    numColors = ColorJacobianColumns(opts.sparsity, &colors);
+  }
+}
+
+void NumericalJacobianFcnJac(const Eigen::VectorXd& x,
+                             const void* params,
+                             Eigen::VectorXd* f,
+                             Eigen::MatrixXd* J) {
+  const NumericalJacobianParams* njParams =
+      static_cast<const NumericalJacobianParams*>(params);
+  NumericalJacobian_Impl(njParams->fcn, njParams->params, x, njParams->opts,
+                         njParams->colors, njParams->numColors, f, J);
+}
+
+}   // namespace xyUtils
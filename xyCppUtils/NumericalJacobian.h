@@ -0,0 +1,91 @@
+/**
+  * Numerical Jacobian by finite differences.
+  *
+  * Example usage, as a drop-in 'VectorFunctionJacobian':
+  *   NumericalJacobianOpts njOpts;
+  *   njOpts.method = NumericalJacobianOpts::METHOD_CENTRAL;
+  *   njOpts.numThreads = 4;
+  *   NumericalJacobianParams njParams(MyFcn, &myParams, njOpts);
+  *   x = NonlinearLeastSquares(NumericalJacobianFcnJac, &njParams, x0,
+  *                             nllsOpts, &nllsResult);
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#ifndef __XYUTILS_NUMERICAL_JACOBIAN_H__
+#define __XYUTILS_NUMERICAL_JACOBIAN_H__
+
+#include <vector>
+#include <Eigen/Core>
+
+#include "NumericalFunctionTypes.h"
+
+namespace xyUtils  {
+
+// A boolean M x N matrix, where entry (i,j) is true if f_i(x) might depend on
+// x_j, i.e. J(i,j) is structurally non-zero.
+typedef Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> JacobianSparsity;
+
+struct NumericalJacobianOpts {
+  enum MethodType { METHOD_FORWARD, METHOD_CENTRAL };
+  // Constructor that sets default values.
+  NumericalJacobianOpts() :
+      method(METHOD_FORWARD), dx(1e-6), numThreads(1), sparsity() { }
+
+  // Forward difference computes the Jacobian as (f(x0+dx) - f(x0)) / dx, and
+  // central difference computes it as (f(x0+dx) - f(x0-dx)) / (2*dx).
+  MethodType method;
+  // The small change in 'x0'.
+  double dx;
+  // Number of threads used to evaluate the function. If larger than 1, the
+  // function must be safe to call concurrently with the same 'params'. Zero
+  // means using the default thread pool (see 'ThreadPool.h').
+  int numThreads;
+  // Optional sparsity pattern of the Jacobian. If non-empty, structurally
+  // independent columns (no two of them have a non-zero in the same row) are
+  // perturbed together and share one function evaluation, and entries outside
+  // the pattern are set to zero.
+  JacobianSparsity sparsity;
+};
+
+// Partition the columns of a Jacobian with 'sparsity' pattern into groups such
+// that no two columns in the same group have a non-zero in the same row (a
+// greedy coloring of the column intersection graph, largest degree first). On
+// return, 'colors' has one entry per column in [0, numColors), and the number
+// of colors is returned.
+int ColorJacobianColumns(const JacobianSparsity& sparsity,
+                         std::vector<int>* colors);
+
+// Compute the numerical Jacobian 'J' of function 'fcn' at point 'x0', and the
+// function value 'f0' at 'x0'. Either 'f0' or 'J' could be NULL if not needed.
+void NumericalJacobian(const VectorFunction& fcn,
+                       const void* params,
+                       const Eigen::VectorXd& x0,
+                       const NumericalJacobianOpts& opts,
+                       Eigen::VectorXd* f0,
+                       Eigen::MatrixXd* J);
+
+// Parameters for 'NumericalJacobianFcnJac'. The column coloring of
+// 'opts.sparsity' is computed once in the constructor.
+struct NumericalJacobianParams {
+  NumericalJacobianParams(VectorFunction _fcn, const void* _params,
+                          const NumericalJacobianOpts& _opts);
+
+  VectorFunction fcn;
+  const void* params;
+  NumericalJacobianOpts opts;
+  std::vector<int> colors;
+  int numColors;
+};
+
+// A 'VectorFunctionJacobian' that evaluates 'fcn' and computes its Jacobian
+// numerically, where 'params' should point to a 'NumericalJacobianParams'.
+void NumericalJacobianFcnJac(const Eigen::VectorXd& x,
+                             const void* params,
+                             Eigen::VectorXd* f,
+                             Eigen::MatrixXd* J);
+
+}   // namespace xyUtils
+
+#endif   // __XYUTILS_NUMERICAL_JACOBIAN_H__
@@ -0,0 +1,136 @@
+/**
+  * Test for numerical Jacobian.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "NumericalJacobian.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "EigenUtils.h"
+#include "LogAndCheck.h"
+#include "NumericalCheck.h"
+#include "Timer.h"
+
+using namespace Eigen;
+using namespace xyUtils;
+
+namespace {
+// Number of function evaluations.
+std::atomic<int> nEvals(0);
+
+// A test function
+//   f(x) = [sin(y); cos(y); exp(-y^2); log(y)],   y = sum(x.^2).
+void TestFcn(const VectorXd& x, const void* params, VectorXd* f) {
+  (void) params;
+  ++nEvals;
+  double y = x.squaredNorm();
+  *f = Vector4d(sin(y), cos(y), exp(-y*y), log(y));
+}
+
+void TestFcnJac(const VectorXd& x, const void* params,
+                VectorXd* f, MatrixXd* J) {
+  TestFcn(x, params, f);
+  if (J) {
+    double y = x.squaredNorm();
+    Vector4d Jy(cos(y), -sin(y), -2*y*exp(-y*y), 1/y);
+    *J = Jy * 2 * x.transpose();
+  }
+}
+
+// A banded test function
+//   f_i(x) = x_{i-1} * x_i^2 + sin(x_{i+1}),
+// with out-of-range terms dropped.
+void BandedFcn(const VectorXd& x, const void* params, VectorXd* f) {
+  (void) params;
+  ++nEvals;
+  int N = x.size();
+  f->resize(N);
+  for (int i = 0; i < N; ++i) {
+    (*f)(i) = (i > 0 ? x(i-1) : 1.0) * x(i) * x(i) +
+        (i < N-1 ? sin(x(i+1)) : 0.0);
+  }
+}
+
+void BandedFcnJac(const VectorXd& x, const void* params,
+                  VectorXd* f, MatrixXd* J) {
+  BandedFcn(x, params, f);
+  if (J) {
+    int N = x.size();
+    J->setZero(N, N);
+    for (int i = 0; i < N; ++i) {
+      if (i > 0)     (*J)(i, i-1) = x(i) * x(i);
+      (*J)(i, i) = 2 * (i > 0 ? x(i-1) : 1.0) * x(i);
+      if (i < N-1)   (*J)(i, i+1) = cos(x(i+1));
+    }
+  }
+}
+}   // namespace
+
+int main()  {
+  Timer timer;
+  LOG(INFO) << "Test on NumericalJacobian ...";
+
+  // Compare between analytical and numerical Jacobian matrix.
+  VectorXd x0 = EigenUtils::RandnVectorXd(5, rand());
+  VectorXd af0, nf0;
+  MatrixXd aJ, nJ;
+  TestFcnJac(x0, NULL, &af0, &aJ);
+  NumericalJacobianOpts opts;
+  opts.dx = 1e-4;
+  // Forward difference.
+  NumericalJacobian(TestFcn, NULL, x0, opts, &nf0, &nJ);
+  CheckNear(af0, nf0, 1e-12);
+  CheckNear(aJ, nJ, 1e-3);
+  // Central difference (higher accuracy).
+  opts.method = NumericalJacobianOpts::METHOD_CENTRAL;
+  NumericalJacobian(TestFcn, NULL, x0, opts, &nf0, &nJ);
+  CheckNear(af0, nf0, 1e-12);
+  CheckNear(aJ, nJ, 1e-6);
+  // Multi-threaded evaluation should give the same result.
+  MatrixXd nJ2;
+  opts.numThreads = 3;
+  NumericalJacobian(TestFcn, NULL, x0, opts, NULL, &nJ2);
+  CHECK_EQ((nJ - nJ2).cwiseAbs().maxCoeff(), 0.0);
+
+  // Column coloring of a tridiagonal pattern needs 3 colors.
+  int N = 100;
+  JacobianSparsity sparsity = JacobianSparsity::Constant(N, N, false);
+  for (int i = 0; i < N; ++i) {
+    for (int j = std::max(0, i-1); j <= std::min(N-1, i+1); ++j) {
+      sparsity(i,j) = true;
+    }
+  }
+  std::vector<int> colors;
+  CHECK_EQ(ColorJacobianColumns(sparsity, &colors), 3);
+  for (int i = 0; i < N; ++i) {
+    for (int j = 0; j < N; ++j) {
+      for (int k = j+1; k < N; ++k) {
+        CHECK(!(sparsity(i,j) && sparsity(i,k) && colors[j] == colors[k]));
+      }
+    }
+  }
+
+  // Sparse Jacobian with compressed evaluation.
+  x0 = EigenUtils::RandnVectorXd(N, rand());
+  BandedFcnJac(x0, NULL, &af0, &aJ);
+  opts.sparsity = sparsity;
+  opts.numThreads = 2;
+  NumericalJacobianParams njParams(BandedFcn, NULL, opts);
+  CHECK_EQ(njParams.numColors, 3);
+  nEvals = 0;
+  NumericalJacobianFcnJac(x0, &njParams, &nf0, &nJ);
+  CHECK_EQ(int(nEvals), 1 + 2*3);
+  CheckNear(af0, nf0, 1e-12);
+  CheckNear(aJ, nJ, 1e-6);
+  // The drop-in function passes the Jacobian check.
+  CHECK(CheckJacobian(NumericalJacobianFcnJac, &njParams, N));
+
+  LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
+  return 0;
+}
@@ -25,6 +25,10 @@
 #include "LogAndCheck.h"
 
 namespace xyUtils  {
+namespace StringUtils {
+class Tokenizer;
+}   // namespace StringUtils
+
 class PlyIO {
  public:
   // ================================================================
@@ -73,8 +77,8 @@ class PlyIO {
     Element(const char* _name, int _size) : name(_name), size(_size) { }
     // Add a property to the list.
     void AddProperty(const char* name, const char* type);
-    // Read property data from the file 'fp'.
-    void ReadPropertiesFromFile(FILE* fp);
+    // Read property data from the white space separated 'tokens'.
+    void ReadProperties(StringUtils::Tokenizer* tokens);
     // Get property index by name, return -1 if no such property exists.
     int GetPropertyIdByName(const char* propName) const;
     // Clear the substantial data and therefore release memory. The header
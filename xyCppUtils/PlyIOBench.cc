@@ -0,0 +1,66 @@
+/**
+  * Benchmarks for PlyIO.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "PlyIO.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CommandLineFlags.h"
+#include "FileIO.h"
+#include "LogAndCheck.h"
+
+using namespace std;
+using namespace xyUtils;
+
+int main(int argc, char** argv)  {
+  CommandLineFlagsInit(&argc, &argv, true);
+  BenchmarkSuite suite("PlyIO");
+
+  // Parsing the test data.
+  const char* dinoFile = "TestData/Models/dinoSparseRing-pmvs.ply";
+  double dinoBytes = FileIO::ReadWholeFileToString(dinoFile).size();
+  int numVertices = 0;
+  if (suite.Run("ReadFile/dino", [&]() {
+        PlyIO ply;
+        ply.ReadFile(dinoFile);
+        numVertices = ply.GetElementNum("vertex");
+      }, dinoBytes, 23928)) {
+    CHECK_EQ(numVertices, 23928);
+  }
+
+  // Generated large point cloud.
+  const int N = 500000;
+  const char* largeFile = "/tmp/xyUtils_PlyIOBench_large.ply";
+  FILE* fp = fopen(largeFile, "w");
+  CHECK(fp);
+  fprintf(fp, "ply\nformat ascii 1.0\nelement vertex %d\n"
+          "property float x\nproperty float y\nproperty float z\n"
+          "property uchar diffuse_red\nproperty uchar diffuse_green\n"
+          "property uchar diffuse_blue\nend_header\n", N);
+  for (int i = 0; i < N; ++i) {
+    fprintf(fp, "%g %g %g %d %d %d\n", i * 1e-3, -i * 2e-3, i * 3e-3,
+            i % 256, (i / 256) % 256, (i * 7) % 256);
+  }
+  fclose(fp);
+  double largeBytes = FileIO::ReadWholeFileToString(largeFile).size();
+  vector<float> xyz(3 * N);
+  if (suite.Run("ReadFile/500k", [&]() {
+        PlyIO ply;
+        ply.ReadFile(largeFile);
+        ply.FillArrayByProperty("vertex", "x", &xyz[0], 3);
+        ply.FillArrayByProperty("vertex", "y", &xyz[1], 3);
+        ply.FillArrayByProperty("vertex", "z", &xyz[2], 3);
+      }, largeBytes, N)) {
+    CHECK_EQ(xyz[3*(N-1)], float((N-1) * 1e-3));
+  }
+  remove(largeFile);
+
+  suite.Finish();
+  return 0;
+}
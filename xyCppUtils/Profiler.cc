@@ -0,0 +1,291 @@
+/**
+  * Scoped profiling on a monotonic clock, with hierarchical statistics and
+  * Chrome trace output.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LogAndCheck.h"
+#include "StringUtils.h"
+
+namespace xyUtils  {
+
+namespace {
+struct Event {
+  const char* name;
+  int64_t start;
+  int64_t end;
+  int depth;
+};
+
+// Events of one thread, kept in fixed size chunks so that they never move. Only
+// the owner thread writes, and the readers see the first 'count' events.
+const int64_t kChunkSize = 4096;
+const int64_t kMaxChunks = 4096;
+struct ThreadBuffer {
+  explicit ThreadBuffer(int _tid) : tid(_tid), count(0), dropped(0) {
+    std::fill(chunks, chunks + kMaxChunks, static_cast<Event*>(NULL));
+  }
+  void Push(const Event& event) {
+    int64_t n = count.load(std::memory_order_relaxed);
+    if (n >= kChunkSize * kMaxChunks) {
+      ++dropped;
+      return;
+    }
+    Event*& chunk = chunks[n / kChunkSize];
+    if (!chunk)   chunk = new Event[kChunkSize];
+    chunk[n % kChunkSize] = event;
+    count.store(n + 1, std::memory_order_release);
+  }
+  const Event& operator[](int64_t i) const {
+    return chunks[i / kChunkSize][i % kChunkSize];
+  }
+
+  int tid;
+  Event* chunks[kMaxChunks];
+  std::atomic<int64_t> count;
+  std::atomic<int64_t> dropped;
+};
+
+// All the thread buffers ever created. They are never freed, so that the events
+// of finished threads are still reported.
+std::mutex& BuffersMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+std::vector<ThreadBuffer*>& Buffers() {
+  static std::vector<ThreadBuffer*> buffers;
+  return buffers;
+}
+
+std::atomic<bool> profilerEnabled(true);
+thread_local ThreadBuffer* threadBuffer = NULL;
+thread_local int threadDepth = 0;
+
+ThreadBuffer* GetThreadBuffer() {
+  if (!threadBuffer) {
+    std::lock_guard<std::mutex> lock(BuffersMutex());
+    threadBuffer = new ThreadBuffer(Buffers().size());
+    Buffers().push_back(threadBuffer);
+  }
+  return threadBuffer;
+}
+
+// A snapshot of the buffers.
+std::vector<ThreadBuffer*> GetBuffers() {
+  std::lock_guard<std::mutex> lock(BuffersMutex());
+  return Buffers();
+}
+
+// Order events by start time, and the enclosing one first if equal.
+bool EventBefore(const Event& a, const Event& b) {
+  return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+}
+
+// A node of the scope hierarchy, merged over all the threads.
+struct StatsNode {
+  std::string name;
+  std::vector<int64_t> durations;
+  std::map<std::string, int> children;
+};
+
+// Merge the events of all threads into the hierarchy 'nodes', with the root at
+// index 0.
+void BuildStatsTree(std::vector<StatsNode>* nodes) {
+  nodes->assign(1, StatsNode());
+  std::vector<ThreadBuffer*> buffers = GetBuffers();
+  std::vector<Event> events;
+  std::vector<std::pair<int, int> > stack;    // (depth, node) of open scopes.
+  for (size_t b = 0; b < buffers.size(); ++b) {
+    int64_t n = buffers[b]->count.load(std::memory_order_acquire);
+    events.resize(n);
+    for (int64_t i = 0; i < n; ++i)   events[i] = (*buffers[b])[i];
+    std::sort(events.begin(), events.end(), EventBefore);
+    stack.clear();
+    for (int64_t i = 0; i < n; ++i) {
+      const Event& e = events[i];
+      while (!stack.empty() && stack.back().first >= e.depth) {
+        stack.pop_back();
+      }
+      int parent = stack.empty() ? 0 : stack.back().second;
+      std::map<std::string, int>::iterator it =
+          (*nodes)[parent].children.find(e.name);
+      int node;
+      if (it == (*nodes)[parent].children.end()) {
+        node = nodes->size();
+        (*nodes)[parent].children[e.name] = node;
+        nodes->push_back(StatsNode());
+        nodes->back().name = e.name;
+      } else {
+        node = it->second;
+      }
+      (*nodes)[node].durations.push_back(e.end - e.start);
+      stack.push_back(std::make_pair(e.depth, node));
+    }
+  }
+}
+
+// Percentile 'p' of sorted 'durations' (nearest rank), in seconds.
+double Percentile(const std::vector<int64_t>& durations, double p) {
+  int64_t n = durations.size();
+  int64_t k = std::min(n - 1, std::max(int64_t(0), int64_t(p * n + 0.5) - 1));
+  return durations[k] * 1e-9;
+}
+
+void CollectStats(std::vector<StatsNode>* nodes, int node,
+                  const std::string& path, int depth,
+                  std::vector<ProfileStats>* stats) {
+  std::map<std::string, int>& children = (*nodes)[node].children;
+  for (std::map<std::string, int>::iterator it = children.begin();
+       it != children.end(); ++it) {
+    StatsNode& child = (*nodes)[it->second];
+    std::vector<int64_t>& d = child.durations;
+    std::sort(d.begin(), d.end());
+    ProfileStats s;
+    s.path = path.empty() ? child.name : path + "/" + child.name;
+    s.name = child.name;
+    s.depth = depth;
+    s.count = d.size();
+    int64_t total = 0;
+    for (size_t i = 0; i < d.size(); ++i)   total += d[i];
+    s.total = total * 1e-9;
+    s.min = d.front() * 1e-9;
+    s.max = d.back() * 1e-9;
+    s.p50 = Percentile(d, 0.5);
+    s.p99 = Percentile(d, 0.99);
+    stats->push_back(s);
+    CollectStats(nodes, it->second, s.path, depth + 1, stats);
+  }
+}
+}   // namespace
+
+int64_t ProfilerNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ProfileScope::ProfileScope(const char* name) {
+  if (!profilerEnabled.load(std::memory_order_relaxed)) {
+    name_ = NULL;
+    return;
+  }
+  name_ = name;
+  depth_ = threadDepth++;
+  start_ = ProfilerNow();
+}
+
+ProfileScope::~ProfileScope() {
+  if (!name_)   return;
+  Event event = {name_, start_, ProfilerNow(), depth_};
+  --threadDepth;
+  GetThreadBuffer()->Push(event);
+}
+
+void ProfilerEnable(bool enable) {
+  profilerEnabled = enable;
+}
+
+bool ProfilerEnabled() {
+  return profilerEnabled;
+}
+
+void ProfilerClear() {
+  std::vector<ThreadBuffer*> buffers = GetBuffers();
+  for (size_t b = 0; b < buffers.size(); ++b) {
+    buffers[b]->count = 0;
+    buffers[b]->dropped = 0;
+  }
+}
+
+int64_t ProfilerNumEvents(int64_t* numDropped) {
+  std::vector<ThreadBuffer*> buffers = GetBuffers();
+  int64_t num = 0, dropped = 0;
+  for (size_t b = 0; b < buffers.size(); ++b) {
+    num += buffers[b]->count;
+    dropped += buffers[b]->dropped;
+  }
+  if (numDropped)   *numDropped = dropped;
+  return num;
+}
+
+void ProfilerGetStats(std::vector<ProfileStats>* stats) {
+  std::vector<StatsNode> nodes;
+  BuildStatsTree(&nodes);
+  stats->clear();
+  CollectStats(&nodes, 0, "", 0, stats);
+}
+
+void ProfilerPrintReport() {
+  std::vector<ProfileStats> stats;
+  ProfilerGetStats(&stats);
+  // Format in a separate stream to keep the flags of the log stream.
+  std::ostringstream report;
+  report << std::left << std::setw(32) << "Scope" << std::right
+         << std::setw(10) << "Count" << std::setw(12) << "Total (ms)"
+         << std::setw(11) << "Min (ms)" << std::setw(11) << "P50 (ms)"
+         << std::setw(11) << "P99 (ms)" << std::setw(11) << "Max (ms)" << "\n";
+  report << std::fixed << std::setprecision(3);
+  for (size_t i = 0; i < stats.size(); ++i) {
+    const ProfileStats& s = stats[i];
+    report << std::left << std::setw(32)
+           << std::string(2 * s.depth, ' ') + s.name << std::right
+           << std::setw(10) << s.count << std::setw(12) << s.total * 1e3
+           << std::setw(11) << s.min * 1e3 << std::setw(11) << s.p50 * 1e3
+           << std::setw(11) << s.p99 * 1e3 << std::setw(11) << s.max * 1e3
+           << "\n";
+  }
+  LOG(PLAIN) << report.str();
+}
+
+void ProfilerWriteChromeTrace(const char* filename) {
+  FILE* fp = fopen(filename, "w");
+  if (!fp) {
+    LOG(FATAL) << "Cannot open file \"" << filename << "\" for writing.";
+  }
+  std::vector<ThreadBuffer*> buffers = GetBuffers();
+  // Times are written in microseconds since the first event.
+  int64_t t0 = 0;
+  bool first = true;
+  for (size_t b = 0; b < buffers.size(); ++b) {
+    int64_t n = buffers[b]->count.load(std::memory_order_acquire);
+    for (int64_t i = 0; i < n; ++i) {
+      if (first || (*buffers[b])[i].start < t0) {
+        t0 = (*buffers[b])[i].start;
+        first = false;
+      }
+    }
+  }
+  fprintf(fp, "{\"traceEvents\":[");
+  first = true;
+  for (size_t b = 0; b < buffers.size(); ++b) {
+    int64_t n = buffers[b]->count.load(std::memory_order_acquire);
+    for (int64_t i = 0; i < n; ++i) {
+      const Event& e = (*buffers[b])[i];
+      fprintf(fp, "%s\n{\"name\":", first ? "" : ",");
+      fputs(StringUtils::JsonQuote(e.name).c_str(), fp);
+      fprintf(fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+              "\"dur\":%.3f}", buffers[b]->tid, (e.start - t0) * 1e-3,
+              (e.end - e.start) * 1e-3);
+      first = false;
+    }
+  }
+  fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  fclose(fp);
+}
+
+}   // namespace xyUtils
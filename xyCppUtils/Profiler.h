@@ -0,0 +1,109 @@
+/**
+  * Scoped profiling on a monotonic clock, with hierarchical statistics and
+  * Chrome trace output.
+  *
+  * The PROFILE_SCOPE macro is only active when compiled with '-D__PROFILE__'
+  * (e.g. 'make PROFILE=1'), and expands to nothing otherwise. Example usage:
+  *
+  *   void Solve() {
+  *     PROFILE_SCOPE("Solve");
+  *     for (...) {
+  *       PROFILE_SCOPE("Iteration");   // Reported as "Solve/Iteration".
+  *       ...
+  *     }
+  *   }
+  *   int main() {
+  *     Solve();
+  *     xyUtils::ProfilerPrintReport();
+  *     xyUtils::ProfilerWriteChromeTrace("trace.json");   // For chrome://tracing.
+  *   }
+  *
+  * Each thread records its scopes into its own buffer without any locking. The
+  * report functions read the events recorded so far, and should be called when
+  * no other thread is inside a profiled scope. The names must be string
+  * literals (or otherwise live until the report).
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#ifndef __XYUTILS_PROFILER_H__
+#define __XYUTILS_PROFILER_H__
+
+#include <string>
+#include <vector>
+
+#ifdef __USE_TR1__
+#include <tr1/cstdint>
+#else
+#include <cstdint>
+#endif
+
+#ifdef __PROFILE__
+#define PROFILE_SCOPE(name)                                               \
+  xyUtils::ProfileScope __PROFILE_CONCAT__(__profile_scope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
+
+#define __PROFILE_CONCAT__(a, b) __PROFILE_CONCAT_IMPL__(a, b)
+#define __PROFILE_CONCAT_IMPL__(a, b) a##b
+
+namespace xyUtils  {
+
+// Nanoseconds on a monotonic clock, since an unspecified starting point.
+int64_t ProfilerNow();
+
+// Record the time between construction and destruction as an event 'name',
+// nested in the enclosing scope of the same thread. Usually used through the
+// PROFILE_SCOPE macro.
+class ProfileScope {
+ public:
+  explicit ProfileScope(const char* name);
+  ~ProfileScope();
+ private:
+  const char* name_;
+  int64_t start_;
+  int depth_;
+};
+
+// Statistics of all the events with the same 'path', i.e. the names of the
+// enclosing scopes and the scope itself joined by '/'. Times are in seconds.
+struct ProfileStats {
+  std::string path;
+  std::string name;
+  int depth;          // Number of enclosing scopes.
+  int64_t count;
+  double total;
+  double min;
+  double max;
+  double p50;
+  double p99;
+};
+
+// Turn the recording on or off at run time (on by default). A disabled scope
+// costs one branch.
+void ProfilerEnable(bool enable);
+bool ProfilerEnabled();
+
+// Discard all the recorded events.
+void ProfilerClear();
+
+// Number of events recorded by all the threads. Events beyond the capacity of a
+// thread buffer (16M per thread) are dropped and counted in 'numDropped'.
+int64_t ProfilerNumEvents(int64_t* numDropped = NULL);
+
+// Aggregate the events of all the threads into 'stats', in depth-first order of
+// the scope hierarchy (children sorted by name).
+void ProfilerGetStats(std::vector<ProfileStats>* stats);
+
+// Print the statistics as an indented table.
+void ProfilerPrintReport();
+
+// Write all the events in the Chrome trace event format (JSON), which can be
+// viewed in chrome://tracing or https://ui.perfetto.dev.
+void ProfilerWriteChromeTrace(const char* filename);
+
+}   // namespace xyUtils
+
+#endif   // __XYUTILS_PROFILER_H__
@@ -0,0 +1,128 @@
+/**
+  * Test for profiler.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+// Enable PROFILE_SCOPE in this file regardless of the build flags.
+#ifndef __PROFILE__
+#define __PROFILE__
+#endif
+
+#include "Profiler.h"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "FileIO.h"
+#include "LogAndCheck.h"
+#include "StringUtils.h"
+#include "Timer.h"
+
+using namespace std;
+using namespace xyUtils;
+
+namespace {
+void Inner() {
+  PROFILE_SCOPE("Inner");
+  Timer::sleep(0.001);
+}
+
+void Outer(int numInner) {
+  PROFILE_SCOPE("Outer");
+  for (int i = 0; i < numInner; ++i)   Inner();
+}
+
+const ProfileStats* FindStats(const vector<ProfileStats>& stats,
+                              const char* path) {
+  for (size_t i = 0; i < stats.size(); ++i) {
+    if (stats[i].path == path)   return &stats[i];
+  }
+  return NULL;
+}
+}   // namespace
+
+int main()  {
+  Timer timer;
+  LOG(INFO) << "Test on Profiler ...";
+
+  // The clock is monotonic with sub-microsecond resolution.
+  int64_t t0 = ProfilerNow();
+  int64_t t1 = ProfilerNow();
+  CHECK_LE(t0, t1);
+  Timer::sleep(0.001);
+  CHECK_GE(ProfilerNow() - t1, 1000000);
+
+  // Nested scopes on several threads, aggregated by path.
+  ProfilerClear();
+  Outer(3);
+  vector<thread> threads;
+  for (int t = 0; t < 3; ++t)   threads.push_back(thread(Outer, 2));
+  for (int t = 0; t < 3; ++t)   threads[t].join();
+  Inner();
+  CHECK_EQ(ProfilerNumEvents(), 4 + 3*3 + 1);
+  vector<ProfileStats> stats;
+  ProfilerGetStats(&stats);
+  CHECK_EQ(int(stats.size()), 3);
+  CHECK_EQ(stats[0].path, "Inner");
+  CHECK_EQ(stats[1].path, "Outer");
+  CHECK_EQ(stats[2].path, "Outer/Inner");
+  const ProfileStats* outer = FindStats(stats, "Outer");
+  const ProfileStats* outerInner = FindStats(stats, "Outer/Inner");
+  CHECK(outer && outerInner);
+  CHECK_EQ(outer->count, 4);
+  CHECK_EQ(outer->depth, 0);
+  CHECK_EQ(outerInner->count, 3 + 3*2);
+  CHECK_EQ(outerInner->depth, 1);
+  CHECK_EQ(outerInner->name, "Inner");
+  CHECK_GE(outerInner->min, 0.001);
+  CHECK_LE(outerInner->min, outerInner->p50);
+  CHECK_LE(outerInner->p50, outerInner->p99);
+  CHECK_LE(outerInner->p99, outerInner->max);
+  CHECK_LE(outerInner->max, outerInner->total);
+  CHECK_GE(outer->total, outerInner->total);
+  ProfilerPrintReport();
+
+  // Chrome trace output, to a file of this process only.
+  string traceFile = StringUtils::PrintfToString(
+      "/tmp/xyUtils_ProfilerTest_trace_%d.json", int(getpid()));
+  ProfilerWriteChromeTrace(traceFile.c_str());
+  string trace = FileIO::ReadWholeFileToString(traceFile.c_str());
+  remove(traceFile.c_str());
+  CHECK_EQ(trace.find("{\"traceEvents\":["), 0u);
+  CHECK(trace.find("\"name\":\"Outer\",\"ph\":\"X\"") != string::npos);
+  size_t numEvents = 0;
+  for (size_t p = trace.find("\"ph\""); p != string::npos;
+       p = trace.find("\"ph\"", p + 1)) {
+    ++numEvents;
+  }
+  CHECK_EQ(numEvents, 14u);
+
+  // Disabled at run time.
+  ProfilerClear();
+  ProfilerEnable(false);
+  Outer(2);
+  CHECK(!ProfilerEnabled());
+  CHECK_EQ(ProfilerNumEvents(), 0);
+  ProfilerEnable(true);
+
+  // Cost of an enabled scope.
+  ProfilerClear();
+  const int N = 100000;
+  Timer scopeTimer;
+  for (int i = 0; i < N; ++i) {
+    PROFILE_SCOPE("Empty");
+  }
+  LOG(INFO) << "Cost of a profiled scope: " << scopeTimer.elapsed() / N * 1e9
+            << " ns.";
+  int64_t numDropped;
+  CHECK_EQ(ProfilerNumEvents(&numDropped), N);
+  CHECK_EQ(numDropped, 0);
+
+  LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
+  return 0;
+}
@@ -0,0 +1,85 @@
+/**
+  * Counter-based random number generation. Unlike a sequential engine, the
+  * random numbers are a pure function of a key (the seed) and a counter (the
+  * position in the stream), so that any part of a stream can be generated
+  * independently, e.g. by several threads, with results that do not depend on
+  * how the work is split. Example usage:
+  *   Philox4x32 rng(seed);
+  *   uint32_t bits[4];
+  *   rng.Generate(i, bits);      // The i-th block of 4 random words.
+  *   double u = UniformOpenClosed(bits[0], bits[1]);
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#ifndef __XYUTILS_RANDOM_H__
+#define __XYUTILS_RANDOM_H__
+
+#ifdef __USE_TR1__
+#include <tr1/cstdint>
+#else
+#include <cstdint>
+#endif
+
+namespace xyUtils  {
+
+// The Philox4x32-10 generator of Salmon et al., "Parallel Random Numbers: As
+// Easy as 1, 2, 3", SC 2011, which maps a 128-bit counter and a 64-bit key to
+// 128 random bits with 10 rounds of multiplications and xors. It passes the
+// BigCrush tests, and its output matches the reference implementation Random123.
+class Philox4x32 {
+ public:
+  explicit Philox4x32(uint64_t key) {
+    key_[0] = static_cast<uint32_t>(key);
+    key_[1] = static_cast<uint32_t>(key >> 32);
+  }
+
+  // The 4 random words for 'counter'.
+  void Generate(const uint32_t counter[4], uint32_t out[4]) const {
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key_[0], k1 = key_[1];
+    for (int round = 0; round < 10; ++round) {
+      uint64_t p0 = uint64_t(kMultiplier0) * c0;
+      uint64_t p1 = uint64_t(kMultiplier1) * c2;
+      uint32_t hi0 = p0 >> 32, lo0 = static_cast<uint32_t>(p0);
+      uint32_t hi1 = p1 >> 32, lo1 = static_cast<uint32_t>(p1);
+      c0 = hi1 ^ c1 ^ k0;
+      c1 = lo1;
+      c2 = hi0 ^ c3 ^ k1;
+      c3 = lo0;
+      k0 += kWeyl0;
+      k1 += kWeyl1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+  // Same as above with the counter {low word, high word, 0, 0} of 'counter'.
+  void Generate(uint64_t counter, uint32_t out[4]) const {
+    uint32_t c[4] = {static_cast<uint32_t>(counter),
+                     static_cast<uint32_t>(counter >> 32), 0, 0};
+    Generate(c, out);
+  }
+
+ private:
+  static const uint32_t kMultiplier0 = 0xD2511F53;
+  static const uint32_t kMultiplier1 = 0xCD9E8D57;
+  static const uint32_t kWeyl0 = 0x9E3779B9;      // Golden ratio.
+  static const uint32_t kWeyl1 = 0xBB67AE85;      // sqrt(3) - 1.
+  uint32_t key_[2];
+};
+
+// A uniform random double with 53 random bits from the words 'hi' and 'lo', in
+// [0, 1) and (0, 1] respectively. The latter is safe to take the log of.
+inline double UniformClosedOpen(uint32_t hi, uint32_t lo) {
+  return ((uint64_t(hi) << 32 | lo) >> 11) * (1.0 / 9007199254740992.0);
+}
+inline double UniformOpenClosed(uint32_t hi, uint32_t lo) {
+  return (((uint64_t(hi) << 32 | lo) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+}   // namespace xyUtils
+
+#endif   // __XYUTILS_RANDOM_H__
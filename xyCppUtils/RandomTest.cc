@@ -0,0 +1,68 @@
+/**
+  * Test for random number generation.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "Random.h"
+
+#include "LogAndCheck.h"
+#include "Timer.h"
+
+using namespace xyUtils;
+
+// Check 'rng' on 'counter' against the known answer 'expected'.
+void CheckPhilox(const Philox4x32& rng, const uint32_t counter[4],
+                 const uint32_t expected[4]) {
+  uint32_t out[4];
+  rng.Generate(counter, out);
+  for (int i = 0; i < 4; ++i)   CHECK_EQ(out[i], expected[i]);
+}
+
+int main()  {
+  Timer timer;
+  LOG(INFO) << "Test on random number generation ...";
+
+  // Known answers of Random123.
+  uint32_t zeros[4] = {0, 0, 0, 0};
+  uint32_t expected0[4] = {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8};
+  CheckPhilox(Philox4x32(0), zeros, expected0);
+  uint32_t ones[4] = {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+  uint32_t expected1[4] = {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd};
+  CheckPhilox(Philox4x32(0xffffffffffffffffULL), ones, expected1);
+  uint32_t pi[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+  uint32_t expected2[4] = {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1};
+  CheckPhilox(Philox4x32(0x299f31d0a4093822ULL), pi, expected2);
+
+  // The 64-bit counter goes to the first two words.
+  Philox4x32 rng(12345);
+  uint32_t counter[4] = {0x89abcdef, 0x01234567, 0, 0};
+  uint32_t a[4], b[4];
+  rng.Generate(counter, a);
+  rng.Generate(0x0123456789abcdefULL, b);
+  for (int i = 0; i < 4; ++i)   CHECK_EQ(a[i], b[i]);
+
+  // Uniform doubles.
+  CHECK_EQ(UniformClosedOpen(0, 0), 0.0);
+  CHECK_LT(UniformClosedOpen(0xffffffff, 0xffffffff), 1.0);
+  CHECK_GT(UniformOpenClosed(0, 0), 0.0);
+  CHECK_EQ(UniformOpenClosed(0xffffffff, 0xffffffff), 1.0);
+  const int N = 100000;
+  double sum = 0.0, sum2 = 0.0;
+  for (int i = 0; i < N; ++i) {
+    rng.Generate(i, a);
+    double u = UniformClosedOpen(a[0], a[1]);
+    double v = UniformOpenClosed(a[2], a[3]);
+    CHECK(u >= 0.0 && u < 1.0);
+    CHECK(v > 0.0 && v <= 1.0);
+    sum += u + v;
+    sum2 += u * u + v * v;
+  }
+  double mean = sum / (2 * N), var = sum2 / (2 * N) - mean * mean;
+  CHECK_NEAR(mean, 0.5, 0.01);
+  CHECK_NEAR(var, 1.0 / 12, 0.01);
+
+  LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
+  return 0;
+}
@@ -1,5 +1,6 @@
 /**
-  * Utilities for converting string (char*) to other various data types.
+  * Utilities for converting string (char*) to other various data types, and
+  * numbers back to strings.
   *
   * Author: Ying Xiong
   * Created: Aug 18, 2012
@@ -12,12 +13,569 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+#ifdef __USE_TR1__
+#include <tr1/cstdint>
+#else
+#include <cstdint>
+#endif
+
+#include "StringConvertTables.h"
 
 using std::string;
 
 namespace xyUtils  {
 namespace StringConvert {
 
+namespace {
+// Powers of ten that are exact in double and float respectively.
+const double kExactPowersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+  1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const float kExactFloatPowersOfTen[] = {
+  1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+// The "C" locale, so that the fallbacks to strtod do not depend on the locale
+// of the program (e.g. a decimal comma).
+locale_t CLocale() {
+  static locale_t locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+  return locale;
+}
+
+// The conversions of a null terminated 'str' with the C library.
+OutStatus StrtolToLong(const char* str, long* l) {
+  char* end;
+  errno = 0;
+  *l = strtol(str, &end, 0);
+  if (errno == ERANGE && *l == LONG_MAX) {
+    return Overflow;
+  } else if (errno == ERANGE && *l == LONG_MIN)  {
+    return Underflow;
+  } else if (*str == '\0' || *end != '\0')  {
+    return Inconvertible;
+  } else  {
+    return Success;
+  }
+}
+
+OutStatus StrtolToInt(const char* str, int* i) {
+  long l;
+  OutStatus out = StrtolToLong(str, &l);
+  if (out == Overflow || (out == Success && l > INT_MAX)) {
+    return Overflow;
+  } else if (out == Underflow || (out == Success && l < INT_MIN)) {
+    return Underflow;
+  } else if (out == Success) {
+    *i = l;
+  }
+  return out;
+}
+
+OutStatus StrtodToDouble(const char* str, double* d) {
+  char* end;
+  errno = 0;
+  *d = strtod_l(str, &end, CLocale());
+  if (errno == ERANGE && *d == HUGE_VAL)  {
+    return Overflow;
+  } else if (errno == ERANGE && *d == -HUGE_VAL)  {
+    return Underflow;
+  } else if (*str == '\0' || *end != '\0')  {
+    return Inconvertible;
+  } else  {
+    return Success;
+  }
+}
+
+OutStatus StrtofToFloat(const char* str, float* f) {
+  char* end;
+  errno = 0;
+  *f = strtof_l(str, &end, CLocale());
+  if (errno == ERANGE && *f == HUGE_VALF)  {
+    return Overflow;
+  } else if (errno == ERANGE && *f == -HUGE_VALF)  {
+    return Underflow;
+  } else if (*str == '\0' || *end != '\0')  {
+    return Inconvertible;
+  } else  {
+    return Success;
+  }
+}
+
+// Convert the 'len' characters at 'str' with 'convert' on a null terminated
+// copy.
+template<typename T>
+OutStatus ConvertCopy(OutStatus (*convert)(const char*, T*),
+                      const char* str, size_t len, T* out) {
+  if (memchr(str, '\0', len))   return Inconvertible;
+  char buffer[64];
+  if (len < sizeof(buffer)) {
+    memcpy(buffer, str, len);
+    buffer[len] = '\0';
+    return convert(buffer, out);
+  }
+  return convert(string(str, len).c_str(), out);
+}
+
+// Decimal integers, with the rest (e.g. hexadecimal "0x1F", octal "017" or
+// leading white space) left to strtol.
+template<typename Int>
+OutStatus ToInteger(const char* str, size_t len, Int* out,
+                    OutStatus (*fallback)(const char*, Int*)) {
+  const char* p = str;
+  const char* end = str + len;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  if (p == end || *p < '0' || *p > '9' || (*p == '0' && end - p > 1)) {
+    return ConvertCopy(fallback, str, len, out);
+  }
+  // The magnitude of the result may not exceed 'limit'.
+  const uint64_t limit = negative ?
+      uint64_t(-(std::numeric_limits<Int>::min() + 1)) + 1 :
+      uint64_t(std::numeric_limits<Int>::max());
+  uint64_t value = 0;
+  bool outOfRange = false;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    unsigned digit = *p - '0';
+    if (value > (limit - digit) / 10) {
+      outOfRange = true;
+    } else {
+      value = value * 10 + digit;
+    }
+  }
+  if (outOfRange) {
+    return negative ? Underflow : Overflow;
+  } else if (p != end) {
+    return Inconvertible;
+  }
+  *out = !negative ? Int(value) : value == 0 ? 0 : -Int(value - 1) - 1;
+  return Success;
+}
+
+// A plain decimal number, i.e. 'mantissa' * 10^'exp10' with a sign, where
+// 'truncated' tells if non-zero digits after the first 19 significant ones were
+// dropped, in which case the number is between 'mantissa' and 'mantissa' + 1
+// times 10^'exp10'.
+struct Decimal {
+  bool negative;
+  uint64_t mantissa;
+  int exp10;
+  bool truncated;
+};
+
+// Scan exactly the 'len' characters at 'str' as a plain decimal number. Return
+// false for anything else, e.g. "inf", hexadecimal or leading white space.
+bool ScanDecimal(const char* str, size_t len, Decimal* dec) {
+  const char* p = str;
+  const char* end = str + len;
+  dec->negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    dec->negative = *p == '-';
+    ++p;
+  }
+  // Up to 19 significant digits fit in 'mantissa' without overflow.
+  uint64_t mantissa = 0;
+  int numDigits = 0, exp10 = 0;
+  bool anyDigit = false, truncated = false;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    anyDigit = true;
+    if (numDigits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa > 0)   ++numDigits;
+    } else {
+      ++exp10;
+      truncated |= *p != '0';
+    }
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+      anyDigit = true;
+      if (numDigits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa > 0)   ++numDigits;
+        --exp10;
+      } else {
+        truncated |= *p != '0';
+      }
+    }
+  }
+  if (anyDigit && p < end && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    bool negativeExp = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+      negativeExp = *q == '-';
+      ++q;
+    }
+    if (q < end && *q >= '0' && *q <= '9') {
+      int e = 0;
+      for (; q < end && *q >= '0' && *q <= '9'; ++q) {
+        if (e < 100000)   e = e * 10 + (*q - '0');
+      }
+      exp10 += negativeExp ? -e : e;
+      p = q;
+    }
+  }
+  dec->mantissa = mantissa;
+  dec->exp10 = exp10;
+  dec->truncated = truncated;
+  return anyDigit && p == end;
+}
+
+// The high and low words of the 128-bit product of 'a' and 'b'.
+inline void Multiply128(uint64_t a, uint64_t b, uint64_t* high, uint64_t* low) {
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 p = static_cast<unsigned __int128>(a) * b;
+  *high = static_cast<uint64_t>(p >> 64);
+  *low = static_cast<uint64_t>(p);
+#else
+  uint64_t aLo = a & 0xFFFFFFFF, aHi = a >> 32;
+  uint64_t bLo = b & 0xFFFFFFFF, bHi = b >> 32;
+  uint64_t lolo = aLo * bLo, hilo = aHi * bLo, lohi = aLo * bHi;
+  uint64_t cross = (lolo >> 32) + (hilo & 0xFFFFFFFF) + lohi;
+  *high = aHi * bHi + (hilo >> 32) + (cross >> 32);
+  *low = (cross << 32) | (lolo & 0xFFFFFFFF);
+#endif
+}
+
+// The binary floating point formats, for the conversions below.
+struct DoubleFormat {
+  typedef double Float;
+  typedef uint64_t Bits;
+  static const int kMantissaBits = 52;
+  static const int kMinExponent = -1023;
+  static const int kInfinitePower = 0x7FF;
+  // Range of 10^q to go through Eisel-Lemire, beyond which the result is
+  // always zero or infinity.
+  static const int kSmallestPowerOfTen = -342;
+  static const int kLargestPowerOfTen = 308;
+  // Range of 10^q where w * 10^q can be exactly halfway between two floats.
+  static const int kMinRoundToEven = -4;
+  static const int kMaxRoundToEven = 23;
+  static const int kMaxExactPowerOfTen = 22;
+  static const uint64_t kMaxExactMantissa = uint64_t(1) << 53;
+  static double ExactPowerOfTen(int i) { return kExactPowersOfTen[i]; }
+  static OutStatus Fallback(const char* str, double* d) {
+    return StrtodToDouble(str, d);
+  }
+};
+
+struct FloatFormat {
+  typedef float Float;
+  typedef uint32_t Bits;
+  static const int kMantissaBits = 23;
+  static const int kMinExponent = -127;
+  static const int kInfinitePower = 0xFF;
+  static const int kSmallestPowerOfTen = -65;
+  static const int kLargestPowerOfTen = 38;
+  static const int kMinRoundToEven = -17;
+  static const int kMaxRoundToEven = 10;
+  static const int kMaxExactPowerOfTen = 10;
+  static const uint64_t kMaxExactMantissa = uint64_t(1) << 24;
+  static float ExactPowerOfTen(int i) { return kExactFloatPowersOfTen[i]; }
+  static OutStatus Fallback(const char* str, float* f) {
+    return StrtofToFloat(str, f);
+  }
+};
+
+// Compute the correctly rounded 'Format' number of w * 10^q (w > 0) as its
+// biased binary exponent 'power2' and its 'mantissa' without the implicit bit,
+// with the algorithm of Eisel and Lemire, "Number Parsing at a Gigabyte per
+// Second", 2021: w times the truncated 128-bit 5^q has enough bits to round
+// correctly, which Mushtak and Lemire, "Fast Number Parsing Without Fallback",
+// 2023, proved for all w with at most 19 digits.
+template<typename Format>
+void EiselLemire(int q, uint64_t w, uint64_t* mantissa, int* power2) {
+  const int kMantissaBits = Format::kMantissaBits;
+  if (q < Format::kSmallestPowerOfTen) {
+    *mantissa = 0;
+    *power2 = 0;
+    return;
+  } else if (q > Format::kLargestPowerOfTen) {
+    *mantissa = 0;
+    *power2 = Format::kInfinitePower;
+    return;
+  }
+  int lz = __builtin_clzll(w);
+  w <<= lz;
+  // The product with the first 64 bits of 5^q, extended with the next 64 bits
+  // if the bits below the ones we need might carry.
+  const uint64_t* power5 = kPowersOfFive128[q - kSmallestPowerOfFive];
+  uint64_t high, low;
+  Multiply128(w, power5[0], &high, &low);
+  const uint64_t precisionMask = ~uint64_t(0) >> (kMantissaBits + 3);
+  if ((high & precisionMask) == precisionMask) {
+    uint64_t high2, low2;
+    Multiply128(w, power5[1], &high2, &low2);
+    low += high2;
+    if (high2 > low)   ++high;
+  }
+  // Keep one more bit than the mantissa for rounding.
+  int upperBit = high >> 63;
+  int shift = upperBit + 64 - kMantissaBits - 3;
+  uint64_t m = high >> shift;
+  // floor(log2(10^q)) + 63 + ..., where 217706 / 2^16 ~ log2(10).
+  int p2 = ((217706 * q) >> 16) + 63 + upperBit - lz - Format::kMinExponent;
+  if (p2 <= 0) {
+    // Subnormal, or zero.
+    if (-p2 + 1 >= 64) {
+      *mantissa = 0;
+      *power2 = 0;
+      return;
+    }
+    m >>= -p2 + 1;
+    m += m & 1;
+    m >>= 1;
+    *mantissa = m;
+    *power2 = m < (uint64_t(1) << kMantissaBits) ? 0 : 1;
+    return;
+  }
+  // Exactly halfway between two floats, round to even instead of up.
+  if (low <= 1 && q >= Format::kMinRoundToEven &&
+      q <= Format::kMaxRoundToEven && (m & 3) == 1 && (m << shift) == high) {
+    m &= ~uint64_t(1);
+  }
+  m += m & 1;
+  m >>= 1;
+  if (m >= (uint64_t(2) << kMantissaBits)) {
+    m = uint64_t(1) << kMantissaBits;
+    ++p2;
+  }
+  m &= ~(uint64_t(1) << kMantissaBits);
+  if (p2 >= Format::kInfinitePower) {
+    p2 = Format::kInfinitePower;
+    m = 0;
+  }
+  *mantissa = m;
+  *power2 = p2;
+}
+
+// Convert exactly the 'len' characters at 'str' to a 'Format' number.
+template<typename Format>
+OutStatus ToFloatingPoint(const char* str, size_t len,
+                          typename Format::Float* out) {
+  typedef typename Format::Float Float;
+  typedef typename Format::Bits Bits;
+  Decimal dec;
+  if (!ScanDecimal(str, len, &dec)) {
+    return ConvertCopy(&Format::Fallback, str, len, out);
+  }
+  if (dec.mantissa == 0) {
+    *out = dec.negative ? -Float(0) : Float(0);
+    return Success;
+  }
+  // Both 'mantissa' and the power of ten are exact, so that a single rounding
+  // gives the correctly rounded result (Clinger's fast path).
+  if (!dec.truncated && dec.mantissa <= Format::kMaxExactMantissa &&
+      dec.exp10 >= -Format::kMaxExactPowerOfTen &&
+      dec.exp10 <= Format::kMaxExactPowerOfTen) {
+    Float value = Float(dec.mantissa);
+    if (dec.exp10 < 0) {
+      value /= Format::ExactPowerOfTen(-dec.exp10);
+    } else {
+      value *= Format::ExactPowerOfTen(dec.exp10);
+    }
+    *out = dec.negative ? -value : value;
+    return Success;
+  }
+  uint64_t mantissa;
+  int power2;
+  EiselLemire<Format>(dec.exp10, dec.mantissa, &mantissa, &power2);
+  if (dec.truncated) {
+    // The dropped digits matter only if the rounding differs between the two
+    // ends of the interval, which is rare.
+    uint64_t mantissa1;
+    int power21;
+    EiselLemire<Format>(dec.exp10, dec.mantissa + 1, &mantissa1, &power21);
+    if (mantissa != mantissa1 || power2 != power21) {
+      return ConvertCopy(&Format::Fallback, str, len, out);
+    }
+  }
+  const int kSignShift = sizeof(Bits) * 8 - 1;
+  Bits bits = Bits(mantissa) | Bits(power2) << Format::kMantissaBits |
+      Bits(dec.negative) << kSignShift;
+  memcpy(out, &bits, sizeof(bits));
+  if (power2 == Format::kInfinitePower) {
+    return dec.negative ? Underflow : Overflow;
+  }
+  return Success;
+}
+// The two digit strings "00", "01", ..., "99".
+const char kDigitPairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536"
+  "37383940414243444546474849505152535455565758596061626364656667686970717273"
+  "7475767778798081828384858687888990919293949596979899";
+
+// Write the decimal digits of 'value' ending at 'end', and return the start.
+char* WriteDigitsBackward(uint64_t value, char* end) {
+  while (value >= 100) {
+    end -= 2;
+    memcpy(end, kDigitPairs + 2 * (value % 100), 2);
+    value /= 100;
+  }
+  if (value >= 10) {
+    end -= 2;
+    memcpy(end, kDigitPairs + 2 * value, 2);
+  } else {
+    *--end = char('0' + value);
+  }
+  return end;
+}
+
+// Helpers of the shortest decimal below, for e >= 0 and value > 0.
+inline int Pow5Bits(int e) {          // Number of bits of 5^e.
+  return int((uint32_t(e) * 1217359) >> 19) + 1;
+}
+inline int Log10Pow2(int e) {         // floor(log10(2^e)).
+  return int((uint32_t(e) * 78913) >> 18);
+}
+inline int Log10Pow5(int e) {         // floor(log10(5^e)).
+  return int((uint32_t(e) * 732923) >> 20);
+}
+inline bool MultipleOfPowerOf5(uint64_t value, int p) {
+  int count = 0;
+  for (; value % 5 == 0; value /= 5)   ++count;
+  return count >= p;
+}
+inline bool MultipleOfPowerOf2(uint64_t value, int p) {
+  return (value & ((uint64_t(1) << p) - 1)) == 0;
+}
+
+// (m * mul) >> j for the 125-bit 'mul' as {high, low}, where 64 < j < 128.
+inline uint64_t MulShift(uint64_t m, const uint64_t mul[2], int j) {
+  uint64_t high0, low0, high1, low1;
+  Multiply128(m, mul[1], &high0, &low0);
+  Multiply128(m, mul[0], &high1, &low1);
+  uint64_t sum = high0 + low1;
+  high1 += sum < high0;
+  int shift = j - 64;
+  return (high1 << (64 - shift)) | (sum >> shift);
+}
+
+// The shortest 'digits' * 10^'exp10' that converts back to the positive finite
+// double with the fields 'ieeeMantissa' and 'ieeeExponent', and the closest to
+// it if there are several, with the Ryu algorithm of Adams, "Ryu: Fast
+// Float-to-String Conversion", PLDI 2018. The interval of decimals rounding to
+// the double is computed with 125-bit powers of five, and digits are removed
+// while both of its ends agree.
+void ShortestDecimal(uint64_t ieeeMantissa, int ieeeExponent,
+                     uint64_t* digits, int* exp10) {
+  // Integers up to 2^53 are shortest without their trailing zeros.
+  int e2 = ieeeExponent - 1075;
+  uint64_t m2 = (uint64_t(1) << 52) | ieeeMantissa;
+  if (ieeeExponent != 0 && e2 <= 0 && e2 >= -52 &&
+      MultipleOfPowerOf2(m2, -e2)) {
+    uint64_t value = m2 >> -e2;
+    int e = 0;
+    for (; value % 10 == 0; value /= 10)   ++e;
+    *digits = value;
+    *exp10 = e;
+    return;
+  }
+  // The double is m2 * 2^e2, and the interval is (mv - 2 - mmShift, mv + 2)
+  // times 2^(e2 - 2), including its ends if 'm2' is even.
+  if (ieeeExponent == 0) {
+    e2 = 1 - 1023 - 52 - 2;
+    m2 = ieeeMantissa;
+  } else {
+    e2 -= 2;
+  }
+  const bool acceptBounds = (m2 & 1) == 0;
+  const uint64_t mv = 4 * m2;
+  const int mmShift = ieeeMantissa != 0 || ieeeExponent <= 1;
+  // The interval times a power of ten, truncated, and whether the truncated
+  // parts are all zeros.
+  uint64_t vr, vp, vm;
+  int e10;
+  bool vmIsTrailingZeros = false, vrIsTrailingZeros = false;
+  if (e2 >= 0) {
+    const int q = Log10Pow2(e2) - (e2 > 3);
+    e10 = q;
+    const int k = kPowersOfFive125Bits + Pow5Bits(q) - 1;
+    const int i = -e2 + q + k;
+    vr = MulShift(4 * m2, kInversePowersOfFive125[q], i);
+    vp = MulShift(4 * m2 + 2, kInversePowersOfFive125[q], i);
+    vm = MulShift(4 * m2 - 1 - mmShift, kInversePowersOfFive125[q], i);
+    if (q <= 21) {
+      if (mv % 5 == 0) {
+        vrIsTrailingZeros = MultipleOfPowerOf5(mv, q);
+      } else if (acceptBounds) {
+        vmIsTrailingZeros = MultipleOfPowerOf5(mv - 1 - mmShift, q);
+      } else {
+        vp -= MultipleOfPowerOf5(mv + 2, q);
+      }
+    }
+  } else {
+    const int q = Log10Pow5(-e2) - (-e2 > 1);
+    e10 = q + e2;
+    const int i = -e2 - q;
+    const int k = Pow5Bits(i) - kPowersOfFive125Bits;
+    const int j = q - k;
+    vr = MulShift(4 * m2, kPowersOfFive125[i], j);
+    vp = MulShift(4 * m2 + 2, kPowersOfFive125[i], j);
+    vm = MulShift(4 * m2 - 1 - mmShift, kPowersOfFive125[i], j);
+    if (q <= 1) {
+      vrIsTrailingZeros = true;
+      if (acceptBounds) {
+        vmIsTrailingZeros = mmShift == 1;
+      } else {
+        --vp;
+      }
+    } else if (q < 63) {
+      vrIsTrailingZeros = MultipleOfPowerOf2(mv, q);
+    }
+  }
+  // Remove the digits while the ends of the interval differ, keeping track of
+  // the last removed digit of 'vr' for rounding.
+  int removed = 0;
+  int lastRemovedDigit = 0;
+  uint64_t output;
+  if (vmIsTrailingZeros || vrIsTrailingZeros) {
+    // The rare general case, where the ends are exact.
+    for (; vp / 10 > vm / 10; vp /= 10, vm /= 10, vr /= 10, ++removed) {
+      vmIsTrailingZeros &= vm % 10 == 0;
+      vrIsTrailingZeros &= lastRemovedDigit == 0;
+      lastRemovedDigit = vr % 10;
+    }
+    if (vmIsTrailingZeros) {
+      for (; vm % 10 == 0; vp /= 10, vm /= 10, vr /= 10, ++removed) {
+        vrIsTrailingZeros &= lastRemovedDigit == 0;
+        lastRemovedDigit = vr % 10;
+      }
+    }
+    // Exactly halfway, round to even.
+    if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0) {
+      lastRemovedDigit = 4;
+    }
+    output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) ||
+                   lastRemovedDigit >= 5);
+  } else {
+    bool roundUp = false;
+    if (vp / 100 > vm / 100) {
+      roundUp = vr % 100 >= 50;
+      vp /= 100;
+      vm /= 100;
+      vr /= 100;
+      removed += 2;
+    }
+    for (; vp / 10 > vm / 10; vp /= 10, vm /= 10, vr /= 10, ++removed) {
+      roundUp = vr % 10 >= 5;
+    }
+    output = vr + (vr == vm || roundUp);
+  }
+  *digits = output;
+  *exp10 = e10 + removed;
+}
+}   // namespace
+
 std::string OutStatusString(OutStatus status) {
   switch (status) {
     case Success:           return "Success";
@@ -47,49 +605,123 @@ OutStatus ToBool(const char* str, bool* b)  {
 }
 
 OutStatus ToInt(const char* str, int* i)  {
-  char* end;
-  errno = 0;
-  long l = strtol(str, &end, 0);
-  if ((errno == ERANGE && l == LONG_MAX) || l > INT_MAX)  {
-    return Overflow;
-  } else if ((errno == ERANGE && l == LONG_MIN) || l < INT_MIN) {
-    return Underflow;
-  } else if (*str == '\0' || *end != '\0')  {
-    return Inconvertible;
-  } else  {
-    *i = l;
-    return Success;
-  }
+  return ToInt(str, strlen(str), i);
 }
 
 OutStatus ToLong(const char* str, long* l)  {
-  char* end;
-  errno = 0;
-  *l = strtol(str, &end, 0);
-  if (errno == ERANGE && *l == LONG_MAX) {
-    return Overflow;
-  } else if (errno == ERANGE && *l == LONG_MIN)  {
-    return Underflow;
-  } else if (*str == '\0' || *end != '\0')  {
-    return Inconvertible;
-  } else  {
-    return Success;
-  }
+  return ToLong(str, strlen(str), l);
+}
+
+OutStatus ToFloat(const char* str, float* f)  {
+  return ToFloat(str, strlen(str), f);
 }
 
 OutStatus ToDouble(const char* str, double* d)  {
-  char* end;
-  errno = 0;
-  *d = strtod(str, &end);
-  if (errno == ERANGE && *d == HUGE_VAL)  {
-    return Overflow;
-  } else if (errno == ERANGE && *d == -HUGE_VAL)  {
-    return Underflow;
-  } else if (*str == '\0' || *end != '\0')  {
-    return Inconvertible;
-  } else  {
-    return Success;
+  return ToDouble(str, strlen(str), d);
+}
+
+OutStatus ToInt(const char* str, size_t len, int* i)  {
+  return ToInteger(str, len, i, &StrtolToInt);
+}
+
+OutStatus ToLong(const char* str, size_t len, long* l)  {
+  return ToInteger(str, len, l, &StrtolToLong);
+}
+
+OutStatus ToFloat(const char* str, size_t len, float* f)  {
+  return ToFloatingPoint<FloatFormat>(str, len, f);
+}
+
+OutStatus ToDouble(const char* str, size_t len, double* d)  {
+  return ToFloatingPoint<DoubleFormat>(str, len, d);
+}
+
+char* FormatLong(long l, char* buffer) {
+  uint64_t value = l;
+  if (l < 0) {
+    *buffer++ = '-';
+    value = ~value + 1;
+  }
+  char digits[20];
+  char* begin = WriteDigitsBackward(value, digits + sizeof(digits));
+  size_t n = digits + sizeof(digits) - begin;
+  memcpy(buffer, begin, n);
+  return buffer + n;
+}
+
+char* FormatDouble(double d, char* buffer) {
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  const uint64_t ieeeMantissa = bits & ((uint64_t(1) << 52) - 1);
+  const int ieeeExponent = int(bits >> 52) & 0x7FF;
+  if (ieeeExponent == 0x7FF && ieeeMantissa != 0) {
+    memcpy(buffer, "nan", 3);
+    return buffer + 3;
+  }
+  if (bits >> 63)   *buffer++ = '-';
+  if (ieeeExponent == 0x7FF) {
+    memcpy(buffer, "inf", 3);
+    return buffer + 3;
+  } else if (ieeeExponent == 0 && ieeeMantissa == 0) {
+    *buffer = '0';
+    return buffer + 1;
   }
+  uint64_t value;
+  int exp10;
+  ShortestDecimal(ieeeMantissa, ieeeExponent, &value, &exp10);
+  char digits[20];
+  const char* first = WriteDigitsBackward(value, digits + sizeof(digits));
+  const int numDigits = digits + sizeof(digits) - first;
+  // The same layout as "%.17g" without trailing zeros, i.e. fixed point unless
+  // the exponent of the first digit is below -4 or above 16.
+  const int exp = numDigits + exp10 - 1;
+  char* p = buffer;
+  if (exp < -4 || exp > 16) {
+    *p++ = first[0];
+    if (numDigits > 1) {
+      *p++ = '.';
+      memcpy(p, first + 1, numDigits - 1);
+      p += numDigits - 1;
+    }
+    *p++ = 'e';
+    *p++ = exp < 0 ? '-' : '+';
+    int absExp = exp < 0 ? -exp : exp;
+    if (absExp >= 100) {
+      *p++ = char('0' + absExp / 100);
+      absExp %= 100;
+    }
+    memcpy(p, kDigitPairs + 2 * absExp, 2);
+    p += 2;
+  } else if (exp10 >= 0) {
+    memcpy(p, first, numDigits);
+    p += numDigits;
+    memset(p, '0', exp10);
+    p += exp10;
+  } else if (exp >= 0) {
+    memcpy(p, first, exp + 1);
+    p += exp + 1;
+    *p++ = '.';
+    memcpy(p, first + exp + 1, numDigits - exp - 1);
+    p += numDigits - exp - 1;
+  } else {
+    *p++ = '0';
+    *p++ = '.';
+    memset(p, '0', -exp - 1);
+    p += -exp - 1;
+    memcpy(p, first, numDigits);
+    p += numDigits;
+  }
+  return p;
+}
+
+void AppendLong(long l, std::string* str) {
+  char buffer[kMaxLongChars];
+  str->append(buffer, FormatLong(l, buffer) - buffer);
+}
+
+void AppendDouble(double d, std::string* str) {
+  char buffer[kMaxDoubleChars];
+  str->append(buffer, FormatDouble(d, buffer) - buffer);
 }
 }   // namespace StringConvert
 }   // namespace xyUtils
@@ -1,5 +1,6 @@
 /**
-  * Utilities for converting string (char*) to various other data types.
+  * Utilities for converting string (char*) to various other data types, and
+  * numbers back to strings.
   *
   * Author: Ying Xiong
   * Created: Aug 18, 2012
@@ -20,27 +21,66 @@ enum OutStatus  {
 
 std::string OutStatusString(OutStatus);
 
-/** Convert char* string to bool/int/long/double.
+/** Convert char* string to bool/int/long/float/double.
  * bool type supports "True", "true", "1", "False", "false" and "0".
  */
 OutStatus ToBool(const char* str, bool* b);
 OutStatus ToInt(const char* str, int* i);
 OutStatus ToLong(const char* str, long* l);
+OutStatus ToFloat(const char* str, float* f);
 OutStatus ToDouble(const char* str, double* d);
 
+/** Convert exactly the 'len' characters at 'str' (which need not be null
+ * terminated) to int/long/float/double, e.g. a token in a memory mapped file.
+ * Decimal numbers (e.g. "-125", "-0.346497" or "1.5e-3") are converted without
+ * the C library and independently of the locale: integers with overflow checks,
+ * and floating point numbers correctly rounded with the Eisel-Lemire algorithm.
+ * Other inputs (e.g. hexadecimal, "inf" or leading white space) fall back to
+ * strtol/strtod in the "C" locale. The status is the same either way, e.g. a
+ * double beyond the range is an Overflow (or an Underflow if negative), and one
+ * that rounds to zero is a Success.
+ */
+OutStatus ToInt(const char* str, size_t len, int* i);
+OutStatus ToLong(const char* str, size_t len, long* l);
+OutStatus ToFloat(const char* str, size_t len, float* f);
+OutStatus ToDouble(const char* str, size_t len, double* d);
+
 inline OutStatus ToBool(const std::string& str, bool* b) {
   return ToBool(str.c_str(), b);
 }
 inline OutStatus ToInt(const std::string& str, int* i) {
-  return ToInt(str.c_str(), i);
+  return ToInt(str.data(), str.size(), i);
 }
 inline OutStatus ToLong(const std::string& str, long* l) {
-  return ToLong(str.c_str(), l);
+  return ToLong(str.data(), str.size(), l);
+}
+inline OutStatus ToFloat(const std::string& str, float* f) {
+  return ToFloat(str.data(), str.size(), f);
 }
 inline OutStatus ToDouble(const std::string& str, double* d) {
-  return ToDouble(str.c_str(), d);
+  return ToDouble(str.data(), str.size(), d);
 }
 
+/** Format 'l'/'d' to the 'buffer' with room for at least kMaxLongChars or
+ * kMaxDoubleChars characters, and return the end of the written characters
+ * (which are not null terminated). Doubles are written with the fewest
+ * significant digits that convert back to the same double (e.g. "0.1" rather
+ * than "0.10000000000000001"), the closest such digits if there are several,
+ * in the layout of "%.17g" (e.g. "-1.5", "1e+100" or "2.5e-05"), and "nan",
+ * "inf" or "-inf" for the special values. Unlike printf, this does not depend
+ * on the locale, and does not allocate.
+ */
+const int kMaxLongChars = 20;
+const int kMaxDoubleChars = 24;
+char* FormatLong(long l, char* buffer);
+char* FormatDouble(double d, char* buffer);
+
+/** Append 'l'/'d' formatted as above to 'str', e.g. to build the lines of a
+ * text file in a reused string instead of with PrintfToString.
+ */
+void AppendLong(long l, std::string* str);
+void AppendDouble(double d, std::string* str);
+
 template<typename T> int ToBoolAndCheck(const T& str) {
   bool b;
   OutStatus out = ToBool(str, &b);
@@ -71,6 +111,16 @@ template<typename T> long ToLongAndCheck(const T& str) {
   return l;
 }
 
+template<typename T> float ToFloatAndCheck(const T& str) {
+  float f;
+  OutStatus out = ToFloat(str, &f);
+  if (out != Success) {
+    LOG(FATAL) << "Error: " << OutStatusString(out)
+               << ": Cannot convert string \"" << str << "\" to float.";
+  }
+  return f;
+}
+
 template<typename T> double ToDoubleAndCheck(const T& str) {
   double d;
   OutStatus out = ToDouble(str, &d);
@@ -0,0 +1,183 @@
+/**
+  * Benchmarks for string conversions in both directions, against the C
+  * library.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "StringConvert.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CommandLineFlags.h"
+#include "FileIO.h"
+#include "LogAndCheck.h"
+#include "StringUtils.h"
+#include "StringView.h"
+
+using namespace std;
+using namespace xyUtils;
+
+// The white space separated tokens of 'text'.
+vector<StringView> Tokens(const string& text) {
+  vector<StringView> tokens;
+  StringUtils::Tokenizer tokenizer(text);
+  StringView token;
+  while (tokenizer.Next(&token))   tokens.push_back(token);
+  return tokens;
+}
+
+// Benchmark ToDouble and strtod on the 'tokens' of 'text', which must be
+// numbers.
+void RunDouble(BenchmarkSuite* suite, const char* name, const string& text,
+               const vector<StringView>& tokens) {
+  double sum = 0.0, expected = 0.0;
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    expected += strtod(tokens[i].data(), NULL);
+  }
+  string title = string("ToDouble/") + name;
+  if (suite->Run(title.c_str(), [&]() {
+        sum = 0.0;
+        for (size_t i = 0; i < tokens.size(); ++i) {
+          double d;
+          StringConvert::ToDouble(tokens[i].data(), tokens[i].size(), &d);
+          sum += d;
+        }
+      }, text.size(), tokens.size())) {
+    CHECK_EQ(sum, expected);
+  }
+  // strtod stops at the white space after a token, since 'text' is null
+  // terminated.
+  title = string("strtod/") + name;
+  suite->Run(title.c_str(), [&]() {
+      sum = 0.0;
+      for (size_t i = 0; i < tokens.size(); ++i) {
+        sum += strtod(tokens[i].data(), NULL);
+      }
+    }, text.size(), tokens.size());
+}
+
+int main(int argc, char** argv)  {
+  CommandLineFlagsInit(&argc, &argv, true);
+  BenchmarkSuite suite("StringConvert");
+
+  // Coordinates with 6 decimals and colors.
+  string nodes =
+      FileIO::ReadWholeFileToString("TestData/Models/skull_nodes.txt");
+  vector<StringView> nodeTokens = Tokens(nodes);
+  RunDouble(&suite, "skull_nodes", nodes, nodeTokens);
+
+  // Full precision doubles, which mostly miss the exact fast path.
+  string full;
+  srand(0);
+  for (int i = 0; i < 200000; ++i) {
+    full += StringUtils::PrintfToString(
+        "%.17g\n", (rand() - RAND_MAX / 2) * 1e-3 / (1 + rand() % 1000));
+  }
+  vector<StringView> fullTokens = Tokens(full);
+  RunDouble(&suite, "17digits", full, fullTokens);
+
+  // The vertex data of a ply file as floats.
+  string ply = FileIO::ReadWholeFileToString(
+      "TestData/Models/dinoSparseRing-pmvs.ply");
+  ply = ply.substr(ply.find("end_header\n") + 11);
+  vector<StringView> plyTokens = Tokens(ply);
+  float fsum = 0.0f, fexpected = 0.0f;
+  for (size_t i = 0; i < plyTokens.size(); ++i) {
+    fexpected += strtof(plyTokens[i].data(), NULL);
+  }
+  if (suite.Run("ToFloat/dino", [&]() {
+        fsum = 0.0f;
+        for (size_t i = 0; i < plyTokens.size(); ++i) {
+          float f;
+          StringConvert::ToFloat(plyTokens[i].data(), plyTokens[i].size(), &f);
+          fsum += f;
+        }
+      }, ply.size(), plyTokens.size())) {
+    CHECK_EQ(fsum, fexpected);
+  }
+  suite.Run("strtof/dino", [&]() {
+      fsum = 0.0f;
+      for (size_t i = 0; i < plyTokens.size(); ++i) {
+        fsum += strtof(plyTokens[i].data(), NULL);
+      }
+    }, ply.size(), plyTokens.size());
+
+  // Vertex indices.
+  string edges =
+      FileIO::ReadWholeFileToString("TestData/Models/skull_edges.txt");
+  vector<StringView> edgeTokens = Tokens(edges);
+  long isum = 0, iexpected = 0;
+  for (size_t i = 0; i < edgeTokens.size(); ++i) {
+    iexpected += strtol(edgeTokens[i].data(), NULL, 10);
+  }
+  if (suite.Run("ToInt/skull_edges", [&]() {
+        isum = 0;
+        for (size_t i = 0; i < edgeTokens.size(); ++i) {
+          int n;
+          StringConvert::ToInt(edgeTokens[i].data(), edgeTokens[i].size(), &n);
+          isum += n;
+        }
+      }, edges.size(), edgeTokens.size())) {
+    CHECK_EQ(isum, iexpected);
+  }
+  suite.Run("strtol/skull_edges", [&]() {
+      isum = 0;
+      for (size_t i = 0; i < edgeTokens.size(); ++i) {
+        isum += strtol(edgeTokens[i].data(), NULL, 10);
+      }
+    }, edges.size(), edgeTokens.size());
+
+  // Formatting the full precision doubles back, and the indices.
+  vector<double> values;
+  for (size_t i = 0; i < fullTokens.size(); ++i) {
+    values.push_back(strtod(fullTokens[i].data(), NULL));
+  }
+  string text;
+  if (suite.Run("AppendDouble/17digits", [&]() {
+        text.clear();
+        for (size_t i = 0; i < values.size(); ++i) {
+          StringConvert::AppendDouble(values[i], &text);
+          text.push_back('\n');
+        }
+      }, full.size(), values.size())) {
+    CHECK(text.size() <= full.size());
+  }
+  suite.Run("snprintf/17digits", [&]() {
+      text.clear();
+      char buffer[32];
+      for (size_t i = 0; i < values.size(); ++i) {
+        text.append(buffer, snprintf(buffer, sizeof(buffer), "%.17g\n",
+                                     values[i]));
+      }
+    }, full.size(), values.size());
+  vector<long> indices;
+  for (size_t i = 0; i < edgeTokens.size(); ++i) {
+    indices.push_back(strtol(edgeTokens[i].data(), NULL, 10));
+  }
+  if (suite.Run("AppendLong/skull_edges", [&]() {
+        text.clear();
+        for (size_t i = 0; i < indices.size(); ++i) {
+          StringConvert::AppendLong(indices[i], &text);
+          text.push_back(' ');
+        }
+      }, edges.size(), indices.size())) {
+    CHECK_EQ(text.size(), edges.size());
+  }
+  suite.Run("snprintf/skull_edges", [&]() {
+      text.clear();
+      char buffer[32];
+      for (size_t i = 0; i < indices.size(); ++i) {
+        text.append(buffer, snprintf(buffer, sizeof(buffer), "%ld ",
+                                     indices[i]));
+      }
+    }, edges.size(), indices.size());
+
+  suite.Finish();
+  return 0;
+}
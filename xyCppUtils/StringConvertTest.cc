@@ -7,9 +7,21 @@
 
 #include "StringConvert.h"
 
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 
+#ifdef __USE_TR1__
+#include <tr1/cstdint>
+#else
+#include <cstdint>
+#endif
+
 #include "LogAndCheck.h"
+#include "StringUtils.h"
 #include "Timer.h"
 
 using std::string;
@@ -103,6 +115,220 @@ int main()  {
   out = StringConvert::ToDouble("", &d);
   CHECK_EQ(out, StringConvert::Inconvertible);
 
+  //==========================================================
+  // Test on StringConverter::ToDouble() with a length.
+  const char* text = "1.5e3 -0.25x";
+  out = StringConvert::ToDouble(text, 5, &d);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(d, 1.5e3);
+  out = StringConvert::ToDouble(text + 6, 5, &d);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(d, -0.25);
+  out = StringConvert::ToDouble(text + 6, 6, &d);
+  CHECK_EQ(out, StringConvert::Inconvertible);
+  out = StringConvert::ToDouble(text, 0, &d);
+  CHECK_EQ(out, StringConvert::Inconvertible);
+  out = StringConvert::ToDouble("-", 1, &d);
+  CHECK_EQ(out, StringConvert::Inconvertible);
+  out = StringConvert::ToDouble("1e", 2, &d);
+  CHECK_EQ(out, StringConvert::Inconvertible);
+  out = StringConvert::ToDouble("-0", 2, &d);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK(d == 0.0 && std::signbit(d));
+  out = StringConvert::ToDouble("1e400", 5, &d);
+  CHECK_EQ(out, StringConvert::Overflow);
+  out = StringConvert::ToDouble("inf", 3, &d);
+  CHECK_EQ(out, StringConvert::Success);
+  // Same as strtod on both the fast path and the fallback.
+  const char* samples[] = {
+    "0.1", "-123435.24122345", "9007199254740993", "1e23", "4.35e37",
+    "123456789012345678901234567890", "2.2250738585072014e-308",
+    "4.9e-324", "1.7976931348623157e308", "0.000000000000000000001",
+    "00000000000000000000000000000001.5", "3.0000000000000000000001"
+  };
+  for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i) {
+    out = StringConvert::ToDouble(samples[i], strlen(samples[i]), &d);
+    CHECK_EQ(out, StringConvert::Success);
+    CHECK_EQ(d, strtod(samples[i], NULL));
+  }
+  srand(0);
+  char buffer[64];
+  for (int i = 0; i < 100000; ++i) {
+    double x = (rand() - RAND_MAX / 2) * 1e-3 / (1 + rand() % 1000);
+    int len = snprintf(buffer, sizeof(buffer), "%.*g", 1 + i % 17, x);
+    out = StringConvert::ToDouble(buffer, len, &d);
+    CHECK_EQ(out, StringConvert::Success);
+    CHECK_EQ(d, strtod(buffer, NULL));
+  }
+  // Hard cases for Eisel-Lemire: halfway between two doubles, subnormals, and
+  // many digits where the dropped ones decide the rounding.
+  const char* hardSamples[] = {
+    "2.2250738585072011e-308", "2.2250738585072012e-308", "4.9406564584124654e-324",
+    "2.4703282292062327e-324", "2.4703282292062328e-324", "1.7976931348623158e308",
+    "9007199254740992.5", "9007199254740993.0000000000000000001",
+    "7.2057594037927933e16", "1.00000000000000011102230246251565404236316680908203125",
+    "1.00000000000000011102230246251565404236316680908203124",
+    "1.00000000000000011102230246251565404236316680908203126",
+    "8.988465674311579e307", "1e-400", "-1e-400", "123456789e-300",
+    "0.00000000000000000000000000000000000000000000000000000000001e60"
+  };
+  for (size_t i = 0; i < sizeof(hardSamples) / sizeof(hardSamples[0]); ++i) {
+    out = StringConvert::ToDouble(hardSamples[i], &d);
+    CHECK_EQ(out, StringConvert::Success);
+    CHECK_EQ(d, strtod(hardSamples[i], NULL));
+  }
+  out = StringConvert::ToDouble("-1e400", 6, &d);
+  CHECK_EQ(out, StringConvert::Underflow);
+  CHECK_EQ(d, -HUGE_VAL);
+  out = StringConvert::ToDouble("1.8e308", 7, &d);
+  CHECK_EQ(out, StringConvert::Overflow);
+  out = StringConvert::ToDouble(" 1.5", 4, &d);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(d, 1.5);
+  out = StringConvert::ToDouble("1.5\0", 4, &d);
+  CHECK_EQ(out, StringConvert::Inconvertible);
+  // Round trip of random bit patterns with 17 digits.
+  for (int i = 0; i < 100000; ++i) {
+    uint64_t bits = uint64_t(rand()) << 62 ^ uint64_t(rand()) << 31 ^ rand();
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    if (std::isnan(x))   continue;
+    int len = snprintf(buffer, sizeof(buffer), "%.17g", x);
+    out = StringConvert::ToDouble(buffer, len, &d);
+    CHECK_EQ(d, x);
+    CHECK_EQ(out, std::isinf(x) ? (x > 0 ? StringConvert::Overflow :
+                                   StringConvert::Underflow) :
+             StringConvert::Success);
+  }
+
+  //==========================================================
+  // Test on StringConverter::ToFloat().
+  float f;
+  out = StringConvert::ToFloat(string("-0.346497"), &f);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(f, -0.346497f);
+  out = StringConvert::ToFloat("3.5e38", &f);
+  CHECK_EQ(out, StringConvert::Overflow);
+  out = StringConvert::ToFloat("1e-50", &f);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(f, 0.0f);
+  out = StringConvert::ToFloat("0.5f", &f);
+  CHECK_EQ(out, StringConvert::Inconvertible);
+  // Directly rounded to float, which differs from rounding through double.
+  const char* floatSamples[] = {
+    "1.00000005960464477550", "1.4012984643e-45", "3.4028235677973366e38",
+    "7.0060e-46", "16777217", "0.1", "1.17549435e-38", "-nan", "infinity"
+  };
+  for (size_t i = 0; i < sizeof(floatSamples) / sizeof(floatSamples[0]); ++i) {
+    out = StringConvert::ToFloat(floatSamples[i], strlen(floatSamples[i]), &f);
+    CHECK_EQ(out, StringConvert::Success);
+    float expected = strtof(floatSamples[i], NULL);
+    CHECK_EQ(memcmp(&f, &expected, sizeof(f)), 0);
+  }
+  for (int i = 0; i < 100000; ++i) {
+    uint32_t bits = uint32_t(rand()) << 16 ^ rand();
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    if (std::isnan(x) || std::isinf(x))   continue;
+    int len = snprintf(buffer, sizeof(buffer), "%.9g", x);
+    out = StringConvert::ToFloat(buffer, len, &f);
+    CHECK_EQ(out, StringConvert::Success);
+    CHECK_EQ(f, x);
+  }
+
+  //==========================================================
+  // Test on StringConverter::ToInt() and ToLong() with a length.
+  out = StringConvert::ToInt("2147483647", 10, &i);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(i, 2147483647);
+  out = StringConvert::ToInt("-2147483648", 11, &i);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(i, INT_MIN);
+  out = StringConvert::ToInt("2147483648", 10, &i);
+  CHECK_EQ(out, StringConvert::Overflow);
+  out = StringConvert::ToInt("-2147483649", 11, &i);
+  CHECK_EQ(out, StringConvert::Underflow);
+  out = StringConvert::ToInt("12 34", 2, &i);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(i, 12);
+  out = StringConvert::ToInt("12 34", 3, &i);
+  CHECK_EQ(out, StringConvert::Inconvertible);
+  out = StringConvert::ToInt("017", 3, &i);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(i, 017);
+  out = StringConvert::ToLong("9223372036854775807", 19, &l);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(l, LONG_MAX);
+  out = StringConvert::ToLong("-9223372036854775808", 20, &l);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(l, LONG_MIN);
+  out = StringConvert::ToLong("9223372036854775808", 19, &l);
+  CHECK_EQ(out, StringConvert::Overflow);
+  out = StringConvert::ToLong("-9223372036854775809", 20, &l);
+  CHECK_EQ(out, StringConvert::Underflow);
+  out = StringConvert::ToLong("+0x10", 5, &l);
+  CHECK_EQ(out, StringConvert::Success);
+  CHECK_EQ(l, 16);
+  for (int k = 0; k < 100000; ++k) {
+    long x = long(uint64_t(rand()) << 33 ^ uint64_t(rand()) << 2 ^ rand());
+    int len = snprintf(buffer, sizeof(buffer), "%ld", x);
+    out = StringConvert::ToLong(buffer, len, &l);
+    CHECK_EQ(out, StringConvert::Success);
+    CHECK_EQ(l, x);
+  }
+
+  //==========================================================
+  // Test on StringConverter::FormatDouble() and FormatLong().
+  const double doubles[] = {
+    0.0, -0.0, 1.0, 0.1, -2.5, 100.0, 1e16, 1e17, 1.5e-5, 1e-4, 1e23,
+    1.0 / 3, 5e-324, 1.7976931348623157e308, 123456.789, -HUGE_VAL
+  };
+  const char* formatted[] = {
+    "0", "-0", "1", "0.1", "-2.5", "100", "10000000000000000", "1e+17",
+    "1.5e-05", "0.0001", "1e+23", "0.3333333333333333", "5e-324",
+    "1.7976931348623157e+308", "123456.789", "-inf"
+  };
+  for (size_t i = 0; i < sizeof(doubles) / sizeof(doubles[0]); ++i) {
+    int len = StringConvert::FormatDouble(doubles[i], buffer) - buffer;
+    CHECK_EQ(string(buffer, len), string(formatted[i]));
+  }
+  string str = "x=";
+  StringConvert::AppendDouble(std::nan(""), &str);
+  str += ",";
+  StringConvert::AppendLong(LONG_MIN, &str);
+  CHECK_EQ(str, string("x=nan,-9223372036854775808"));
+  // Shortest round trip, i.e. never more digits than the shortest "%.*e".
+  for (int i = 0; i < 20000; ++i) {
+    uint64_t bits = uint64_t(rand()) << 62 ^ uint64_t(rand()) << 31 ^ rand();
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    if (std::isnan(x) || std::isinf(x))   continue;
+    int len = StringConvert::FormatDouble(x, buffer) - buffer;
+    CHECK_LE(len, StringConvert::kMaxDoubleChars);
+    CHECK_EQ(StringConvert::ToDoubleAndCheck(string(buffer, len)), x);
+    // The significant digits, without the zeros of the fixed point layout.
+    string digits;
+    for (int k = 0; k < len && buffer[k] != 'e'; ++k) {
+      if (buffer[k] >= '0' && buffer[k] <= '9')   digits += buffer[k];
+    }
+    digits.erase(0, digits.find_first_not_of('0'));
+    if (!memchr(buffer, '.', len) && !memchr(buffer, 'e', len)) {
+      digits.erase(digits.find_last_not_of('0') + 1);
+    }
+    int precision = 1;
+    for (; precision < 17; ++precision) {
+      char shortest[32];
+      snprintf(shortest, sizeof(shortest), "%.*e", precision - 1, x);
+      if (strtod(shortest, NULL) == x)   break;
+    }
+    CHECK_LE(int(digits.size()), precision);
+  }
+  for (int k = 0; k < 100000; ++k) {
+    long x = long(uint64_t(rand()) << 33 ^ uint64_t(rand()) << 2 ^ rand());
+    int len = StringConvert::FormatLong(x, buffer) - buffer;
+    CHECK_EQ(string(buffer, len), StringUtils::PrintfToString("%ld", x));
+  }
+
   LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
   return 0;
 }
@@ -8,6 +8,7 @@
 #include "StringUtils.h"
 
 #include <cstdarg>
+#include <cstdio>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -18,152 +19,236 @@ using namespace std;
 namespace xyUtils  {
 namespace StringUtils {
 
-vector<string> Split(const char* str) {
-  vector<string> parts;
-  bool newPart = true;
-  for (const char* s = str; *s != 0; ++s) {
-    if (isspace(*s)) {
-      newPart = true;
-    } else {
-      if (newPart)        parts.push_back(string());
-      parts.back().push_back(*s);
-      newPart = false;
-    }
-  }
-  return parts;
+namespace {
+template <typename SepType>
+size_t SplitToViewsHelper(StringView text, const SepType& sep,
+                          vector<StringView>* tokens) {
+  tokens->clear();
+  Tokenizer tokenizer(text, sep);
+  StringView token;
+  while (tokenizer.Next(&token))   tokens->push_back(token);
+  return tokens->size();
 }
 
-vector<string> Split(const char* str, char sep,
-                               int maxSplit, bool discardRest) {
+// Split by 'Tokenizer(str, sep)', with the 'maxSplit' and 'discardRest'
+// semantics described in the header.
+template <typename SepType>
+vector<string> SplitHelper(const char* str, const SepType& sep,
+                           int maxSplit, bool discardRest) {
+  StringView text(str);
+  Tokenizer tokenizer(text, sep);
   vector<string> parts;
-  bool newPart = true;
-  const char* s;
-  for (s = str; *s != 0; ++s) {
-    if (newPart) {
-      newPart = false;
-      if (int(parts.size()) == maxSplit) break;
+  StringView token;
+  while (tokenizer.Next(&token)) {
+    // The empty token at the end of the text is always kept.
+    if (token.begin() == text.end()) {
       parts.push_back(string());
+      return parts;
     }
-    if (*s == sep) {
-      newPart = true;
-    } else {
-      parts.back().push_back(*s);
+    if (int(parts.size()) == maxSplit) {
+      if (!discardRest) {
+        parts.push_back(string(token.begin(), text.end() - token.begin()));
+      }
+      return parts;
     }
+    parts.push_back(token.ToString());
   }
-  if (int(parts.size())==maxSplit && !discardRest) {
+  if (int(parts.size()) == maxSplit && !discardRest) {
     parts.push_back(string());
-    for (; *s != 0; ++s) {
-      parts.back().push_back(*s);
-    }
-  } else {
-    if (newPart) parts.push_back(string());
   }
   return parts;
 }
+}   // namespace
 
-vector<string> Split(const char* str, const char* sep,
-                               int maxSplit, bool discardRest) {
-  vector<string> parts;
-  bool newPart = true;
-  const char* s;
-  size_t sepLen = strlen(sep);
-  for (s = str; *s != 0; ++s) {
-    if (newPart) {
-      newPart = false;
-      if (int(parts.size()) == maxSplit) break;
-      parts.push_back(string());
-    }
-    if (strncmp(s, sep, sepLen) == 0) {
-      newPart = true;
-      s += sepLen-1;
-    } else {
-      parts.back().push_back(*s);
-    }
+Tokenizer::Tokenizer(StringView text, StringView sep)
+    : pos_(text.begin()), end_(text.end()), sep_(sep.data()),
+      sepLen_(sep.size()), sepChar_('\0'), done_(false) {
+  CHECK(!sep.empty());
+}
+
+bool Tokenizer::Next(StringView* token) {
+  if (sepLen_ == 0) {
+    while (pos_ < end_ && IsWhiteSpace(*pos_))   ++pos_;
+    if (pos_ == end_)   return false;
+    const char* begin = pos_;
+    while (pos_ < end_ && !IsWhiteSpace(*pos_))   ++pos_;
+    *token = StringView(begin, pos_ - begin);
+    return true;
   }
-  if (int(parts.size())==maxSplit && !discardRest) {
-    parts.push_back(string());
-    for (; *s != 0; ++s) {
-      parts.back().push_back(*s);
-    }
+  if (done_)   return false;
+  const char* sepPos = sep_ ?
+      static_cast<const char*>(memmem(pos_, end_ - pos_, sep_, sepLen_)) :
+      static_cast<const char*>(memchr(pos_, sepChar_, end_ - pos_));
+  if (sepPos) {
+    *token = StringView(pos_, sepPos - pos_);
+    pos_ = sepPos + sepLen_;
   } else {
-    if (newPart) parts.push_back(string());
+    *token = StringView(pos_, end_ - pos_);
+    pos_ = end_;
+    done_ = true;
   }
+  return true;
+}
+
+size_t SplitToViews(StringView text, vector<StringView>* tokens) {
+  tokens->clear();
+  Tokenizer tokenizer(text);
+  StringView token;
+  while (tokenizer.Next(&token))   tokens->push_back(token);
+  return tokens->size();
+}
+
+size_t SplitToViews(StringView text, char sep, vector<StringView>* tokens) {
+  return SplitToViewsHelper(text, sep, tokens);
+}
+
+size_t SplitToViews(StringView text, StringView sep,
+                    vector<StringView>* tokens) {
+  return SplitToViewsHelper(text, sep, tokens);
+}
+
+vector<string> Split(const char* str) {
+  vector<string> parts;
+  Tokenizer tokenizer(str);
+  StringView token;
+  while (tokenizer.Next(&token))   parts.push_back(token.ToString());
   return parts;
 }
 
-void StripWhiteSpace(string* str) {
-  int i;
-  for (i = 0; i < int(str->size()); ++i) {
-    if (!isspace(str->at(i))) break;
-  }
-  if (i == int(str->size())) {
-    str->clear();
-    return;
-  } else if (i > 0) {
-    str->erase(0, i);
-  }
+vector<string> Split(const char* str, char sep,
+                               int maxSplit, bool discardRest) {
+  return SplitHelper(str, sep, maxSplit, discardRest);
+}
 
-  for (i = str->size()-1; i >= 0; --i) {
-    if (!isspace(str->at(i))) break;
-  }
-  CHECK_GT(i, 0);
-  str->resize(i+1);
-}
-
-static void StripCommentsHelper(string* str,
-                                const string& startTag,
-                                const string& endTag,
-                                bool startInclude,
-                                bool endInclude) {
-  size_t startPos = str->find(startTag) + (startInclude ? 0 : startTag.size());
-  while (startPos != string::npos) {
-    size_t endPos = str->find(endTag);
-    if (endPos == string::npos) {
-      if (endInclude) {
-        LOG(FATAL) << "Incomplete comment in string\n" << *str;
-      } else {
-        str->resize(startPos);
+vector<string> Split(const char* str, const char* sep,
+                               int maxSplit, bool discardRest) {
+  return SplitHelper(str, StringView(sep), maxSplit, discardRest);
+}
+
+void CommentFilter::Filter(StringView in, string* out) {
+  const char* p = in.begin();
+  const char* end = in.end();
+  while (p < end) {
+    switch (state_) {
+      case kCode: {
+        const char* q = static_cast<const char*>(memchr(p, opener_, end - p));
+        if (!q) {
+          out->append(p, end - p);
+          return;
+        }
+        out->append(p, q - p);
+        p = q + 1;
+        state_ = style_ == ShellComment ? kLineComment : kSlash;
+        break;
       }
-    } else {
-      str->erase(startPos, endPos - startPos + (endInclude ? endTag.size() : 0));
+      case kSlash:
+        if (*p == '*') {
+          ++p;
+          state_ = kBlockComment;
+        } else if (*p == '/' && style_ == CppComment) {
+          ++p;
+          state_ = kLineComment;
+        } else {
+          out->push_back('/');
+          state_ = kCode;
+        }
+        break;
+      case kLineComment: {
+        // The '\n' is kept.
+        const char* q = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!q)   return;
+        p = q;
+        state_ = kCode;
+        break;
+      }
+      case kBlockComment: {
+        const char* q = static_cast<const char*>(memchr(p, '*', end - p));
+        if (!q)   return;
+        p = q + 1;
+        state_ = kBlockStar;
+        break;
+      }
+      case kBlockStar:
+        if (*p == '/') {
+          state_ = kCode;
+        } else if (*p != '*') {
+          state_ = kBlockComment;
+        }
+        ++p;
+        break;
     }
-    startPos = str->find(startTag, startPos);
   }
 }
-                                
 
-void StripComments(string* str, CommentStyle style) {
-  switch (style) {
-    case CComment:
-      StripCommentsHelper(str, "/*", "*/", true, true);
-      break;
-    case CppComment:
-      StripCommentsHelper(str, "/*", "*/", true, true);
-      StripCommentsHelper(str, "//", "\n", true, false);
-      break;
-    case ShellComment:
-      StripCommentsHelper(str, "#", "\n", true, false);
-      break;
-    default:
-      LOG(FATAL) << "Internal error: should not get here!";
+void CommentFilter::Finish(string* out) {
+  if (state_ == kSlash) {
+    out->push_back('/');
+  } else if (state_ == kBlockComment || state_ == kBlockStar) {
+    LOG(FATAL) << "Incomplete comment at the end of the text.";
   }
+  state_ = kCode;
+}
+
+StringView StripWhiteSpace(StringView text) {
+  const char* begin = text.begin();
+  const char* end = text.end();
+  while (begin < end && IsWhiteSpace(*begin))   ++begin;
+  while (end > begin && IsWhiteSpace(end[-1]))   --end;
+  return StringView(begin, end - begin);
+}
+
+void StripWhiteSpace(string* str) {
+  StringView stripped = StripWhiteSpace(StringView(*str));
+  size_t begin = stripped.begin() - str->data();
+  str->resize(begin + stripped.size());
+  str->erase(0, begin);
+}
+
+void StripComments(string* str, CommentStyle style) {
+  CommentFilter filter(style);
+  string out;
+  out.reserve(str->size());
+  filter.Filter(*str, &out);
+  filter.Finish(&out);
+  str->swap(out);
 }
 
 string PrintfToString(const char* format, ...) {
-  // Get number of characters that should be written.
+  // Most strings fit in the stack buffer in a single pass.
+  char buffer[256];
   va_list args;
   va_start(args, format);
-  int nWrite = vsnprintf(NULL, 0, format, args);
-  CHECK(nWrite >= 0);
+  int nWrite = vsnprintf(buffer, sizeof(buffer), format, args);
   va_end(args);
-  // Allocate memeory and print the string.
-  char* tmp = new char[nWrite+1];
+  CHECK(nWrite >= 0);
+  if (nWrite < int(sizeof(buffer)))   return string(buffer, nWrite);
+  // Otherwise print again to a string of the right size.
+  string str(nWrite, '\0');
   va_start(args, format);
-  nWrite = vsnprintf(tmp, nWrite+1, format, args);
+  vsnprintf(&str[0], nWrite + 1, format, args);
   va_end(args);
-  string str(tmp);
-  delete[] tmp;
   return str;
 }
+
+string JsonQuote(StringView str) {
+  string out;
+  out.reserve(str.size() + 2);
+  out += '"';
+  for (size_t i = 0; i < str.size(); ++i) {
+    char c = str[i];
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buffer[8];
+      snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+      out += buffer;
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+  return out;
+}
 }   // namespace StringUtils
 }   // namespace xyUtils
@@ -11,6 +11,8 @@
 #include <string>
 #include <vector>
 
+#include "StringView.h"
+
 namespace xyUtils  {
 namespace StringUtils {
 
@@ -21,6 +23,92 @@ enum CommentStyle {
   ShellComment    // Everything between # and \n, including # but not \n.
 };
 
+// Strip the comments of a text given in chunks, e.g. read from a file, keeping
+// only a constant amount of state between the chunks, such that comments (and
+// their openers such as "/*") may span several chunks. The output is the same
+// as that of 'StripComments' on the whole text. Example usage:
+//   StringUtils::CommentFilter filter(StringUtils::CppComment);
+//   std::string out;
+//   while (ReadChunk(&chunk)) {
+//     filter.Filter(chunk, &out);
+//     /* Consume 'out', e.g. its complete lines, and clear it. */
+//   }
+//   filter.Finish(&out);
+// The comment openers and ends are searched with memchr, which is vectorized in
+// common C libraries, and the text between them is appended in one piece.
+class CommentFilter {
+ public:
+  explicit CommentFilter(CommentStyle style)
+      : style_(style), opener_(style == ShellComment ? '#' : '/'),
+        state_(kCode) { }
+
+  // Append the next chunk 'in' without the comments to 'out'.
+  void Filter(StringView in, std::string* out);
+  // End of the text, which may not be inside a C comment. The filter could be
+  // reused for another text after this.
+  void Finish(std::string* out);
+ private:
+  enum State {
+    kCode,
+    kSlash,           // After a '/' that may start a comment, not written yet.
+    kLineComment,
+    kBlockComment,
+    kBlockStar        // After a '*' in a block comment.
+  };
+  CommentStyle style_;
+  char opener_;
+  State state_;
+};
+
+// Split a text into tokens without allocating, yielding views into the text,
+// which must outlive the tokenizer and the tokens. Example usage:
+//   StringUtils::Tokenizer tokenizer(line, ',');
+//   StringView token;
+//   while (tokenizer.Next(&token)) {
+//     Process(token);
+//   }
+// Separator characters and strings are searched with memchr and memmem, which
+// are vectorized in common C libraries.
+class Tokenizer {
+ public:
+  // Split at runs of white space, without empty tokens.
+  explicit Tokenizer(StringView text)
+      : pos_(text.begin()), end_(text.end()), sep_(NULL), sepLen_(0),
+        sepChar_('\0'), done_(false) { }
+  // Split at each 'sep', keeping empty tokens, i.e. n separators give n+1
+  // tokens. 'sep' must not be empty.
+  Tokenizer(StringView text, char sep)
+      : pos_(text.begin()), end_(text.end()), sep_(NULL), sepLen_(1),
+        sepChar_(sep), done_(false) { }
+  Tokenizer(StringView text, StringView sep);
+
+  // Get the next token, or return false if there is none.
+  bool Next(StringView* token);
+  // The text after the last token and the separator following it.
+  StringView rest() const { return StringView(pos_, end_ - pos_); }
+ private:
+  const char* pos_;
+  const char* end_;
+  const char* sep_;     // NULL if splitting at white space or 'sepChar_'.
+  size_t sepLen_;       // 0 if splitting at white space.
+  char sepChar_;
+  bool done_;           // Whether the token at the end has been yielded.
+};
+
+// Split 'text' into 'tokens', which is cleared first and keeps its capacity
+// such that reusing it does not allocate in steady state. The separators are
+// the same as those of 'Tokenizer'. Return the number of tokens.
+size_t SplitToViews(StringView text, std::vector<StringView>* tokens);
+size_t SplitToViews(StringView text, char sep,
+                    std::vector<StringView>* tokens);
+size_t SplitToViews(StringView text, StringView sep,
+                    std::vector<StringView>* tokens);
+
+// Whether 'c' is white space in the "C" locale.
+inline bool IsWhiteSpace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
 // Return a list of the words in the string 'str', using whitespace as the
 // delimiter. Empty strings are removed from the results.
 std::vector<std::string> Split(const char* str);
@@ -30,10 +118,12 @@ inline std::vector<std::string> Split(const std::string& str) {
 
 // Return a list of the words in the string 'str', using 'sep' as the delimiter.
 // If maxSplit >= 0, at most 'maxSplit' splits are done, default {-1}.
-// If 'discardRest' is true, the size of result vector is at most maxSplit+1 with
-// the last element the rest of the string not splitted yet (if any);
-// If 'discardRest' is false, the size of result vector is at most maxSplit, and
+// If 'discardRest' is false, the size of result vector is at most maxSplit+1
+// with the last element the rest of the string not splitted yet (if any);
+// If 'discardRest' is true, the size of result vector is at most maxSplit, and
 // the rest of the string is discarded. Default {false}.
+// These allocate a string per token, see 'Tokenizer' and 'SplitToViews' for
+// the alternatives without allocation.
 std::vector<std::string> Split(const char* str, char sep,
                                int maxSplit=-1, bool discardRest=false);
 std::vector<std::string> Split(const char* str, const char* sep,
@@ -47,14 +137,21 @@ std::vector<std::string> Split(const std::string& str, const T& sep,
 // Strip the white space in front and at the end of the string.
 // E.g. "\t  abc def 123 456  \t  \n" ===> "abc def 123 456"
 void StripWhiteSpace(std::string* str);
+// Same as above, returning the view of 'text' without copying.
+StringView StripWhiteSpace(StringView text);
 
-// Strip all text in comments.
+// Strip all text in comments, in linear time (see also 'CommentFilter').
 void StripComments(std::string* str, CommentStyle style);
 
 // Print formatted data to a string. This function is safe (no memory leak or
-// overflow), but not necessarily efficient.
+// overflow), but not necessarily efficient. To format many numbers, e.g. the
+// lines of a text file, use StringConvert::AppendDouble/AppendLong instead.
 std::string PrintfToString(const char* format, ...);
 
+// Quote 'str' as a JSON string literal, escaping '"', '\\' and the control
+// characters, e.g. a"b ===> "a\"b".
+std::string JsonQuote(StringView str);
+
 }   // namespace StringUtils
 }   // namespace xyUtils
 
@@ -0,0 +1,116 @@
+/**
+  * Benchmarks for string utilities.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "StringUtils.h"
+
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CommandLineFlags.h"
+#include "FileIO.h"
+#include "LogAndCheck.h"
+#include "StringView.h"
+
+using namespace std;
+using namespace xyUtils;
+
+int main(int argc, char** argv)  {
+  CommandLineFlagsInit(&argc, &argv, true);
+  BenchmarkSuite suite("StringUtils");
+
+  // The lines of the test data, split into tokens in different ways.
+  FileIO::MappedFile file("TestData/Models/skull_nodes.txt");
+  vector<string> lines;
+  FileIO::LineIterator it(file);
+  StringView line;
+  while (it.Next(&line))   lines.push_back(line.ToString());
+  double bytes = file.size();
+  size_t numTokens = 0;
+  for (size_t i = 0; i < lines.size(); ++i) {
+    numTokens += StringUtils::Split(lines[i]).size();
+  }
+
+  size_t total = 0;
+  if (suite.Run("Split/WhiteSpace", [&]() {
+        total = 0;
+        for (size_t i = 0; i < lines.size(); ++i) {
+          total += StringUtils::Split(lines[i]).size();
+        }
+      }, bytes, numTokens)) {
+    CHECK_EQ(total, numTokens);
+  }
+  vector<StringView> views;
+  if (suite.Run("SplitToViews/WhiteSpace", [&]() {
+        total = 0;
+        for (size_t i = 0; i < lines.size(); ++i) {
+          total += StringUtils::SplitToViews(lines[i], &views);
+        }
+      }, bytes, numTokens)) {
+    CHECK_EQ(total, numTokens);
+  }
+  if (suite.Run("Tokenizer/WhiteSpace", [&]() {
+        total = 0;
+        for (size_t i = 0; i < lines.size(); ++i) {
+          StringUtils::Tokenizer tokenizer(lines[i]);
+          StringView token;
+          while (tokenizer.Next(&token))   ++total;
+        }
+      }, bytes, numTokens)) {
+    CHECK_EQ(total, numTokens);
+  }
+
+  // Comma separated values.
+  string csv;
+  for (int i = 0; i < 100000; ++i) {
+    csv += StringUtils::PrintfToString("%d,name_%d,%.6f,,", i, i, i * 0.5);
+  }
+  double csvTokens = 100000 * 4 + 1;
+  suite.Run("Split/Char", [&]() {
+      total = StringUtils::Split(csv, ',').size();
+    }, csv.size(), csvTokens);
+  suite.Run("SplitToViews/Char", [&]() {
+      total = StringUtils::SplitToViews(csv, ',', &views);
+    }, csv.size(), csvTokens);
+  suite.Run("Split/String", [&]() {
+      total = StringUtils::Split(csv, ",,").size();
+    }, csv.size());
+  suite.Run("SplitToViews/String", [&]() {
+      total = StringUtils::SplitToViews(csv, StringView(",,"), &views);
+    }, csv.size());
+
+  // Comment heavy text, e.g. an annotated list.
+  string annotated;
+  for (int i = 0; i < 100000; ++i) {
+    annotated += StringUtils::PrintfToString(
+        "camera_%d 1.5 2.5 /* focal, center */ // camera %d\n", i, i);
+  }
+  string stripped;
+  suite.Run("StripComments/Cpp", [&]() {
+      stripped = annotated;
+      StringUtils::StripComments(&stripped, StringUtils::CppComment);
+    }, annotated.size());
+  const size_t kChunkSize = 1 << 16;
+  string out;
+  if (suite.Run("CommentFilter/Cpp/64KB chunks", [&]() {
+        StringUtils::CommentFilter filter(StringUtils::CppComment);
+        total = 0;
+        for (size_t i = 0; i < annotated.size(); i += kChunkSize) {
+          out.clear();
+          filter.Filter(StringView(annotated).substr(i, kChunkSize), &out);
+          total += out.size();
+        }
+        out.clear();
+        filter.Finish(&out);
+        total += out.size();
+      }, annotated.size())) {
+    CHECK_EQ(total, stripped.size());
+  }
+
+  suite.Finish();
+  return 0;
+}
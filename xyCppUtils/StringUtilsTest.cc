@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "LogAndCheck.h"
+#include "StringView.h"
 #include "Timer.h"
 
 using namespace std;
@@ -56,6 +57,60 @@ int main()  {
   CHECK_EQ(parts[3], "123\n456\n");
   CHECK_EQ(parts[4], "");
 
+  // Edge cases of the separator and 'maxSplit'.
+  parts = StringUtils::Split("", '#');
+  CHECK_EQ(parts.size(), 1);
+  CHECK_EQ(parts[0], "");
+  parts = StringUtils::Split("a#", '#', 2);
+  CHECK_EQ(parts.size(), 2);
+  CHECK_EQ(parts[1], "");
+  parts = StringUtils::Split("a", '#', 1);
+  CHECK_EQ(parts.size(), 2);
+  CHECK_EQ(parts[1], "");
+  parts = StringUtils::Split("a#b#c", "#", 0);
+  CHECK_EQ(parts.size(), 1);
+  CHECK_EQ(parts[0], "a#b#c");
+
+  // Test on Tokenizer, which yields views into the text.
+  str = "  ab\tc \n d ";
+  StringUtils::Tokenizer tokenizer(str);
+  StringView token;
+  CHECK(tokenizer.Next(&token));
+  CHECK(token == "ab");
+  CHECK_EQ(token.data(), str.data() + 2);
+  CHECK(tokenizer.Next(&token));
+  CHECK(token == "c");
+  CHECK(tokenizer.rest() == " \n d ");
+  CHECK(tokenizer.Next(&token));
+  CHECK(token == "d");
+  CHECK(!tokenizer.Next(&token));
+  CHECK(!tokenizer.Next(&token));
+  str = "1,,22,";
+  StringUtils::Tokenizer commaTokenizer(str, ',');
+  const char* expected[] = {"1", "", "22", ""};
+  for (int i = 0; i < 4; ++i) {
+    CHECK(commaTokenizer.Next(&token));
+    CHECK(token == expected[i]);
+  }
+  CHECK(!commaTokenizer.Next(&token));
+  StringUtils::Tokenizer emptyTokenizer("", ',');
+  CHECK(emptyTokenizer.Next(&token));
+  CHECK(token.empty());
+  CHECK(!emptyTokenizer.Next(&token));
+
+  // Test on SplitToViews, which reuses the output storage.
+  vector<StringView> views;
+  CHECK_EQ(StringUtils::SplitToViews("\t abc  \t def\n\n123\n", &views), 3);
+  CHECK(views[2] == "123");
+  const StringView* storage = views.data();
+  CHECK_EQ(StringUtils::SplitToViews("x y", &views), 2);
+  CHECK_EQ(views.data(), storage);
+  CHECK_EQ(StringUtils::SplitToViews("aDELbDELDEL", StringView("DEL"),
+                                     &views), 4);
+  CHECK(views[1] == "b");
+  CHECK(views[2].empty() && views[3].empty());
+  CHECK_EQ(StringUtils::SplitToViews("a b", ' ', &views), 2);
+
   // Test on StripWhiteSpace.
   str = "\t  abc def 123 456  \t  \n";
   StringUtils::StripWhiteSpace(&str);
@@ -74,11 +129,65 @@ int main()  {
   StringUtils::StripComments(&str, StringUtils::ShellComment);
   CHECK_EQ(str, "Test on \n Shell comments. ");
 
+  str = "a";
+  StringUtils::StripWhiteSpace(&str);
+  CHECK_EQ(str, "a");
+  str = " \t\n";
+  StringUtils::StripWhiteSpace(&str);
+  CHECK_EQ(str, "");
+  CHECK(StringUtils::StripWhiteSpace(StringView("  x y\r\n")) == "x y");
+
+  str = "a / b // c /* d\n e /* f // g \n h */ i/";
+  StringUtils::StripComments(&str, StringUtils::CppComment);
+  CHECK_EQ(str, "a / b \n e  i/");
+  str = "a\n# b\n c # d\n";
+  StringUtils::StripComments(&str, StringUtils::ShellComment);
+  CHECK_EQ(str, "a\n\n c \n");
+  str = "a /*/ b **/ c // d";
+  StringUtils::StripComments(&str, StringUtils::CComment);
+  CHECK_EQ(str, "a  c // d");
+
+  // Test on CommentFilter, which gives the same result with the text split into
+  // chunks anywhere, e.g. inside "/*" and "*/".
+  const string text = "x = 1; /* multi\n line **/ y = 2 / 3; // end\n"
+      "# shell\n/* a */ /b/c//\n*/ /";
+  const StringUtils::CommentStyle styles[] = {
+    StringUtils::CppComment, StringUtils::ShellComment
+  };
+  for (int k = 0; k < 2; ++k) {
+    string whole = text.substr(0, text.size() - (k == 0 ? 4 : 0));
+    string expected = whole;
+    StringUtils::StripComments(&expected, styles[k]);
+    StringUtils::CommentFilter filter(styles[k]);
+    for (size_t i = 0; i <= whole.size(); ++i) {
+      for (size_t j = i; j <= whole.size(); j += 3) {
+        string out;
+        filter.Filter(StringView(whole).substr(0, i), &out);
+        filter.Filter(StringView(whole).substr(i, j - i), &out);
+        filter.Filter(StringView(whole).substr(j), &out);
+        filter.Finish(&out);
+        CHECK_EQ(out, expected);
+      }
+    }
+  }
+  StringUtils::CommentFilter filter(StringUtils::CppComment);
+  str.clear();
+  for (size_t i = 0; i < text.size(); ++i) {
+    filter.Filter(StringView(&text[i], 1), &str);
+  }
+  CHECK_EQ(str, "x = 1;  y = 2 / 3; \n# shell\n /b/c\n*/ ");
+
   // Test on PrintfToString.
   str = StringUtils::PrintfToString("abc %d xyz %.02f %c %s",
                                     1, 2.34, 'p', "qrst");
   CHECK_EQ(str, string("abc 1 xyz 2.34 p qrst\0"));
 
+  // Test on JsonQuote.
+  CHECK_EQ(StringUtils::JsonQuote("a/b"), "\"a/b\"");
+  CHECK_EQ(StringUtils::JsonQuote("say \"hi\"\\\n\t"),
+           "\"say \\\"hi\\\"\\\\\\u000a\\u0009\"");
+  CHECK_EQ(StringUtils::JsonQuote(""), "\"\"");
+
   LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
   return 0;
 }
@@ -0,0 +1,62 @@
+/**
+  * A non-owning view of a sequence of characters, i.e. a (pointer, length) pair
+  * into a buffer owned by someone else (e.g. a 'FileIO::MappedFile'). The view
+  * is only valid while the buffer is alive and unchanged.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#ifndef __XYUTILS_STRING_VIEW_H__
+#define __XYUTILS_STRING_VIEW_H__
+
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace xyUtils  {
+
+class StringView {
+ public:
+  StringView() : data_(NULL), size_(0) { }
+  StringView(const char* data, size_t size) : data_(data), size_(size) { }
+  StringView(const char* str) : data_(str), size_(strlen(str)) { }
+  StringView(const std::string& str) : data_(str.data()), size_(str.size()) { }
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const char* begin() const { return data_; }
+  const char* end() const { return data_ + size_; }
+  char operator[](size_t i) const { return data_[i]; }
+
+  // The view of at most 'n' characters starting at 'pos' (pos <= size()).
+  StringView substr(size_t pos, size_t n = std::string::npos) const {
+    return StringView(data_ + pos, n < size_ - pos ? n : size_ - pos);
+  }
+  // Position of the first 'c' at or after 'pos', or std::string::npos.
+  size_t find(char c, size_t pos = 0) const {
+    if (pos >= size_)   return std::string::npos;
+    const void* p = memchr(data_ + pos, c, size_ - pos);
+    return p ? static_cast<const char*>(p) - data_ : std::string::npos;
+  }
+
+  std::string ToString() const { return std::string(data_, size_); }
+
+  bool operator==(const StringView& other) const {
+    return size_ == other.size_ &&
+        (size_ == 0 || memcmp(data_, other.data_, size_) == 0);
+  }
+  bool operator!=(const StringView& other) const { return !(*this == other); }
+ private:
+  const char* data_;
+  size_t size_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const StringView& view) {
+  return os.write(view.data(), view.size());
+}
+
+}   // namespace xyUtils
+
+#endif   // __XYUTILS_STRING_VIEW_H__
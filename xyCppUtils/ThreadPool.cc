@@ -0,0 +1,225 @@
+/**
+  * A work-stealing thread pool with parallel for loops.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "CommandLineFlags.h"
+#include "LogAndCheck.h"
+
+DEFINE_FLAG_int(num_threads, 0, "Number of threads used by the library, 0 for "
+                "all the available hardware threads.");
+
+namespace xyUtils  {
+
+// A running 'ParallelFor'.
+struct ThreadPool::Job {
+  const ParallelForBody* body;
+  int grainSize;
+  // Number of indices not yet processed.
+  std::atomic<int> remaining;
+};
+
+namespace {
+// The pool and the index of the worker running on this thread, if any.
+thread_local const ThreadPool* workerPool = NULL;
+thread_local int workerIndex = -1;
+
+// Number of times a thread waiting for its 'ParallelFor' yields without
+// finding a task, before it blocks until the job is done or a task is queued.
+const int kSpinsBeforeWait = 64;
+
+// The pools of 'ParallelForOnThreads' by their number of threads, created on
+// first use and never destroyed, as the default pool.
+ThreadPool& PoolOfSize(int numThreads) {
+  static std::mutex mutex;
+  static std::map<int, ThreadPool*> pools;
+  std::lock_guard<std::mutex> lock(mutex);
+  ThreadPool*& pool = pools[numThreads];
+  if (!pool)   pool = new ThreadPool(numThreads);
+  return *pool;
+}
+}   // namespace
+
+ThreadPool::ThreadPool(int numThreads) : numQueued_(0), stop_(false) {
+  if (numThreads <= 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (int i = 0; i < numThreads; ++i) {
+    queues_.push_back(new TaskQueue);
+  }
+  for (int i = 0; i < numThreads - 1; ++i) {
+    workers_.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    stop_ = true;
+  }
+  wakeUp_.notify_all();
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i].join();
+  }
+  for (size_t i = 0; i < queues_.size(); ++i) {
+    delete queues_[i];
+  }
+}
+
+void ThreadPool::ParallelFor(int begin, int end, int grainSize,
+                             const ParallelForBody& body) {
+  if (begin >= end)   return;
+  CHECK_GT(grainSize, 0);
+  if (workers_.empty() || end - begin <= grainSize) {
+    for (int b = begin; b < end; b += grainSize) {
+      body(b, std::min(b + grainSize, end));
+    }
+    return;
+  }
+  Job job;
+  job.body = &body;
+  job.grainSize = grainSize;
+  job.remaining = end - begin;
+  TaskQueue* queue = OwnQueue();
+  Task task = {&job, begin, end};
+  Run(queue, task);
+  // Help with the pending tasks (of this or any other job) until all the
+  // sub-ranges of this job are done. When there is nothing to help with, e.g.
+  // while another thread runs a long last sub-range, block rather than spin.
+  int spins = 0;
+  while (job.remaining > 0) {
+    if (GetTask(queue, &task)) {
+      Run(queue, task);
+      spins = 0;
+    } else if (++spins < kSpinsBeforeWait) {
+      std::this_thread::yield();
+    } else {
+      std::unique_lock<std::mutex> lock(sleepMutex_);
+      while (job.remaining > 0 && numQueued_ == 0)   wakeUp_.wait(lock);
+      spins = 0;
+    }
+  }
+}
+
+ThreadPool& ThreadPool::Default() {
+  // Never destroyed, so that a thread calling 'exit' (e.g. by LOG(FATAL)) does
+  // not wait for the workers.
+  static ThreadPool* pool = new ThreadPool(FLAGS_num_threads);
+  return *pool;
+}
+
+void ThreadPool::WorkerLoop(int index) {
+  workerPool = this;
+  workerIndex = index;
+  TaskQueue* queue = queues_[index];
+  Task task;
+  while (true) {
+    if (GetTask(queue, &task)) {
+      Run(queue, task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    while (!stop_ && numQueued_ == 0) {
+      wakeUp_.wait(lock);
+    }
+    if (stop_ && numQueued_ == 0)   return;
+  }
+}
+
+ThreadPool::TaskQueue* ThreadPool::OwnQueue() {
+  if (workerPool == this) {
+    return queues_[workerIndex];
+  } else {
+    return queues_.back();
+  }
+}
+
+void ThreadPool::Push(TaskQueue* queue, const Task& task) {
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->tasks.push_back(task);
+    ++numQueued_;
+  }
+  // Taking 'sleepMutex_' makes sure that a worker either sees the new task
+  // before going to sleep, or is already waiting for the notification.
+  { std::lock_guard<std::mutex> lock(sleepMutex_); }
+  wakeUp_.notify_one();
+}
+
+bool ThreadPool::GetTask(TaskQueue* queue, Task* task) {
+  if (numQueued_ == 0)   return false;
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (!queue->tasks.empty()) {
+      *task = queue->tasks.back();
+      queue->tasks.pop_back();
+      --numQueued_;
+      return true;
+    }
+  }
+  // Steal the oldest (and largest) task of another queue, starting from the
+  // next one to spread the thieves.
+  int n = queues_.size();
+  int start = std::find(queues_.begin(), queues_.end(), queue) -
+      queues_.begin();
+  for (int k = 1; k < n; ++k) {
+    TaskQueue* victim = queues_[(start + k) % n];
+    std::lock_guard<std::mutex> lock(victim->mutex);
+    if (!victim->tasks.empty()) {
+      *task = victim->tasks.front();
+      victim->tasks.pop_front();
+      --numQueued_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::Run(TaskQueue* queue, Task task) {
+  Job* job = task.job;
+  // Split off the upper halves for others to steal, until the range is small
+  // enough.
+  while (task.end - task.begin > job->grainSize) {
+    int mid = task.begin + (task.end - task.begin) / 2;
+    Task upper = {job, mid, task.end};
+    Push(queue, upper);
+    task.end = mid;
+  }
+  (*job->body)(task.begin, task.end);
+  int size = task.end - task.begin;
+  if (job->remaining.fetch_sub(size) == size) {
+    // Wake the thread waiting for the job, if it is blocked. As in 'Push',
+    // taking 'sleepMutex_' makes sure that the notification is not missed. The
+    // job itself may be gone once 'remaining' is zero.
+    { std::lock_guard<std::mutex> lock(sleepMutex_); }
+    wakeUp_.notify_all();
+  }
+}
+
+void ParallelFor(int begin, int end, int grainSize,
+                 const ParallelForBody& body) {
+  ThreadPool::Default().ParallelFor(begin, end, grainSize, body);
+}
+
+void ParallelForOnThreads(int numThreads, int begin, int end, int grainSize,
+                          const ParallelForBody& body) {
+  if (numThreads == 0) {
+    ThreadPool::Default().ParallelFor(begin, end, grainSize, body);
+  } else {
+    // A pool of 1 thread has no workers and runs the loop serially.
+    PoolOfSize(std::max(1, numThreads)).ParallelFor(begin, end, grainSize,
+                                                    body);
+  }
+}
+
+}   // namespace xyUtils
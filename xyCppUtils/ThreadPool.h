@@ -0,0 +1,104 @@
+/**
+  * A work-stealing thread pool with parallel for loops.
+  *
+  * Example usage:
+  *   // On the default pool, with the number of threads given by the command
+  *   // line flag '--num_threads' (0 for all hardware threads).
+  *   ParallelFor(0, N, 16, [&](int begin, int end) {
+  *     for (int i = begin; i < end; ++i)   Process(i);
+  *   });
+  *   // On a pool of its own.
+  *   ThreadPool pool(4);
+  *   pool.ParallelFor(0, N, 1, body);
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#ifndef __XYUTILS_THREAD_POOL_H__
+#define __XYUTILS_THREAD_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xyUtils  {
+
+// The body of a parallel for loop, processing indices in [begin, end).
+typedef std::function<void(int begin, int end)> ParallelForBody;
+
+class ThreadPool {
+ public:
+  // Create a pool running on 'numThreads' threads in total, i.e. the thread
+  // calling 'ParallelFor' is one of them and 'numThreads' - 1 worker threads
+  // are started. Zero means using all the available hardware threads.
+  explicit ThreadPool(int numThreads);
+  // Stop and join the worker threads. No 'ParallelFor' should be running.
+  ~ThreadPool();
+
+  int numThreads() const { return workers_.size() + 1; }
+
+  // Call 'body' on sub-ranges covering [begin, end), each with at most
+  // 'grainSize' indices, and return when all of them are done. The range is
+  // split in halves recursively, and idle threads steal the largest pending
+  // sub-ranges from the others. 'ParallelFor' could be called from within
+  // 'body' (or from several threads at once): a waiting thread keeps running
+  // pending sub-ranges, and only blocks while there are none, so that nested
+  // loops never deadlock.
+  void ParallelFor(int begin, int end, int grainSize,
+                   const ParallelForBody& body);
+
+  // The pool shared by the library, created on first use with the number of
+  // threads given by the command line flag '--num_threads'.
+  static ThreadPool& Default();
+
+ private:
+  struct Job;
+  struct Task {
+    Job* job;
+    int begin;
+    int end;
+  };
+  // A deque of tasks, where the owner pushes and pops at the back, and thieves
+  // steal from the front.
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void WorkerLoop(int index);
+  // Queue of the calling thread, i.e. its own queue for a worker of this pool,
+  // and the shared queue for any other thread.
+  TaskQueue* OwnQueue();
+  void Push(TaskQueue* queue, const Task& task);
+  // Pop a task from 'queue', or steal one from the other queues.
+  bool GetTask(TaskQueue* queue, Task* task);
+  void Run(TaskQueue* queue, Task task);
+
+  std::vector<std::thread> workers_;
+  // One queue per worker, and the last one is shared by the other threads.
+  std::vector<TaskQueue*> queues_;
+  std::atomic<int> numQueued_;
+  std::mutex sleepMutex_;
+  std::condition_variable wakeUp_;
+  bool stop_;
+};
+
+// Same as 'ThreadPool::Default().ParallelFor(begin, end, grainSize, body)'.
+void ParallelFor(int begin, int end, int grainSize,
+                 const ParallelForBody& body);
+
+// Run the parallel for loop on 'numThreads' threads, for functions with a
+// 'numThreads' option: serially on the calling thread if 1, on the default pool
+// if 0, and otherwise on a pool of that size, which is created on the first call
+// and reused by the later ones.
+void ParallelForOnThreads(int numThreads, int begin, int end, int grainSize,
+                          const ParallelForBody& body);
+
+}   // namespace xyUtils
+
+#endif   // __XYUTILS_THREAD_POOL_H__
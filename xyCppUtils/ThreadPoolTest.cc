@@ -0,0 +1,152 @@
+/**
+  * Test for thread pool.
+  *
+  * Author: Ying Xiong.
+  * Created: Oct 18, 2026.
+  */
+
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "LogAndCheck.h"
+#include "Timer.h"
+
+using namespace xyUtils;
+
+namespace {
+// Check that every index in [0, N) has been processed exactly once.
+void CheckAllOnce(const std::vector<std::atomic<int> >& counts) {
+  for (size_t i = 0; i < counts.size(); ++i) {
+    CHECK_EQ(int(counts[i]), 1);
+  }
+}
+}   // namespace
+
+int main()  {
+  Timer timer;
+  LOG(INFO) << "Test on ThreadPool ...";
+
+  ThreadPool pool(4);
+  CHECK_EQ(pool.numThreads(), 4);
+
+  // Every index is processed once, in sub-ranges of at most 'grainSize'.
+  int N = 10000;
+  int grainSizes[] = {1, 7, 100, N, 2*N};
+  for (int g = 0; g < 5; ++g) {
+    std::vector<std::atomic<int> > counts(N);
+    for (int i = 0; i < N; ++i)   counts[i] = 0;
+    std::atomic<bool> grainOk(true);
+    int grainSize = grainSizes[g];
+    pool.ParallelFor(0, N, grainSize, [&](int begin, int end) {
+        if (end - begin > grainSize || begin >= end)   grainOk = false;
+        for (int i = begin; i < end; ++i)   ++counts[i];
+      });
+    CHECK(grainOk);
+    CheckAllOnce(counts);
+  }
+
+  // Empty range and non-zero start.
+  std::atomic<int> sum(0);
+  pool.ParallelFor(5, 5, 1, [&](int, int) { ++sum; });
+  CHECK_EQ(int(sum), 0);
+  pool.ParallelFor(-10, 10, 3, [&](int begin, int end) {
+      for (int i = begin; i < end; ++i)   sum += i;
+    });
+  CHECK_EQ(int(sum), -10);
+
+  // The work is spread over several threads.
+  std::vector<std::thread::id> ids(64);
+  pool.ParallelFor(0, 64, 1, [&](int begin, int) {
+      ids[begin] = std::this_thread::get_id();
+      Timer::sleep(0.002);
+    });
+  int numDistinct = 0;
+  for (int i = 0; i < 64; ++i) {
+    bool seen = false;
+    for (int j = 0; j < i; ++j)   seen = seen || (ids[j] == ids[i]);
+    if (!seen)   ++numDistinct;
+  }
+  CHECK_GT(numDistinct, 1);
+  CHECK_LE(numDistinct, 4);
+
+  // Nested loops do not deadlock.
+  int M = 200;
+  std::vector<std::atomic<int> > nestedCounts(M * M);
+  for (int i = 0; i < M * M; ++i)   nestedCounts[i] = 0;
+  pool.ParallelFor(0, M, 1, [&](int begin, int end) {
+      for (int i = begin; i < end; ++i) {
+        pool.ParallelFor(0, M, 8, [&](int b, int e) {
+            for (int j = b; j < e; ++j)   ++nestedCounts[i*M + j];
+          });
+      }
+    });
+  CheckAllOnce(nestedCounts);
+
+  // Several threads calling the same pool at once.
+  std::vector<std::atomic<int> > sharedCounts(4 * N);
+  for (int i = 0; i < 4 * N; ++i)   sharedCounts[i] = 0;
+  std::vector<std::thread> callers;
+  for (int t = 0; t < 4; ++t) {
+    callers.push_back(std::thread([&, t]() {
+          pool.ParallelFor(t*N, (t+1)*N, 16, [&](int begin, int end) {
+              for (int i = begin; i < end; ++i)   ++sharedCounts[i];
+            });
+        }));
+  }
+  for (int t = 0; t < 4; ++t)   callers[t].join();
+  CheckAllOnce(sharedCounts);
+
+  // A single threaded pool runs serially on the calling thread.
+  ThreadPool serialPool(1);
+  CHECK_EQ(serialPool.numThreads(), 1);
+  std::thread::id caller = std::this_thread::get_id();
+  serialPool.ParallelFor(0, 100, 10, [&](int, int) {
+      CHECK(std::this_thread::get_id() == caller);
+    });
+
+  // The caller blocks, rather than spins, while a worker runs the last range.
+  std::atomic<bool> started(false);
+  clock_t waitStart = 0;
+  pool.ParallelFor(0, 2, 1, [&](int begin, int) {
+      if (begin == 0) {
+        // The caller runs the first range, until a worker has the other.
+        while (!started)   std::this_thread::yield();
+        waitStart = clock();
+      } else {
+        started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      }
+    });
+  double waitCpu = double(clock() - waitStart) / CLOCKS_PER_SEC;
+  CHECK_LT(waitCpu, 0.1);
+
+  // Pools of a given size are kept for later calls.
+  std::set<std::thread::id> poolIds;
+  std::mutex idsMutex;
+  for (int k = 0; k < 10; ++k) {
+    ParallelForOnThreads(3, 0, 64, 1, [&](int, int) {
+        std::lock_guard<std::mutex> lock(idsMutex);
+        poolIds.insert(std::this_thread::get_id());
+      });
+  }
+  CHECK_LE(poolIds.size(), 3u);
+
+  // The default pool.
+  CHECK_GE(ThreadPool::Default().numThreads(), 1);
+  std::vector<std::atomic<int> > defaultCounts(N);
+  for (int i = 0; i < N; ++i)   defaultCounts[i] = 0;
+  ParallelFor(0, N, 64, [&](int begin, int end) {
+      for (int i = begin; i < end; ++i)   ++defaultCounts[i];
+    });
+  CheckAllOnce(defaultCounts);
+
+  LOG(INFO) << "Passed. [" << timer.elapsed() << " seconds]";
+  return 0;
+}
@@ -97,6 +97,7 @@ if __name__ == "__main__":
     objs = [o for o in all_objs if not (set(o[1]) & noLibs)]
     tests = [t for t in all_tests if not (set(t[1]) & noLibs)]
     bins = [b for b in all_bins if not (set(b[1]) & noLibs)]
+    benches = [b for b in all_benches if not (set(b[1]) & noLibs)]
 
     # Head.
     makefile.write(makefile_data_head + "\n")
@@ -107,6 +108,7 @@ if __name__ == "__main__":
     makefile.write("OBJS = " + " ".join([o[0] for o in objs]) + "\n")
     makefile.write("TESTS = " + " ".join([t[0] for t in tests]) + "\n")
     makefile.write("BINS = " + " ".join([b[0] for b in bins]) + "\n")
+    makefile.write("BENCHES = " + " ".join([b[0] for b in benches]) + "\n")
     makefile.write("\n")
     
     # Configurations.
@@ -142,6 +144,18 @@ if __name__ == "__main__":
         makefile.write("\n\n")
     makefile.write("\n")
 
+    # Benchmark files.
+    writeSectionHeader(makefile, "Benchmark files")
+    for b in benches:
+        deps = " ".join([("$(DEPSDIR)/ThirdParty_"+l) for l in b[1]])
+        makefile.write("%s: %s.cc $(LIBxy) %s\n" % (b[0], b[0], deps))
+        makefile.write("\t$(CXX) $(CXXFLAGS) $(DEPSFLAGS) $(DEFS) $(INCLUDES) " + \
+                       "$< -o $@ $(LIBPATH) $(LIBS)")
+        for l in b[1]:
+            makefile.write(" $(LIB" + l + ")")
+        makefile.write("\n\n")
+    makefile.write("\n")
+
     # Binary files.
     writeSectionHeader(makefile, "Binary files")
     for b in bins:
@@ -170,6 +184,14 @@ if __name__ == "__main__":
     makefile.write("\nfulltest: test " + test_third_party)
     makefile.write("\n\n")
 
+    # Run benchmarks.
+    writeSectionHeader(makefile, "Benchmarks")
+    makefile.write("bench: $(BENCHES)\n")
+    makefile.write("\tmkdir -p BenchResults\n")
+    for b in [b[0] for b in benches]:
+        makefile.write("\t./%s --bench_json=BenchResults/%s.json\n" % (b, b))
+    makefile.write("\n")
+
     # Cscope.
     writeSectionHeader(makefile, "Cscope")
     makefile.write(makefile_data_cscope)
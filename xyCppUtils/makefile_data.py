@@ -28,8 +28,13 @@ makefile_data_head = \
 # Usage:
 #        'make RELEASE=1 all'            make the release version.
 #        'make DEBUG=1 target'           make the debug version.
+#        'make PROFILE=1 target'         enable PROFILE_SCOPE (see Profiler.h).
+#        'make MAX_VLOG=n target'        compile out VLOG(m) for m > n (see
+#                                        LogAndCheck.h).
 #        'make MATLAB=1 MATLAB_ROOT=/path/to/matlab RELEASE=1 all'
 #                                        make as a matlab library.
+#        'make RELEASE=1 bench'          build and run the benchmarks, writing
+#                                        the results to BenchResults/*.json.
 #        'make clean'                    removes .o and executable files.
 #        'make fullclean'                also removes the third party libraries.
 #
@@ -49,7 +54,7 @@ CC := %s
 CXX := %s
 
 # Compiler flags.
-CXXFLAGS = -W -Wall -Wextra -Wno-sign-compare %s
+CXXFLAGS = -W -Wall -Wextra -Wno-sign-compare -pthread %s
 
 # Include directories, e.g. "-I../includes".
 INCLUDES = -I.
@@ -83,6 +88,14 @@ ifeq ($(DEBUG), 1)
 	DEFS += -D__DEBUG__
 endif
 
+ifeq ($(PROFILE), 1)
+	DEFS += -D__PROFILE__
+endif
+
+ifdef MAX_VLOG
+	DEFS += -D__MAX_VLOG_LEVEL__=$(MAX_VLOG)
+endif
+
 # Dependencies.
 DEPSDIR := $(shell mkdir -p .deps; echo .deps)
 DEPSFLAGS = -MMD -MF $(DEPSDIR)/$@.d -MP
@@ -93,7 +106,7 @@ DEPSFILES := $(wildcard $(DEPSDIR)/*.d)
 # Arg1 'cc_deps': $(DEPSDIR)/ThirdParty_libname
 makefile_data_build = \
 """# Default target value.
-all: $(LIBxy) $(TESTS) $(BINS)
+all: $(LIBxy) $(TESTS) $(BINS) $(BENCHES)
 
 $(LIBxy): $(OBJS)
 \tar r $@ $^
@@ -149,7 +162,8 @@ cscope_clean:
 
 makefile_data_clean = \
 """clean: cscope_clean
-\trm -f $(LIBxy) $(OBJS) $(TESTS) $(BINS)
+\trm -f $(LIBxy) $(OBJS) $(TESTS) $(BINS) $(BENCHES)
+\trm -rf BenchResults
 \trm -f *.pyc *~ .*~
 \tfind . -name .DS_Store | """ + _xargs_r + """ rm -rf
 
@@ -157,7 +171,7 @@ fullclean: clean %s
 \trm -rf ThirdParty/include ThirdParty/lib ThirdParty/bin ThirdParty/share
 \trm -rf *.dSYM $(DEPSDIR)
 
-.PHONY: all clean fullclean cscope cscope_clean %s
+.PHONY: all bench clean fullclean cscope cscope_clean %s
 """
 
 # Target library file.
@@ -177,38 +191,65 @@ libs = (("jpeg", "-ljpeg"),
 # Object files generated by the project, in the form
 #   ("XXX.o", ("lib1", "lib2",)).
 all_objs = ( \
+    ("Benchmark.o", ()),
     ("Camera.o", ("eigen",)),
     ("CommandLineFlags.o", ()),
     ("EigenUtils.o", ("eigen",)),
     ("FileIO.o", ()),
     ("LogAndCheck.o", ()),
     ("NonlinearLeastSquares.o", ("eigen",)),
+    ("NonlinearMinimization.o", ("eigen",)),
     ("NumericalCheck.o", ("eigen",)),
+    ("NumericalJacobian.o", ("eigen",)),
     ("PlyIO.o", ()),
+    ("Profiler.o", ()),
     ("PointCameraViewer.o", ("sdl",)),
     ("PointEdgeViewer.o", ("sdl",)),
     ("SDLViewer.o", ("sdl",)),
     ("StringConvert.o", ()),
     ("StringUtils.o", ()),
+    ("ThreadPool.o", ()),
 )
 
 # Test binaries generated by the project, in the form
 #   ("XXXTest", ("lib1", "lib2",)).
 all_tests = ( \
+    ("BenchmarkTest", ()),
+    ("CameraTest", ("eigen",)),
     ("CommandLineFlagsTest", ()),
     ("EigenUtilsTest", ("eigen",)),
     ("FileIOTest", ()),
     ("ImageTest", ("jpeg", "png")),
     ("LogAndCheckTest", ()),
     ("NonlinearLeastSquaresTest", ("eigen",)),
+    ("NonlinearMinimizationTest", ("eigen",)),
     ("NumericalCheckTest", ("eigen",)),
+    ("NumericalJacobianTest", ("eigen",)),
     ("PlyIOTest", ()),
     ("PointEdgeViewerTest", ("sdl", "jpeg",)),
+    ("ProfilerTest", ()),
     ("QuaternionTest", ()),
+    ("RandomTest", ()),
     ("StringUtilsTest", ()),
     ("StringConvertTest", ()),
+    ("ThreadPoolTest", ()),
     ("TimerTest", ()),
 )
+
+# Benchmark binaries generated by the project, in the form
+#   ("XXXBench", ("lib1", "lib2",)).
+all_benches = ( \
+    ("CameraBench", ("eigen",)),
+    ("EigenUtilsBench", ("eigen",)),
+    ("FileIOBench", ()),
+    ("ImageBench", ("jpeg", "png")),
+    ("LogAndCheckBench", ()),
+    ("NonlinearLeastSquaresBench", ("eigen",)),
+    ("PlyIOBench", ()),
+    ("StringConvertBench", ()),
+    ("StringUtilsBench", ()),
+)
+
 # Binary files generated by the project, in the form
 #   ("runSomething", ("lib1", "lib2")).
 all_bins = ( \